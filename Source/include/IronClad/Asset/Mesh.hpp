@@ -28,13 +28,14 @@
 #include "IronClad/Utils/Utilities.hpp"
 #include "IronClad/Graphics/Globals.hpp"
 #include "IronClad/Graphics/Surface.hpp"
+#include "IronClad/Graphics/VertexBuffer.hpp"
 #include "AssetManager.hpp"
 #include "Texture.hpp"
 
 namespace ic
 {
     // Forward declaration for future friendship.
-    namespace gfx { class CMeshInstance; class CVertexBuffer; }
+    namespace gfx { class CMeshInstance; }
 
 namespace asset
 {
@@ -62,7 +63,8 @@ namespace asset
     {
     public:
         CMesh(bool orig = false, const void* const own = NULL) :
-            CAsset(orig, own), m_vcount(0), m_icount(0) {}
+            CAsset(orig, own), mp_Resident(NULL), m_Min(0.f, 0.f),
+            m_Max(0.f, 0.f), m_vcount(0), m_icount(0) {}
         ~CMesh();
 
         CMesh& operator=(const CMesh& Copy);
@@ -92,7 +94,8 @@ namespace asset
          *
          * @param   vertex_t*   Raw vertex data
          * @param   uint32_t    Size of vertex data array
-         * @param   uint16_t*   Raw index data
+         * @param   uint16_t*   Raw index data, or uint32_t* for meshes
+         *                      with more than 65536 vertices
          * @param   uint32_t    Size of index data array
          *
          * @return  TRUE if everything went right, 
@@ -100,6 +103,8 @@ namespace asset
          **/
         bool LoadFromRaw(const vertex2_t* pvertices, const uint32_t vsize,
                          const uint16_t*  pindices,   const uint32_t isize);
+        bool LoadFromRaw(const vertex2_t* pvertices, const uint32_t vsize,
+                         const uint32_t*  pindices,   const uint32_t isize);
 
         /**
          * Loads current vertex and index data into given buffers.
@@ -116,35 +121,78 @@ namespace asset
          **/   
         bool Offload(std::vector<vertex2_t>& vbo_buffer,
                      std::vector<uint16_t>&  ibo_buffer);
+
+        /**
+         * Uploads the mesh into its own range of a vertex buffer.
+         *  Only that range is touched, the rest of the buffer stays
+         *  where it is. Offloading a mesh into a buffer it's already
+         *  in does nothing, so instances can share it.
+         *
+         * @param   gfx::CVertexBuffer&     Buffer to upload into
+         *
+         * @return  TRUE if the mesh is in the buffer, FALSE if there's
+         *          no data to upload or the buffer is full.
+         **/
         bool Offload(gfx::CVertexBuffer& VBO);
 
         /**
          * Deletes all surface and buffer data.
+         *  If the mesh was offloaded, its range is given back.
          **/
         void Clear();
 
         /**
-         * Analyzes the mesh and returns the maximum width/height of it.
+         * Returns the maximum width/height of the mesh.
          *  If the mesh is a non-quad, it will return the distance from
-         *  the right-most point to the left-most point.
-         *  If the mesh has been offloaded to the GPU, this will do 
-         *  absolutely nothing.
+         *  the right-most point to the left-most point (or the origin,
+         *  whichever is further out).
+         *  This uses the bounding box cached on loading, so it remains
+         *  valid after the mesh has been offloaded to the GPU.
          *
          * @return  Maximum width/height, zero if no vertex data.
          **/
         int GetMeshWidth()  const;
         int GetMeshHeight() const;
 
+        /**
+         * Retrieves the local-space bounding box of the mesh.
+         *  This is calculated once, on loading.
+         **/
+        inline const math::vector2_t& GetMin() const
+        { return m_Min; }
+
+        inline const math::vector2_t& GetMax() const
+        { return m_Max; }
+
+        /**
+         * Retrieves the local-space outline that shadows are cast from.
+         *  Like the bounds, this is calculated once, on loading.
+         **/
+        inline const std::vector<math::vector2_t>& GetOutline() const
+        { return m_Outline; }
+
         /**
          * Only the CAssetManager and CMeshInstance class can create
          * instances of CMesh assets.
          **/
         friend class CAssetManager;
         friend class gfx::CMeshInstance;
+        friend class gfx::CVertexBuffer;
 
     private:
         void Release();
 
+        /**
+         * Gives the mesh's range back to the buffer it lives in.
+         **/
+        void Evict();
+
+        /**
+         * Calculates the bounding box and shadow outline of the current
+         * vertex data.
+         **/
+        void CalculateBounds();
+
         /**
          * Performs surface optimization, grouping surfaces with
          * identical materials together.
@@ -172,9 +220,15 @@ namespace asset
         std::vector<gfx::surface_t*>    mp_Surfaces;
 
         std::vector<vertex2_t>          m_vBuffer;
-        std::vector<uint16_t>           m_iBuffer;
+        std::vector<uint32_t>           m_iBuffer;
+
+        std::vector<math::vector2_t>    m_Outline;
+
+        gfx::CVertexBuffer*             mp_Resident;
+        gfx::geometry_range_t           m_Range;
 
-        uint32_t    m_vcount, m_icount;
+        math::vector2_t m_Min, m_Max;
+        uint32_t        m_vcount, m_icount;
     };
 
     template<typename T>
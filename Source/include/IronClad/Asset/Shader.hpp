@@ -49,6 +49,18 @@ namespace asset
         bool LoadFromFile(const char* pfilename);
         bool LoadFromFile(const std::string& filename);
 
+        /**
+         * Compiles a shader directly from source code.
+         *  This is used for the engine's built-in shaders, which are
+         *  embedded in the library rather than shipped as files.
+         *
+         * @param   char*   Shader source code
+         * @param   int     Shader type (GL_VERTEX_SHADER, etc.)
+         *
+         * @return  TRUE on successful compilation, FALSE on error.
+         **/
+        bool LoadFromStr(const char* psrc, const int type);
+
         inline uint32_t GetShaderObject() const
         { return m_shader; }
 
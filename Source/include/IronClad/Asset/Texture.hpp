@@ -24,6 +24,7 @@
 
 #include "IronClad/Utils/Utilities.hpp"
 #include "IronClad/Base/Types.hpp"
+#include "IronClad/Graphics/GLState.hpp"
 #include "Asset.hpp"
 
 namespace ic
@@ -66,17 +67,18 @@ namespace asset
 
         /**
          * Binds the texture to the OpenGL state for use.
+         *  This is always the texture's own image, even if it has been
+         *  packed into an atlas, so texture coordinates need no mapping.
+         *  Code that maps them into GetRegion() binds GetTextureID().
          **/
         inline void Bind()
-        {
-            glBindTexture(GL_TEXTURE_2D, m_texture);
-        }
+        { gfx::CGLState::BindTexture(m_standalone ? m_standalone : m_texture); }
 
         /**
          * Unbinds the texture from OpenGL.
          **/
         inline void Unbind()
-        { glBindTexture(GL_TEXTURE_2D, 0); }
+        { gfx::CGLState::BindTexture(0); }
 
         inline uint32_t GetTextureID() const 
         { return m_texture; }
@@ -87,20 +89,58 @@ namespace asset
         inline uint32_t GetH() const
         { return m_height; }
 
+        /**
+         * Determines whether the texture has no alpha channel.
+         *  With depth testing, opaque textures can be drawn in any
+         *  order, so the scene is free to sort them by state rather
+         *  than submission order.
+         **/
+        inline bool IsOpaque() const
+        { return m_opaque; }
+
+        /**
+         * The part of the texture's image this texture covers.
+         *  This is (u, v, width, height) in texture coordinates, and is
+         *  the whole image (0, 0, 1, 1) unless the texture has been
+         *  packed into a CTextureAtlas page.
+         **/
+        inline const float* GetRegion() const
+        { return m_region; }
+
+        /**
+         * Determines whether this texture lives in an atlas page.
+         *  If so, GetTextureID() is the page, which is shared with
+         *  other textures, and texture coordinates must be mapped into
+         *  GetRegion() to sample it. The texture's own image is kept
+         *  for everything else, see Bind().
+         **/
+        inline bool IsAtlased() const
+        { return m_standalone != 0; }
+
         /**
          * Only the CAssetManager class can create CTexture instances.
          **/
         friend class CAssetManager;
+        friend class CTextureAtlas;
 
     private:
         CTexture(bool orig = false, const void* const own = NULL) : 
-            CAsset(orig, own), m_width(0), m_height(0), m_texture(0) {}
+            CAsset(orig, own), m_width(0), m_height(0), m_texture(0),
+            m_standalone(0), m_opaque(false)
+        { m_region[0] = m_region[1] = 0.f; m_region[2] = m_region[3] = 1.f; }
         CTexture(const CTexture& Copy);
 
         void Release();
 
-        uint32_t m_texture;
+        /**
+         * Queries the alpha size of the bound texture to set m_opaque.
+         **/
+        void QueryOpacity();
+
+        uint32_t m_texture, m_standalone;
+        float m_region[4];
         int m_width, m_height;
+        bool m_opaque;
     };
 
 }   // namespace asset
@@ -0,0 +1,115 @@
+/**
+ * @file
+ *  Asset/TextureAtlas.hpp - Declares the CTextureAtlas class, which packs
+ *  small textures into shared pages.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Assets
+ * @{
+ **/
+
+#ifndef IRON_CLAD__ASSETS__TEXTURE_ATLAS_HPP
+#define IRON_CLAD__ASSETS__TEXTURE_ATLAS_HPP
+
+#include <vector>
+
+#include "Texture.hpp"
+
+namespace ic
+{
+namespace asset
+{
+    /**
+     * Packs textures into large shared pages.
+     *  Textures added to the atlas are copied into a page, and from
+     *  then on report the page as their texture and the part of it
+     *  they occupy as their region (see CTexture::GetRegion()). The
+     *  scene's sprite batch maps texture coordinates into the region,
+     *  so sprites on the same page and with the same geometry are
+     *  drawn together, no matter which texture they use.
+     *
+     *  Pages are filled with a skyline packer. Every texture is
+     *  surrounded by a border of its own edge pixels, so that linear
+     *  filtering never bleeds in from the neighbours.
+     *
+     *  Packed textures keep their own image too, which is what
+     *  CTexture::Bind() binds, so anything drawn outside of the batch
+     *  (meshes with several surfaces, custom shaders, fonts, and so on)
+     *  still samples just that texture. Textures copied from a packed
+     *  one before it was packed keep using their own image. The atlas
+     *  must outlive every texture packed into it.
+     **/
+    class IRONCLAD_API CTextureAtlas
+    {
+    public:
+        /**
+         * @param   uint16_t    Width and height of each page
+         *                      (optional=1024)
+         * @param   uint8_t     Border around each texture, in pixels
+         *                      (optional=2)
+         **/
+        CTextureAtlas(const uint16_t size = 1024, const uint8_t padding = 2);
+        ~CTextureAtlas();
+
+        /**
+         * Packs a texture into the first page it fits in, creating a
+         * new page if there's no room.
+         *
+         * @param   CTexture*   Texture to pack
+         *
+         * @return  TRUE if the texture was packed, FALSE if it was
+         *          already packed, or is too big for a page.
+         **/
+        bool Add(CTexture* pTexture);
+
+        inline size_t GetPageCount() const
+        { return m_Pages.size(); }
+
+    private:
+        // One horizontal segment of a page's skyline.
+        struct skyline_t
+        {
+            uint16_t x, y, w;
+        };
+
+        struct page_t
+        {
+            uint32_t                texture;
+            std::vector<skyline_t>  Skyline;
+        };
+
+        /**
+         * Finds the lowest spot in a page that fits a rectangle, and
+         * raises the skyline over it.
+         *
+         * @return  TRUE if it fit.
+         **/
+        bool Fit(page_t& Page, const uint16_t w, const uint16_t h,
+                 uint16_t& x, uint16_t& y) const;
+
+        bool AddPage();
+
+        std::vector<page_t> m_Pages;
+        std::vector<unsigned char> m_pixels, m_padded;
+        uint16_t m_size;
+        uint8_t m_padding;
+    };
+
+}   // namespace asset
+}   // namespace ic
+
+#endif // IRON_CLAD__ASSETS__TEXTURE_ATLAS_HPP
+
+/** @} **/
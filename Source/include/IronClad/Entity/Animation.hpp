@@ -41,6 +41,13 @@ namespace obj
      *  implement correctly.
      *  Another limitation is that all of the animations in the sprite
      *  sheet must be the exact same size.
+     *
+     *  Frames are picked by the sprite batch on the GPU, from the time
+     *  the animation (re)started and its rate, so animations need no
+     *  per-frame work and all of those sharing a sheet are drawn in a
+     *  single call. Animations loaded from the same file share their
+     *  texture and quad, which stay loaded until the asset manager is
+     *  cleaned up.
      *  
      * @todo    Expand animation abilities to non-quad meshes.
      **/
@@ -57,14 +64,15 @@ namespace obj
             gfx::CMeshInstance* pMesh;
         };
 
-        CAnimation() : m_last(util::CTimer::GetTimeElapsed()),
-                       m_delay(1.f), m_loops_done(0) {}
-
-        virtual ~CAnimation()
+        CAnimation() : m_start(util::CTimer::GetTimeElapsed()),
+                       m_delay(1.f), m_first(0), m_enabled(true),
+                       m_loops_done(0)
         {
-            asset::CAssetManager::Destroy(m_SheetDetails.pTexture);
+            memset(&m_SheetDetails, 0, sizeof m_SheetDetails);
         }
 
+        virtual ~CAnimation() {}
+
         /**
          * Load a custom animation file.
          *  This will load an .icanim image file, which internally
@@ -81,10 +89,8 @@ namespace obj
 
         /**
          * Replaces the current texture and dimensions.
-         *  This will pass new texture coordinate offsets to the fragment shader,
-         *  as well as give the renderer a new texture to work with.
-         *  At times, this causes a single frame of texture artifacts, for 
-         *  which the cause is currently unknown.
+         *  The animation carries on from the same frame, wrapped to the
+         *  new sheet.
          * 
          * @param   AnimationHeader Header containing texture / dimension data
          **/
@@ -100,16 +106,15 @@ namespace obj
          *
          * @param   bool    Enable / Disable animation
          **/
-        void EnableAnimation(bool flag)
-        {
-            m_enabled = flag;
-        }
+        void EnableAnimation(bool flag);
 
         /**
          * Sets the rate of animation.
          *  The internal sprites will iterate as this limit is reached.
-         *  It is absolutely essential that you call Update() at the end
-         *  of each frame in order to track this value properly.
+         *  The current frame is kept, so the rate can be changed at
+         *  any time without jumping.
+         *
+         * @param   float   Seconds per frame
          **/
         void SetAnimationRate(const float delta);
 
@@ -127,15 +132,9 @@ namespace obj
          **/
         bool PrevSprite();
 
-        /**
-         * Updates the current time delta value.
-         *  This method will accurately measure time elapsed between 
-         *  texture switches and will switch accordingly if necessary.
-         **/
-        virtual void Update();
+        virtual bool LoadSpriteFrame(float* pFrame) const;
 
-        uint32_t GetLoopCount() const
-        { return m_loops_done; }
+        uint32_t GetLoopCount() const;
 
         uint16_t GetAnimationCount() const 
         { return m_SheetDetails.columns; }
@@ -147,19 +146,30 @@ namespace obj
         { return m_SheetDetails; }
 
         uint8_t GetAnimationIndex() const
-        { return m_active + 1; }
+        { return this->GetFrame() + 1; }
 
         void SetAnimation(const uint8_t index);
 
     protected:
+        /**
+         * Works out the current frame from the time.
+         *
+         * @param   uint32_t*   Loops since m_start (optional=NULL)
+         **/
+        uint8_t GetFrame(uint32_t* pLoops = NULL) const;
+
+        /**
+         * Restarts the clock from the current frame.
+         *  Called before anything about the timing changes.
+         **/
+        void Rebase();
+
         AnimationHeader m_SheetDetails;     // Internal sprite sheet details
-        uint8_t         m_active;           // Currently active sprite
-        float           m_TexcDim;          // Calculated texture width
+        double          m_start;            // When m_first was showing
         float           m_delay;            // Delay between texture swaps
-        float           m_last;             // Time since last Next/PrevSprite() call
+        uint8_t         m_first;            // Sprite showing at m_start
         bool            m_enabled;          // Is animation enabled?
-        int             m_tc_loc, m_tc_str; // Shader uniform locations
-        int             m_loops_done;       // Loops completed
+        uint32_t        m_loops_done;       // Loops completed before m_start
     };
 }
 }
@@ -47,8 +47,9 @@ namespace obj
     class IRONCLAD_API CEntity
     {
     public:
-        CEntity(bool caster = false) : m_render(true), mp_Override(NULL),
-                                       m_static(false) {}
+        CEntity(bool caster = false) : mp_Override(NULL), m_layer(0),
+                                       m_depth(0.f), m_render(true),
+                                       m_static(false), m_caster(caster) {}
         virtual ~CEntity();
 
         inline bool operator==(const std::string& filename) const
@@ -143,6 +144,25 @@ namespace obj
         // Does nothing, but could be implemented in inheriting classes.
         virtual void Update(){}
 
+        /**
+         * Loads the sprite-sheet frame the renderer should show.
+         *  This is (frames, seconds per frame, start time, first frame).
+         *  The sprite batch shows frame (first + (time - start) / delay)
+         *  modulo frames, with time from the "FrameData" block, so
+         *  nothing has to be updated on the CPU as frames go by.
+         *  Plain entities have a single frame.
+         *
+         * @param   float*  Four floats to fill in
+         *
+         * @return  TRUE if the entity is animated.
+         **/
+        virtual bool LoadSpriteFrame(float* pFrame) const
+        {
+            pFrame[0] = 1.f;
+            pFrame[1] = pFrame[2] = pFrame[3] = 0.f;
+            return false;
+        }
+
         /**
          * Enables a texture override over the default.
          *  This will cause the default texture(s) on the mesh to be
@@ -169,12 +189,48 @@ namespace obj
         inline void SetStatic(const bool flag)
         { m_static = flag; }
 
+        /**
+         * Sets whether or not the entity blocks light.
+         *  Shadow casters block point lights when the scene's shadows
+         *  are on (see CScene::ToggleShadows()).
+         **/
+        inline void SetShadowCaster(const bool flag)
+        { m_caster = flag; m_Mesh.Invalidate(); }
+
+        /**
+         * Sets the render layer of the entity.
+         *  Higher layers are always drawn over lower ones, regardless
+         *  of how the scene decides to sort the entities within a layer.
+         **/
+        inline void SetLayer(const uint8_t layer)
+        { m_layer = layer; m_Mesh.Invalidate(); }
+
+        /**
+         * Sets the depth of the entity within its layer.
+         *  Entities with a higher z, from 0 to 1, are drawn over those
+         *  with a lower one. Entities at the same depth are drawn in
+         *  their scene's draw order, see CScene::InsertMesh().
+         *
+         * @param   float   Depth, clamped to [0, 1]
+         **/
+        inline void SetDepth(const float z)
+        { m_depth = math::clamp<float>(z, 0.f, 1.f); m_Mesh.Invalidate(); }
+
+        inline uint8_t GetLayer() const
+        { return m_layer; }
+
+        inline float GetDepth() const
+        { return m_depth; }
+
         inline bool IsRenderable() const
         { return m_render; }
 
         inline bool IsStatic() const 
         { return m_static; }
 
+        inline bool CastsShadow() const
+        { return m_caster; }
+
         inline bool HasOverride() const
         { return mp_Override != NULL; }
 
@@ -203,7 +259,7 @@ namespace obj
         {
             if(axis == IC_X_AXIS) return m_Mesh.GetRotationX();
             if(axis == IC_Y_AXIS) return m_Mesh.GetRotationY();
-            if(axis == IC_Y_AXIS) return m_Mesh.GetRotationZ();
+            if(axis == IC_Z_AXIS) return m_Mesh.GetRotationZ();
             return 0.f;
         }
 
@@ -214,7 +270,7 @@ namespace obj
         { return m_Mesh.GetDimensions().y; }
 
         inline void SetMesh(asset::CMesh* pMesh)
-        { m_Mesh.mp_ActiveMesh = pMesh; }
+        { m_Mesh.LoadMesh(pMesh); }
 
         /// @todo   Bounds checking hehe.
         virtual asset::CTexture* GetTexture() const
@@ -229,7 +285,9 @@ namespace obj
         gfx::CMeshInstance  m_Mesh;
         asset::CTexture*    mp_Override;
 
-        bool m_render, m_static;
+        uint8_t m_layer;
+        float   m_depth;
+        bool m_render, m_static, m_caster;
     };
 }   // namespace obj
 }   // namespace ic
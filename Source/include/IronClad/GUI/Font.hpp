@@ -34,6 +34,7 @@
 #include "IronClad/Base/Types.hpp"
 
 #include "IronClad/Graphics/Vertexbuffer.hpp"
+#include "IronClad/Graphics/StreamBuffer.hpp"
 #include "IronClad/Graphics/Globals.hpp"
 #include "IronClad/Entity/Entity.hpp"
 
@@ -170,7 +171,8 @@ namespace gui
 
         ic::color4f_t       m_Color;
         gfx::CEffect        m_FontRender;
-        gfx::CVertexBuffer  m_VBO, m_Cache;
+        gfx::CStreamBuffer  m_Stream;
+        gfx::CVertexBuffer  m_Cache;
         math::rect_t        m_CacheSize;
 
         FT_Face             m_FontFace;
@@ -237,7 +239,7 @@ namespace gui
         // Copy data from each glyph to the whole string texture.
         uint32_t tex_id = 0;
         glGenTextures(1, &tex_id);
-        glBindTexture(GL_TEXTURE_2D, tex_id);
+        gfx::CGLState::BindTexture(tex_id);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, 
                      GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 
@@ -258,7 +260,7 @@ namespace gui
             offset += allBuffers[i].w;
         }
 
-        glBindTexture(GL_TEXTURE_2D, 0);
+        gfx::CGLState::BindTexture(0);
 
         pTex->LoadFromTexture(tex_id);
         pFinal->SetMaterialOverride(pTex);
@@ -0,0 +1,165 @@
+/**
+ * @file
+ *  Graphics/Batch.hpp - Declares the CSpriteBatch class, which groups
+ *  scene entities sharing geometry and material into instanced draws.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__BATCH_HPP
+#define IRON_CLAD__GRAPHICS__BATCH_HPP
+
+#include <map>
+#include <vector>
+
+#include "IronClad/Base/Types.hpp"
+#include "IronClad/Math/Matrix.hpp"
+#include "IronClad/Entity/Entity.hpp"
+
+#include "VertexBuffer.hpp"
+#include "ShaderPair.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * Per-instance data uploaded for every batched sprite.
+     *  (linear, x, y) is the instance's world transformation, as
+     *  given by CMeshInstance::GetWorldTransform(): the 2x2 rotation,
+     *  flip and scale, column by column, followed by the position.
+     *  z is the depth the sprite is drawn at, see CScene.
+     *  (u, v, tw, th) is the region of the texture the sprite samples,
+     *  see asset::CTexture::GetRegion().
+     *  The rest picks a sprite from a sheet within that region, see
+     *  obj::CEntity::LoadSpriteFrame().
+     **/
+    struct IRONCLAD_API instance_t
+    {
+        float linear[4];
+        float x, y, z;
+        float u, v;
+        float tw, th;
+        float frames, delay;
+        float start, first;
+    };
+
+    /**
+     * Collects sprites and draws them with instanced rendering.
+     *  Entities that have a single surface and use the default shader
+     *  are grouped by their texture and index range in the geometry
+     *  buffer. Each group is then drawn with a single call to
+     *  glDrawElementsInstanced(), reading per-instance transforms from
+     *  a buffer that is re-uploaded once per flush.
+     *
+     *  Textures packed into a CTextureAtlas report their page as
+     *  their texture, so sprites that share geometry and a page end up
+     *  in one group, even when they use different textures.
+     *
+     *  Animated sprites pick their current frame in the vertex shader,
+     *  so they batch like any other sprite.
+     *
+     *  Groups are drawn in the order they first appeared since the
+     *  last flush, so sprites with differing materials that overlap
+     *  may be drawn in a different order than they were added.
+     **/
+    class IRONCLAD_API CSpriteBatch
+    {
+    public:
+        CSpriteBatch();
+        ~CSpriteBatch();
+
+        /**
+         * Creates the instance buffer and compiles the batch shader.
+         *
+         * @return  TRUE on success, FALSE if instancing is unavailable
+         *          or the built-in shader failed to compile.
+         **/
+        bool Init();
+
+        /**
+         * Queues an entity for batched rendering.
+         *  Entities with multiple surfaces, no material, or a custom
+         *  shader cannot be batched; the caller must render these itself.
+         *
+         * @param   obj::CEntity*   Entity to batch
+         * @param   bool            Are we rendering wire-frames?
+         * @param   float           Model-view z to draw at (optional=0)
+         *
+         * @return  TRUE if the entity was queued, FALSE if not batchable.
+         **/
+        bool Add(obj::CEntity* pEntity, const bool wire, const float z = 0.f);
+
+        /**
+         * Draws all queued instances and empties the batch.
+         *  Does nothing if the batch is empty.
+         *
+         * @param   CVertexBuffer&  Geometry buffer the entities live in
+         * @param   uint32_t        Primitive type (GL_TRIANGLES, ...)
+         *
+         * @pre     The geometry buffer must be bound.
+         * @pre     The projection and camera come from the "FrameData"
+         *          uniform block, so the frame's CUniformBuffer must
+         *          be up to date.
+         * @return  The number of draw calls issued.
+         **/
+        uint32_t Flush(CVertexBuffer& Geometry, const uint32_t geo_type);
+
+        inline bool Empty() const
+        { return m_order.empty(); }
+
+    private:
+        /**
+         * Identifies a unique batch: texture and geometry range.
+         **/
+        struct batch_key_t
+        {
+            uint32_t texture;
+            uint32_t start;
+            uint32_t base;
+            uint32_t icount;
+
+            bool operator<(const batch_key_t& Other) const
+            {
+                if(texture != Other.texture) return texture < Other.texture;
+                if(start   != Other.start)   return start   < Other.start;
+                if(base    != Other.base)    return base    < Other.base;
+                return icount < Other.icount;
+            }
+        };
+
+        struct batch_t
+        {
+            batch_key_t             Key;
+            std::vector<instance_t> instances;
+        };
+
+        CShaderPair                         m_Shader;
+        std::map<batch_key_t, uint32_t>     m_batchIndex;
+        std::vector<batch_t>                m_Batches;
+        std::vector<uint32_t>               m_order;
+        std::vector<instance_t>             m_packed;
+
+        uint32_t    m_instance_vbo;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__BATCH_HPP
+
+/** @} **/
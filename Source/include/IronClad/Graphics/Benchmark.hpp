@@ -0,0 +1,160 @@
+/**
+ * @file
+ *  Graphics/Benchmark.hpp - Declares the CBenchmark class, which renders
+ *  generated scenes and measures how long they take.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__BENCHMARK_HPP
+#define IRON_CLAD__GRAPHICS__BENCHMARK_HPP
+
+#include <ostream>
+
+#include "Scene.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * What to put in a generated scene, and how long to render it.
+     **/
+    struct IRONCLAD_API benchmark_config_t
+    {
+        benchmark_config_t() : pname("default"), seed(1), frames(300),
+            warmup(30), entities(1000), materials(8),
+            meshes_per_material(4), spread(1.f), moving(0.1f),
+            baked(false), ambient_lights(1), directional_lights(0), point_lights(8),
+            effects(0), streamed_meshes(0), text_lines(0), pfont(NULL),
+            font_size(16) {}
+
+        const char* pname;              // Label in the output
+        uint32_t    seed;               // Same seed, same scene
+        uint32_t    frames;             // Frames measured
+        uint32_t    warmup;             // Frames rendered first, unmeasured
+
+        uint32_t    entities;           // Sprites in the scene
+        uint16_t    materials;          // Textures, odd ones translucent
+        uint16_t    meshes_per_material;// Shapes, each a bit more complex
+        float       spread;             // Scene size, in screens
+        float       moving;             // Share of entities moved per frame
+        bool        baked;              // IC_STATIC_SCENE, baking entities
+
+        uint16_t    ambient_lights;
+        uint16_t    directional_lights;
+        uint16_t    point_lights;
+        uint8_t     effects;            // Post-processing chain length
+
+        uint32_t    streamed_meshes;    // Quads re-uploaded per frame
+        uint16_t    text_lines;         // Lines of text drawn per frame
+        const char* pfont;              // Font for the text, if any
+        uint16_t    font_size;
+    };
+
+    /**
+     * Measurements from a CBenchmark run. Times are in milliseconds,
+     * everything else is averaged per frame.
+     **/
+    struct IRONCLAD_API benchmark_result_t
+    {
+        double      setup_ms;           // Building the scene
+        double      render_p50, render_p90, render_p99, render_max;
+        double      render_mean;        // CPU time in CScene::Render()
+        double      frame_mean;         // Whole frames, waiting for the GPU
+        double      text_mean;          // CFont::RenderText()
+        double      stream_mean;        // CVertexBuffer uploads
+
+        double      draw_calls, program_binds, texture_binds;
+        double      triangles, bytes_uploaded, culled_entities;
+        double      redundant_calls;
+        double      gpu_time[IC_TIMER_COUNT];
+
+        uint32_t    frames;
+        uint16_t    lights, effects;    // How many actually loaded
+    };
+
+    /**
+     * Renders generated scenes through the public API and measures
+     * them, so changes to the renderer can be compared run to run.
+     *  Everything random comes from the configured seed, so a config
+     *  always produces the same scene. The scene is rendered to the
+     *  given window, which is best a CHeadlessWindow, so results don't
+     *  depend on the display or v-sync:
+     *
+     *      gfx::CHeadlessWindow Window;
+     *      Window.Create(1280, 720);
+     *      gfx::Globals::Init(Window);
+     *
+     *      gfx::benchmark_config_t Config;
+     *      Config.entities = 5000;
+     *
+     *      gfx::benchmark_result_t Result;
+     *      gfx::CBenchmark Bench(Window);
+     *      if(Bench.Run(Config, Result))
+     *          gfx::CBenchmark::Write(std::cout, Config, Result);
+     *
+     *  Lights and most effects load their shaders from the Shaders/
+     *  directory, and are left out of the scene if they can't be.
+     **/
+    class IRONCLAD_API CBenchmark
+    {
+    public:
+        CBenchmark(CWindow& Window);
+        ~CBenchmark();
+
+        /**
+         * Builds the scene, renders it, and tears it down again.
+         *
+         * @param   benchmark_config_t& What to render
+         * @param   benchmark_result_t& Where to put the measurements
+         *
+         * @return  FALSE if the scene couldn't be built.
+         **/
+        bool Run(const benchmark_config_t& Config,
+                 benchmark_result_t& Result);
+
+        /**
+         * Writes a run as a single line of JSON, so runs can be
+         * appended to one file and compared later.
+         **/
+        static void Write(std::ostream& out,
+                          const benchmark_config_t& Config,
+                          const benchmark_result_t& Result);
+
+    private:
+        bool Build(const benchmark_config_t& Config, CScene& Scene);
+        void Release(CScene& Scene);
+
+        // xorshift32, so results don't depend on the C library.
+        uint32_t Random();
+        float    Random(const float lo, const float hi);
+
+        CWindow&                        m_Window;
+        std::vector<asset::CTexture*>   mp_Textures;
+        std::vector<asset::CMesh*>      mp_Meshes;
+        std::vector<obj::CEntity*>      mp_Entities;
+        std::vector<CLight*>            mp_Lights;
+        std::vector<CEffect*>           mp_Effects;
+        uint32_t                        m_state;
+    };
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__BENCHMARK_HPP
+
+/** @} **/
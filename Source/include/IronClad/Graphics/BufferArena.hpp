@@ -0,0 +1,147 @@
+/**
+ * @file
+ *  Graphics/BufferArena.hpp - Declares the CBufferArena class, which
+ *  sub-allocates ranges of a single growable OpenGL buffer.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__BUFFER_ARENA_HPP
+#define IRON_CLAD__GRAPHICS__BUFFER_ARENA_HPP
+
+#include <vector>
+
+#include "GL/glew.h"
+
+#include "IronClad/Base/Types.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A growable GPU buffer that hands out ranges of fixed-size elements.
+     *  Ranges are found first-fit in a free list of released ranges,
+     *  falling back to the end of the buffer. When the buffer is full,
+     *  its capacity is doubled and the old contents are copied over on
+     *  the GPU, so nothing ever has to be read back.
+     *
+     *  Growing creates a new buffer object, so anything that holds on
+     *  to the handle (such as a VAO) must check GetBuffer() afterwards.
+     *
+     *  All uploads go through the GL_COPY_WRITE_BUFFER target, so the
+     *  arena never disturbs the currently bound VAO.
+     **/
+    class IRONCLAD_API CBufferArena
+    {
+    public:
+        CBufferArena();
+        ~CBufferArena();
+
+        /**
+         * Creates the buffer handle.
+         *  No storage is allocated until the first call to Allocate().
+         *
+         * @param   uint32_t    Size of a single element, in bytes
+         * @param   uint16_t    Buffer usage (GL_STATIC_DRAW, ...)
+         *
+         * @return  TRUE on success, FALSE on lack of function pointer.
+         **/
+        bool Init(const uint32_t stride, const uint16_t usage);
+
+        /**
+         * Reserves a range of elements in the buffer.
+         *  The buffer grows if there's no room for the range.
+         *
+         * @param   uint32_t    Number of elements
+         * @param   uint32_t&   Index of the first element is stored here
+         *
+         * @return  TRUE on success, FALSE if the buffer couldn't grow.
+         **/
+        bool Allocate(const uint32_t count, uint32_t& start);
+
+        /**
+         * Returns a range to the arena for re-use.
+         *  The contents are left untouched.
+         **/
+        void Free(const uint32_t start, const uint32_t count);
+
+        /**
+         * Copies data into part of the buffer.
+         *
+         * @param   uint32_t    Index of the first element
+         * @param   uint32_t    Number of elements
+         * @param   void*       Element data
+         **/
+        void Upload(const uint32_t start, const uint32_t count,
+                    const void* pdata);
+
+        /**
+         * Forgets every allocation.
+         *  The storage is orphaned, rather than shrunk, so the next
+         *  frame's data doesn't have to wait on draws from this one.
+         **/
+        void Clear();
+
+        /**
+         * Deletes the buffer.
+         **/
+        void Release();
+
+        inline void SetUsage(const uint16_t usage)
+        { m_usage = usage; }
+
+        inline uint32_t GetBuffer() const
+        { return m_buffer; }
+
+        /**
+         * Number of elements the buffer can hold before growing.
+         **/
+        inline uint32_t GetCapacity() const
+        { return m_capacity; }
+
+        /**
+         * One past the last element in use, including freed ranges
+         * that have yet to be re-used.
+         **/
+        inline uint32_t GetUsed() const
+        { return m_tail; }
+
+    private:
+        struct block_t
+        {
+            uint32_t start, count;
+        };
+
+        /**
+         * Doubles the capacity until it fits the given element count,
+         * copying the current contents into the new buffer.
+         **/
+        bool Grow(const uint32_t min_capacity);
+
+        std::vector<block_t> m_freeList;    // Sorted by start, coalesced
+
+        uint32_t m_buffer, m_stride, m_capacity, m_tail;
+        uint16_t m_usage;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__BUFFER_ARENA_HPP
+
+/** @} **/
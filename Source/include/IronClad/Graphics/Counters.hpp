@@ -0,0 +1,53 @@
+/**
+ * @file
+ *  Graphics/Counters.hpp - Running totals of the work handed to OpenGL.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__COUNTERS_HPP
+#define IRON_CLAD__GRAPHICS__COUNTERS_HPP
+
+#include "IronClad/Base/Types.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * Counts binds, triangles, and uploads as they happen.
+     *  The wrappers that do the work bump these, and CScene resets
+     *  them at the start of every frame and copies them into its
+     *  statistics at the end (see CScene::GetStats()).
+     **/
+    struct IRONCLAD_API Counters
+    {
+        static void Reset();
+
+        static uint32_t program_binds;      // Programs actually bound
+        static uint32_t texture_binds;      // Textures actually bound
+        static uint32_t triangles;          // Geometry indices / 3
+        static uint32_t bytes_uploaded;     // Buffer data sent to the GPU
+        static uint32_t redundant_calls;    // Changes skipped by CGLState
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__COUNTERS_HPP
+
+/** @} **/
@@ -23,9 +23,8 @@
 #ifndef IRON_CLAD__GRAPHICS__EFFECT_HPP
 #define IRON_CLAD__GRAPHICS__EFFECT_HPP
 
-#include <map>
-
 #include "ShaderPair.hpp"
+#include "RenderTargetPool.hpp"
 
 namespace ic
 {
@@ -43,17 +42,100 @@ namespace gfx
         IC_GRAYSCALE,
         IC_FADE,
         IC_RIPPLE,
+        IC_DUAL_BLUR,       // Built-in, see CEffect::SetLevels()
         IC_EFFECT_COUNT
     };
 
+    /**
+     * A full-screen post-processing effect.
+     *  Most effects are a single pass over the scene, but they can be
+     *  rendered at a fraction of the screen resolution to save fill
+     *  rate, and are upscaled (bilinearly) by whatever reads them next.
+     *
+     *  IC_DUAL_BLUR is built in, and replaces the separate horizontal
+     *  and vertical Gaussian passes. It repeatedly halves the image
+     *  while blurring, then doubles it back up while blurring again,
+     *  so every pass after the first runs at a quarter of the pixels.
+     *
+     *  IC_GRAYSCALE and IC_FADE are built in as well. They only read
+     *  their own pixel, so a scene fuses runs of them into a single
+     *  shader (see CEffectChain) rather than a pass each.
+     **/
     class IRONCLAD_API CEffect
     {
     public:
+        static const uint8_t MAX_FUSED = 16;
+
         CEffect();
         ~CEffect(){}
 
         bool Init(const EffectType type);
 
+        /**
+         * Renders the effect.
+         *  The full-screen VBO must be bound.
+         *
+         * @param   CRenderTargetPool&  Targets are borrowed from here
+         * @param   uint32_t            Texture to apply the effect to
+         * @param   uint16_t            Screen width
+         * @param   uint16_t            Screen height
+         *
+         * @return  The target holding the result, which the caller must
+         *          give back to the pool. NULL on error.
+         **/
+        CFrameBuffer* Render(CRenderTargetPool& Pool, const uint32_t source,
+                             const uint16_t w, const uint16_t h);
+
+        /**
+         * Sets the resolution the effect renders at.
+         *
+         * @param   float   Fraction of the screen, i.e. 0.5 or 0.25
+         **/
+        inline void SetScale(const float scale)
+        { m_scale = math::clamp<float>(scale, 0.0625f, 1.f); }
+
+        /**
+         * Sets how many times IC_DUAL_BLUR halves the image.
+         *  More levels give a wider blur for very little extra cost.
+         **/
+        inline void SetLevels(const uint8_t levels)
+        { m_levels = math::clamp<uint8_t>(levels, 1, 6); }
+
+        inline float GetScale() const
+        { return m_scale; }
+
+        inline EffectType GetType() const
+        { return m_type; }
+
+        /**
+         * Does the effect only read the pixel it writes?
+         *  Such effects can be fused with their neighbours.
+         **/
+        inline bool IsPerPixel() const
+        { return mp_pixel != NULL; }
+
+        /**
+         * Retrieves the four parameters of a per-pixel effect.
+         **/
+        inline const float* GetParams() const
+        { return m_params; }
+
+        /**
+         * Builds a program that applies a run of per-pixel effects.
+         *  The effects' parameters go in a "params" vec4 array, in the
+         *  same order as the effects.
+         *
+         * @param   CShaderPair&    Program to load into
+         * @param   CEffect**       Effects, in the order they apply
+         * @param   size_t          Number of effects, up to MAX_FUSED
+         *
+         * @return  TRUE if built, FALSE if an effect isn't per-pixel or
+         *          compilation failed.
+         **/
+        static bool LoadPixelProgram(CShaderPair& Program,
+                                     const CEffect* const* ppEffects,
+                                     const size_t count);
+
         /**
          * Sets an effect parameter.
          *  The parameter name *MUST* match the variable name in the
@@ -95,9 +177,25 @@ namespace gfx
     private:
         int GetLocation(const char* pvar);
 
+        /**
+         * Draws the full-screen quad from one texture into a target.
+         **/
+        void Pass(CFrameBuffer* pTarget, const uint32_t source);
+
+        CFrameBuffer* BlurRender(CRenderTargetPool& Pool,
+                                 const uint32_t source,
+                                 const uint16_t w, const uint16_t h);
+
         gfx::CShaderPair m_Effect;
+        gfx::CShaderPair m_Upsample;    // IC_DUAL_BLUR only
+
+        EffectType  m_type;
+        float       m_scale;
+        uint8_t     m_levels;
 
-        std::map<uint32_t, uint32_t> m_UniformHash;
+        const char* mp_pixel;       // Per-pixel function body, if any
+        float       m_params[4];
+        int         m_paramloc;
     };
 
     class CFadeEffect
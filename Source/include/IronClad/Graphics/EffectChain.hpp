@@ -0,0 +1,122 @@
+/**
+ * @file
+ *  Graphics/EffectChain.hpp - Declares the CEffectChain class, which
+ *  runs a list of post-processing effects, fusing where it can.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__EFFECT_CHAIN_HPP
+#define IRON_CLAD__GRAPHICS__EFFECT_CHAIN_HPP
+
+#include <vector>
+#include <map>
+#include <string>
+
+#include "IronClad/Base/Types.hpp"
+#include "RenderTargetPool.hpp"
+#include "Effect.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * Runs a scene's post-processing effects.
+     *  Consecutive per-pixel effects (see CEffect::IsPerPixel()) are
+     *  fused into one generated program, compiled the first time that
+     *  exact sequence of effects is seen and cached from then on. A
+     *  run at the very end of the chain isn't drawn off-screen at all,
+     *  but applied while copying to the screen in Present().
+     *
+     *  Every frame goes:
+     *
+     *      texture = Chain.Render(Effects, texture, Pool, w, h);
+     *      // Bind the screen.
+     *      Chain.Present(texture);
+     *      Chain.Finish();
+     **/
+    class IRONCLAD_API CEffectChain
+    {
+    public:
+        CEffectChain();
+        ~CEffectChain();
+
+        /**
+         * Renders the effects that can't be deferred to Present().
+         *  The full-screen VBO must be bound.
+         *
+         * @param   std::vector<CEffect*>&  Effects, in order
+         * @param   uint32_t                Texture with the scene
+         * @param   CRenderTargetPool&      Targets are borrowed from here
+         * @param   uint16_t                Screen width
+         * @param   uint16_t                Screen height
+         *
+         * @return  The texture to present.
+         **/
+        uint32_t Render(const std::vector<CEffect*>& Effects,
+                        const uint32_t source, CRenderTargetPool& Pool,
+                        const uint16_t w, const uint16_t h);
+
+        /**
+         * Draws a texture to the active frame-buffer, applying any
+         * per-pixel effects left at the end of the chain on the way.
+         *  The full-screen VBO must be bound.
+         **/
+        void Present(const uint32_t texture);
+
+        /**
+         * Gives the last target back to the pool and forgets the
+         * effects waiting for Present().
+         **/
+        void Finish();
+
+        /**
+         * Deletes every cached program.
+         **/
+        void Clear();
+
+        /**
+         * Number of fused programs that have been built.
+         **/
+        inline size_t GetProgramCount() const
+        { return m_Programs.size(); }
+
+    private:
+        /**
+         * Finds or builds the program for a run of per-pixel effects,
+         * and binds it with the effects' current parameters.
+         *
+         * @return  The program, or NULL if it failed to compile.
+         **/
+        CShaderPair* UseProgram(const CEffect* const* ppEffects,
+                                const size_t count);
+
+        std::map<std::string, CShaderPair*> m_Programs;
+        std::vector<const CEffect*>         mp_Tail;
+        std::vector<float>                  m_params;
+
+        CRenderTargetPool*  mp_Pool;
+        CFrameBuffer*       mp_Last;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__EFFECT_CHAIN_HPP
+
+/** @} **/
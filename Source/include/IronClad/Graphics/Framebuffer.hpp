@@ -48,12 +48,14 @@ namespace gfx
          *  
          * @param   int     Width of  requested frame buffer
          * @param   int     Height of requested frame buffer
+         * @param   bool    Attach a depth buffer? (optional=true)
          * 
          * @return  TRUE if frame-buffer and components were created
          *          and attached successfully, 
          *          FALSE on any error.
          **/
-        bool Init(const uint16_t width, const uint16_t height);
+        bool Init(const uint16_t width, const uint16_t height,
+                  const bool depth = true);
 
         /**
          * Clears the frame-buffer.
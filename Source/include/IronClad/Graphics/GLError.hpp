@@ -0,0 +1,143 @@
+/**
+ * @file
+ *  Graphics/GLError.hpp - Declares the CGLError class, which decides how
+ *  (and whether) OpenGL errors are checked for.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__GL_ERROR_HPP
+#define IRON_CLAD__GRAPHICS__GL_ERROR_HPP
+
+#include "GL/glew.h"
+
+#include "IronClad/Base/Types.hpp"
+
+/**
+ * Checks for errors made by the GL calls just before it, according to
+ * the current policy. Evaluates to the first error found, which is
+ * always GL_NO_ERROR unless the policy is IC_GL_ERRORS_SYNC.
+ *
+ *      glTexImage2D(...);
+ *      IC_GL_CHECK();
+ **/
+#define IC_GL_CHECK() ic::gfx::CGLError::Check(__FILE__, __LINE__)
+
+// GLEW undefines APIENTRY once it's done with it.
+#ifdef _WIN32
+  #define IC_GL_CALLBACK __stdcall
+#else
+  #define IC_GL_CALLBACK
+#endif // _WIN32
+
+namespace ic
+{
+namespace gfx
+{
+    /// How OpenGL errors are caught.
+    enum GLErrorPolicy
+    {
+        IC_GL_ERRORS_OFF,   ///< Never ask the driver
+        IC_GL_ERRORS_ASYNC, ///< Have the driver report them (KHR_debug)
+        IC_GL_ERRORS_SYNC   ///< glGetError() at every check
+    };
+
+    /**
+     * Decides how OpenGL errors are checked for.
+     *  glGetError() is a round trip to the driver on many platforms,
+     *  which stalls the pipeline, so the engine never calls it in the
+     *  render path directly. Instead, call sites use IC_GL_CHECK(),
+     *  which does nothing when errors are off, nothing but report
+     *  what the driver's debug callback has sent in asynchronous mode,
+     *  and a full glGetError() loop, logging where each error was
+     *  caught, in synchronous mode.
+     *
+     *  Synchronous mode is the default in debug builds and errors are
+     *  off in release; define IC_GL_ERROR_POLICY to pick another
+     *  default. Asynchronous mode falls back to being off if neither
+     *  KHR_debug nor ARB_debug_output is available. Drivers are only
+     *  required to report anything to contexts created for debugging,
+     *  so windows ask for one unless errors are off.
+     *
+     *  Resource creation, which has to know whether it worked, uses
+     *  Query(), which asks the driver regardless of the policy.
+     **/
+    class IRONCLAD_API CGLError
+    {
+    public:
+        /**
+         * Sets the policy.
+         *  Takes effect immediately if there's a context, otherwise
+         *  once a window calls Init().
+         **/
+        static void SetPolicy(const GLErrorPolicy policy);
+
+        /**
+         * Applies the policy to a newly-created context.
+         *  Called by windows after loading OpenGL functions. Any
+         *  errors left over from context creation are discarded.
+         **/
+        static void Init();
+
+        /**
+         * Checks for errors according to the policy.
+         *  Use IC_GL_CHECK() rather than calling this directly.
+         *
+         * @return  The first error found, GL_NO_ERROR if there wasn't
+         *          one or the policy doesn't allow looking.
+         **/
+        static uint32_t Check(const char* pfile, const int line);
+
+        /**
+         * Asks the driver for errors, regardless of policy.
+         *  Only for paths that aren't run every frame, such as
+         *  resource creation. Errors are logged with the given
+         *  location.
+         *
+         * @return  The first error found, or GL_NO_ERROR.
+         **/
+        static uint32_t Query(const char* pwhere);
+
+        /// Human-readable name of an error code.
+        static const char* GetErrorString(const uint32_t error);
+
+        inline static GLErrorPolicy GetPolicy()
+        { return s_policy; }
+
+        /// Number of errors caught since starting.
+        inline static uint32_t GetErrorCount()
+        { return s_errors; }
+
+    private:
+        static void Apply();
+        static void IC_GL_CALLBACK DebugCallback(GLenum source, GLenum type,
+                                                 GLuint id,
+                                                 GLenum severity,
+                                                 GLsizei length,
+                                                 const GLchar* pmessage,
+                                                 GLvoid* puser);
+
+        static GLErrorPolicy s_policy;
+        static uint32_t      s_errors;
+        static bool          s_ready;
+    };
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__GL_ERROR_HPP
+
+/** @} **/
@@ -0,0 +1,105 @@
+/**
+ * @file
+ *  Graphics/GLState.hpp - Declares the CGLState class, which keeps track
+ *  of bound OpenGL state to skip redundant changes.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__GL_STATE_HPP
+#define IRON_CLAD__GRAPHICS__GL_STATE_HPP
+
+#include "GL/glew.h"
+
+#include "IronClad/Base/Types.hpp"
+#include "Counters.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A cache of the bound program, textures, vertex array, frame-buffer,
+     * blending, depth testing, and view-port.
+     *  Every change the engine makes to these goes through here, and
+     *  is dropped if it wouldn't change anything; the number dropped is
+     *  kept in Counters::redundant_calls. Anything changing this state
+     *  behind the cache's back (such as another library sharing the
+     *  context) must call Invalidate() afterwards.
+     *
+     *  Deleting a bound object unbinds it, and its name may be reused,
+     *  so deleting anything tracked here must go through the Forget*()
+     *  methods as well.
+     **/
+    class IRONCLAD_API CGLState
+    {
+    public:
+        static const uint8_t MAX_UNITS = 8;
+
+        static void UseProgram(const uint32_t program);
+        static void BindVertexArray(const uint32_t vao);
+        static void BindFramebuffer(const uint32_t fbo);
+
+        /**
+         * Binds a 2D texture to a texture unit.
+         *  Only switches the active unit if it has to, so code binding
+         *  a texture to edit it should always come through here too.
+         *  Units past MAX_UNITS aren't tracked and are always bound.
+         **/
+        static void BindTexture(const uint32_t texture,
+                                const uint8_t unit = 0);
+
+        static void EnableBlending(const bool flag);
+        static void BlendFunc(const uint32_t src, const uint32_t dst);
+        static void BlendFuncSeparate(const uint32_t src_rgb,
+                                      const uint32_t dst_rgb,
+                                      const uint32_t src_alpha,
+                                      const uint32_t dst_alpha);
+
+        static void EnableDepthTest(const bool flag);
+        static void DepthMask(const bool flag);
+
+        static void Viewport(const int x, const int y,
+                             const int w, const int h);
+
+        static void ForgetProgram(const uint32_t program);
+        static void ForgetTexture(const uint32_t texture);
+        static void ForgetVertexArray(const uint32_t vao);
+        static void ForgetFramebuffer(const uint32_t fbo);
+
+        /**
+         * Forgets everything, so the next change of each kind always
+         * goes through. Needed for every new context.
+         **/
+        static void Invalidate();
+
+    private:
+        CGLState();
+
+        static uint32_t s_program, s_vao, s_fbo, s_unit;
+        static uint32_t s_textures[MAX_UNITS];
+        static uint32_t s_blend, s_blend_func[4];
+        static uint32_t s_depth, s_depth_mask;
+        static int      s_viewport[4];
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__GL_STATE_HPP
+
+/** @} **/
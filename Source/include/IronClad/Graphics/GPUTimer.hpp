@@ -0,0 +1,94 @@
+/**
+ * @file
+ *  Graphics/GPUTimer.hpp - Declares the CGPUTimer class, which measures
+ *  how long the GPU spends on parts of a frame.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__GPU_TIMER_HPP
+#define IRON_CLAD__GRAPHICS__GPU_TIMER_HPP
+
+#include "GL/glew.h"
+
+#include "IronClad/Base/Types.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * Asynchronous GPU timing with timestamp queries.
+     *  Every timer records a timestamp when it begins and ends, so
+     *  timers may nest or overlap. Queries are kept for LATENCY frames
+     *  before being read, and are skipped rather than waited on if the
+     *  GPU still hasn't caught up, so timing never stalls the pipeline.
+     *
+     *      Timer.BeginFrame();
+     *      Timer.Begin(0);
+     *      // Draw things.
+     *      Timer.End(0);
+     *
+     *      float ms = Timer.GetTime(0);    // From a few frames ago.
+     **/
+    class IRONCLAD_API CGPUTimer
+    {
+    public:
+        static const uint8_t MAX_TIMERS = 8;
+        static const uint8_t LATENCY    = 4;
+
+        CGPUTimer();
+        ~CGPUTimer();
+
+        /**
+         * Creates the queries.
+         *
+         * @return  FALSE if timestamp queries aren't supported.
+         **/
+        bool Init();
+
+        /**
+         * Collects whatever finished from LATENCY frames ago, and
+         * starts recording a new frame.
+         **/
+        void BeginFrame();
+
+        void Begin(const uint8_t timer);
+        void End(const uint8_t timer);
+
+        /**
+         * GPU time of a timer, in milliseconds.
+         *  This is from the last frame that could be read back, and is
+         *  zero if the timer didn't run that frame.
+         **/
+        inline float GetTime(const uint8_t timer) const
+        { return m_times[timer]; }
+
+    private:
+        uint32_t    m_queries[LATENCY][MAX_TIMERS * 2];
+        bool        m_issued[LATENCY][MAX_TIMERS];
+        float       m_times[MAX_TIMERS];
+        uint8_t     m_frame;
+        bool        m_ok;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__GPU_TIMER_HPP
+
+/** @} **/
@@ -0,0 +1,114 @@
+/**
+ * @file
+ *  Graphics/HeadlessWindow.hpp - Declares the CHeadlessWindow class, an
+ *  OpenGL context without a window.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__HEADLESS_WINDOW_HPP
+#define IRON_CLAD__GRAPHICS__HEADLESS_WINDOW_HPP
+
+#include "Window.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * An off-screen OpenGL context, for machines without a display.
+     *  The context is created through EGL, preferring Mesa's surfaceless
+     *  platform, so it works on build machines with nothing but a
+     *  software rasterizer such as llvmpipe. The "screen" is a
+     *  frame-buffer of the window's size (see CWindow::GetScreenBuffer()),
+     *  and can be read back after rendering.
+     *
+     *  It stands in for a CWindow everywhere, so the usual set-up works:
+     *
+     *      gfx::CHeadlessWindow Window;
+     *      Window.Create(800, 600);
+     *      gfx::Globals::Init(Window);
+     *
+     *      gfx::CScene Scene(Window, gfx::IC_STATIC_SCENE);
+     *      Scene.Init();
+     *      Scene.Render();
+     *      Window.Update();
+     *      Window.ReadFrame(pixels);
+     *
+     *  Only available where EGL is (Linux), Create() fails elsewhere.
+     **/
+    class IRONCLAD_API CHeadlessWindow : public CWindow
+    {
+    public:
+        CHeadlessWindow();
+        ~CHeadlessWindow();
+
+        /**
+         * Creates the context and the frame-buffer standing in for the
+         * screen, and loads the OpenGL functions.
+         *
+         * @param   uint16_t    Frame width     (optional=800)
+         * @param   uint16_t    Frame height    (optional=600)
+         * @param   char*       Ignored, there's nothing to title
+         *
+         * @return TRUE on successful creation, FALSE on error.
+         **/
+        bool Create(const uint16_t  width   = 800,
+                    const uint16_t  height  = 600,
+                    const char*     ptitle  = "OpenGL Window");
+
+        /**
+         * Ends the frame. Nothing is shown, so this just waits for the
+         * GPU to finish it.
+         **/
+        void Update();
+
+        /**
+         * Copies the last frame out of the frame-buffer.
+         *
+         * @param   uint8_t*    GetW() * GetH() RGBA pixels, top row first
+         *
+         * @return  TRUE if the pixels were read, FALSE otherwise.
+         **/
+        bool ReadFrame(uint8_t* pPixels) const;
+
+        /**
+         * Writes the last frame to an uncompressed .tga file, for
+         * comparing against reference images.
+         *
+         * @return  TRUE if the file was written, FALSE otherwise.
+         **/
+        bool SaveFrame(const char* pfilename) const;
+
+        void Destroy();
+
+    private:
+        bool CreateContext();
+
+        // EGL handles, kept opaque so EGL stays out of the header.
+        void*       mp_display;
+        void*       mp_context;
+        void*       mp_surface;
+
+        uint32_t    m_fbo, m_color, m_depth;
+    };
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__HEADLESS_WINDOW_HPP
+
+/** @} **/
@@ -24,6 +24,7 @@
 #define IRON_CLAD__GRAPHICS__LIGHT_HPP
 
 #include "IronClad/Base/Types.hpp"
+#include "IronClad/Math/Shapes.hpp"
 #include "Window.hpp"
 #include "ShaderPair.hpp"
 
@@ -55,7 +56,8 @@ namespace gfx
     {
     public:
         CLight() : m_brt(.5f), m_Att(.05f, .01f, 0.f),
-                   m_type(IC_NO_LIGHT) {}
+                   m_type(IC_NO_LIGHT), m_max_angle(360.f),
+                   m_min_angle(0.f), m_angled(false) {}
 
         bool Init(const LightType type, const CWindow& Window);
         bool Init(const gfx::LightType type, const uint16_t h, 
@@ -85,6 +87,36 @@ namespace gfx
 
         LightType               GetType() const         { return m_type; }
 
+        float   GetMaximumAngle() const { return m_max_angle; }
+        float   GetMinimumAngle() const { return m_min_angle; }
+        bool    IsAngled() const        { return m_angled;    }
+
+        /**
+         * Calculates how far the light reaches.
+         *  This is the distance at which brt / (c + l*d + q*d^2)
+         *  drops below the cutoff, i.e. stops visibly changing a pixel.
+         *
+         * @param   float   Smallest visible intensity (optional=1/256)
+         * @return  The radius, or a negative value if it never falls off.
+         **/
+        float GetRadius(const float cutoff = 1.f / 256.f) const;
+
+        /**
+         * Calculates the area the light can affect.
+         *  For point lights this is the box around the radius, for
+         *  directional lights it's the box around the cone swept
+         *  counter-clockwise from the minimum to the maximum angle.
+         *  The rectangle is in the same space as the light position.
+         *
+         * @param   math::rect_t&   The bounds are stored here
+         * @param   float           Smallest visible intensity
+         *
+         * @return  TRUE if the light is bounded, FALSE if it can reach
+         *          the whole screen (ambient lights, no attenuation).
+         **/
+        bool GetInfluence(math::rect_t& Bounds,
+                          const float cutoff = 1.f / 256.f) const;
+
     private:
         CShaderPair     m_Shader;
 
@@ -96,6 +128,8 @@ namespace gfx
         LightType       m_type;
 
         float           m_brt;
+        float           m_max_angle, m_min_angle;   // In degrees
+        bool            m_angled;
 
         // Uniform locations.
         int m_brtloc, m_colloc, m_attloc, m_posloc;
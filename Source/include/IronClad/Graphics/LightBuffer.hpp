@@ -0,0 +1,139 @@
+/**
+ * @file
+ *  Graphics/LightBuffer.hpp - Declares the CLightBuffer class, which
+ *  shades a scene with all of its lights in a single pass.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__LIGHT_BUFFER_HPP
+#define IRON_CLAD__GRAPHICS__LIGHT_BUFFER_HPP
+
+#include "IronClad/Base/Types.hpp"
+#include "UniformBuffer.hpp"
+#include "ShaderPair.hpp"
+#include "Light.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A single light, as the lighting shader sees it (std140).
+     **/
+    struct IRONCLAD_API light_data_t
+    {
+        float pos[2];       // Top-down, without the camera offset
+        float type;         // LightType
+        float brt;
+        float color[4];     // RGB, alpha is unused
+        float att[4];       // Constant, linear, quadratic, radius
+        float cone[4];      // Minimum angle, sweep (radians), angled, shadowed
+    };
+
+    /**
+     * The whole "LightData" uniform block.
+     *  The header holds the light count and the screen size, which
+     *  is needed to flip gl_FragCoord into the same space as positions.
+     **/
+    struct IRONCLAD_API light_block_t
+    {
+        float           info[4];    // Count, screen height, width, unused
+        light_data_t    lights[64];
+    };
+
+    /**
+     * Shades the scene with every light at once.
+     *  Lights are packed into a uniform buffer once per frame, and a
+     *  single full-screen pass loops over all of them per pixel. The
+     *  camera offset comes from the per-frame block, so moving the
+     *  camera doesn't touch the light data at all.
+     *
+     *  The result matches drawing every light additively in its own
+     *  pass, which is what CScene does when this is disabled.
+     *
+     *  Shadowed point lights read their row of a CShadowMap, which
+     *  must be bound to texture unit 1.
+     *
+     *  Usage, with the scene texture bound and a full-screen quad:
+     *
+     *      Lights.Clear(w, h);
+     *      for(...) if(!Lights.Add(pLight)) break;
+     *      Lights.Update();
+     *      Lights.Enable();
+     *      // Draw the quad.
+     *      Lights.Disable();
+     **/
+    class IRONCLAD_API CLightBuffer
+    {
+    public:
+        static const uint8_t MAX_LIGHTS = 64;
+
+        CLightBuffer();
+        ~CLightBuffer();
+
+        /**
+         * Creates the uniform buffer and compiles the lighting shader.
+         *  The shader reads the "FrameData" block, so the scene's
+         *  per-frame buffer must be initialized as well.
+         *
+         * @return  TRUE on success, FALSE if unsupported.
+         **/
+        bool Init();
+
+        /**
+         * Removes all of the lights from the buffer.
+         *
+         * @param   uint16_t    Screen width, in pixels
+         * @param   uint16_t    Screen height, in pixels
+         **/
+        void Clear(const uint16_t w, const uint16_t h);
+
+        /**
+         * Packs a light into the buffer.
+         *
+         * @param   CLight*     Light to add
+         * @param   bool        Use the shadow map? Point lights only
+         *
+         * @return  TRUE if added, FALSE if the buffer is full.
+         **/
+        bool Add(const CLight* pLight, const bool shadowed = false);
+
+        /**
+         * Uploads the packed lights to the GPU.
+         **/
+        void Update();
+
+        void Enable();
+        void Disable();
+
+        inline uint32_t GetCount() const
+        { return m_count; }
+
+    private:
+        CUniformBuffer  m_UBO;
+        CShaderPair     m_Shader;
+        light_block_t   m_Block;
+        uint32_t        m_count;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__LIGHT_BUFFER_HPP
+
+/** @} **/
@@ -33,6 +33,9 @@ namespace ic
 
 namespace gfx
 {
+    class CVisibilityGrid;
+    class CStaticGeometry;
+
     /**
      * An instance of a vertex mesh. 
      *  This class merely contains a pointer to the CMesh it uses,
@@ -46,8 +49,14 @@ namespace gfx
     {
     public:
         CMeshInstance();
-        ~CMeshInstance() {}
+        ~CMeshInstance();
 
+        /**
+         * Copies the instance, but not what it's attached to.
+         *  The copy isn't in any CVisibilityGrid or CStaticGeometry,
+         *  so destroying it leaves the original attached.
+         **/
+        CMeshInstance(const CMeshInstance& Copy);
         CMeshInstance& operator=(const CMeshInstance& Copy);
 
         /**
@@ -74,85 +83,57 @@ namespace gfx
 
         /**
          * Moves the mesh instance.
+         *  If the instance is tracked by a CVisibilityGrid, it is
+         *  updated as well.
+         *  
          * @param   math::vector2_t&    Position to move to
          **/
-        void Move(const math::vector2_t& Pos)
-        {
-            m_Position.x = Pos.x;
-            m_Position.y = Pos.y;
-        }
+        void Move(const math::vector2_t& Pos);
 
         /**
          * Rotates the mesh instance.
+         *  Rotations about the X and Y axes tilt the mesh away from
+         *  the screen, which foreshortens it, since there is no depth.
+         *  Rotations are applied about the instance origin, in X, Y,
+         *  Z order.
+         *
          * @param   float   Degrees to rotate
          **/
-        void RotateX(float degrees)
-        {
-            while(degrees > 360.f)  degrees -= 360.f;
-            while(degrees < 0.f)    degrees += 360.f;
+        void RotateX(const float degrees);
+        void RotateY(const float degrees);  ///< @see RotateX()
+        void RotateZ(const float degrees);  ///< @see RotateX()
 
-            m_degrees[0]  = degrees;
-            m_RotationX.x = cos(math::rad(degrees));
-            m_RotationX.y = sin(math::rad(degrees));
-        }
+        bool VFlip();
+        bool HFlip();
 
         /**
-         * Rotates the mesh instance.
-         * @param   float   Degrees to rotate
+         * Scales the mesh instance about its origin.
+         * @param   math::vector2_t&    Scale on each axis
          **/
-        void RotateY(float degrees)
-        {
-            while(degrees > 360.f)  degrees -= 360.f;
-            while(degrees < 0.f)    degrees += 360.f;
-
-            m_degrees[1]  = degrees;
-            m_RotationY.x = cos(math::rad(degrees));
-            m_RotationY.y = sin(math::rad(degrees));
-        }
+        void Scale(const math::vector2_t& Factor);
 
         /**
-         * Rotates the mesh instance.
-         * @param   float   Degrees to rotate
+         * Gets the instance's world transformation.
+         *  Position, rotation, flipping and scale are combined into a
+         *  2x3 matrix, which is only rebuilt when one of them changes,
+         *  so instances that don't move cost nothing to draw again.
          **/
-        void RotateZ(float degrees)
-        {
-            while(degrees > 360.f)  degrees -= 360.f;
-            while(degrees < 0.f)    degrees += 360.f;
-
-            m_degrees[1]  = degrees;
-            m_RotationZ.x = cos(math::rad(degrees));
-            m_RotationZ.y = sin(math::rad(degrees));
-        }
-
-        bool VFlip()
+        inline const math::affine2x3_t& GetWorldTransform() const
         {
-            return (m_vflip = !m_vflip);
-        }
-
-        bool HFlip()
-        {
-            return (m_hflip = !m_hflip);
+            if(m_dirty) this->UpdateWorldTransform();
+            return m_World;
         }
 
         /**
          * Loads instance position data into an existing model-view matrix.
-         *  The old system used to have each CMeshInstance contain its own
-         *  model-view matrix, and simply do a call to GetPositionMatrix(),
-         *  but that was a serious waste of RAM. Now, the CScene using this
-         *  instance just provides a single matrix and the position is
-         *  loaded into it. Each CMeshInstance now stores 2 floats for
-         *  position instead of 16. That's a savings of 56 bytes ;)
+         *  The CScene using this instance provides a single matrix for
+         *  every instance, and the world transformation is loaded into
+         *  it.
          * 
          * @param   math::matrix4x4_t&  Model-view matrix to load into
          **/
-        inline void LoadPositionMatrix(math::matrix4x4_t& MVMatrix)
-        {
-            MVMatrix[1][1] = m_vflip ? -1.f : 1.f;
-            MVMatrix[0][0] = m_hflip ? -1.f : 1.f;
-
-            MVMatrix[0][3] =  m_Position.x;
-            MVMatrix[1][3] =  m_Position.y;
-        }
+        inline void LoadPositionMatrix(math::matrix4x4_t& MVMatrix) const
+        { MVMatrix.LoadAffine(this->GetWorldTransform()); }
 
         inline std::vector<gfx::surface_t*>& GetSurfaces() const
         { return mp_ActiveMesh->mp_Surfaces; }
@@ -160,6 +141,9 @@ namespace gfx
         inline const math::vector2_t& GetPosition() const
         { return m_Position; }
 
+        inline const std::vector<math::vector2_t>& GetOutline() const
+        { return mp_ActiveMesh->GetOutline(); }
+
         inline float GetRotationX() const
         { return m_degrees[0]; }
 
@@ -172,25 +156,64 @@ namespace gfx
         inline const math::vector2_t& GetDimensions() const
         { return m_Dimensions; }
 
+        inline bool IsVFlipped() const
+        { return m_vflip; }
+
+        inline bool IsHFlipped() const
+        { return m_hflip; }
+
+        inline const math::vector2_t& GetScale() const
+        { return m_Scale; }
+
+        /**
+         * Calculates the world-space bounding box of the instance.
+         *  This uses the mesh's cached bounds, transformed by the
+         *  instance's world transformation.
+         *
+         * @param   vector2_t&  Top-left corner is stored here
+         * @param   vector2_t&  Bottom-right corner is stored here
+         **/
+        void GetWorldBounds(math::vector2_t& Min, math::vector2_t& Max) const;
+
         inline void ClearMesh()
         { mp_ActiveMesh->Clear(); }
 
         inline void SetSceneOwner(const void* const scene)
         { mp_scene_ptr = scene; }
 
+        /// Is the instance drawn as part of a CStaticGeometry chunk?
+        inline bool IsBaked() const
+        { return mp_Static != NULL; }
+
         friend class obj::CEntity;
+        friend class CVisibilityGrid;
+        friend class CStaticGeometry;
 
     private:
+        void Rotate(const uint8_t axis, float degrees);
+        void UpdateWorldTransform() const;
+
+        /// Something the world transformation depends on has changed.
+        void Invalidate();
+
         asset::CMesh*       mp_ActiveMesh;
         math::vector2_t     m_Position;
         math::vector2_t     m_Dimensions;
+        math::vector2_t     m_Scale;
         math::vector2_t     m_RotationX;
         math::vector2_t     m_RotationY;
         math::vector2_t     m_RotationZ;
         float               m_degrees[3];
         bool                m_vflip, m_hflip;
 
+        mutable math::affine2x3_t   m_World;
+        mutable bool                m_dirty;
+
         const void*         mp_scene_ptr;
+        CVisibilityGrid*    mp_Grid;
+        int32_t             m_proxy;
+        CStaticGeometry*    mp_Static;
+        int32_t             m_static_id;
     };
 
 }   // namespace gfx
@@ -0,0 +1,179 @@
+/**
+ * @file
+ *  Graphics/RenderGraph.hpp - Declares the CRenderGraph class, which
+ *  orders a frame's passes and hands out their render targets.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__RENDER_GRAPH_HPP
+#define IRON_CLAD__GRAPHICS__RENDER_GRAPH_HPP
+
+#include <vector>
+
+#include "IronClad/Base/Types.hpp"
+#include "RenderTargetPool.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A tiny per-frame render graph.
+     *  Every pass writes one resource and reads up to MAX_INPUTS of
+     *  them. Resources are either the screen, or transient full-size
+     *  targets that only exist while some pass still needs them.
+     *
+     *  Compile() walks back from the screen and culls every pass whose
+     *  output nobody reads, so a disabled stage costs neither its
+     *  target nor its clear. Targets are borrowed from a pool at their
+     *  first use and given back after their last, so resources whose
+     *  lifetimes don't overlap end up sharing the same memory.
+     *
+     *  The graph doesn't own any rendering code, passes are just IDs:
+     *
+     *      Graph.Reset(Pool, w, h);
+     *      uint8_t color = Graph.AddTarget();
+     *      Graph.AddPass(DRAW, color, &Black);
+     *      Graph.Read(Graph.AddPass(BLIT, CRenderGraph::SCREEN), color);
+     *      Graph.Compile();
+     *
+     *      uint32_t id;
+     *      while(Graph.Begin(id))
+     *      {
+     *          // Draw whatever pass 'id' is.
+     *          Graph.End();
+     *      }
+     **/
+    class IRONCLAD_API CRenderGraph
+    {
+    public:
+        static const uint8_t SCREEN     = 0;
+        static const uint8_t MAX_INPUTS = 4;
+
+        CRenderGraph();
+        ~CRenderGraph();
+
+        /**
+         * Forgets last frame's passes and resources.
+         *
+         * @param   CRenderTargetPool&  Targets are borrowed from here
+         * @param   uint16_t            Target width
+         * @param   uint16_t            Target height
+         **/
+        void Reset(CRenderTargetPool& Pool,
+                   const uint16_t w, const uint16_t h);
+
+        /**
+         * Declares a transient, screen-sized color target.
+         *
+         * @param   bool    Does it need a depth buffer? (optional=false)
+         *
+         * @return  A handle to the target.
+         **/
+        uint8_t AddTarget(const bool depth = false);
+
+        /**
+         * Declares a pass.
+         *  Passes run in the order they are added.
+         *
+         * @param   uint32_t    ID returned by Begin() for this pass
+         * @param   uint8_t     Resource the pass renders to
+         * @param   color4f_t*  Clear the output to this (optional=NULL)
+         *
+         * @return  A handle to the pass.
+         **/
+        uint8_t AddPass(const uint32_t id, const uint8_t output,
+                        const color4f_t* pClear = NULL);
+
+        /**
+         * Declares that a pass samples a resource.
+         **/
+        void Read(const uint8_t pass, const uint8_t resource);
+
+        /**
+         * Culls unused passes and works out target lifetimes.
+         **/
+        void Compile();
+
+        /**
+         * Moves to the next live pass, binding and clearing its output.
+         *
+         * @param   uint32_t&   Set to the pass's ID
+         *
+         * @return  FALSE once every pass has run.
+         **/
+        bool Begin(uint32_t& id);
+
+        /**
+         * Re-binds the current pass's output.
+         *  Only needed if the pass rendered somewhere else first.
+         **/
+        void Enable();
+
+        /**
+         * Finishes the current pass, giving back any targets that no
+         * later pass uses.
+         **/
+        void End();
+
+        /**
+         * Texture of a target, only valid while it's alive.
+         *
+         * @return  The texture, or 0 for the screen or dead targets.
+         **/
+        uint32_t GetTexture(const uint8_t resource) const;
+
+        inline uint32_t GetCulledCount() const
+        { return m_culled; }
+
+    private:
+        struct pass_t
+        {
+            uint32_t    id;
+            color4f_t   Clear;
+            uint8_t     output;
+            uint8_t     inputs[MAX_INPUTS];
+            uint8_t     count;
+            bool        clear, live;
+        };
+
+        struct resource_t
+        {
+            CFrameBuffer*   pTarget;
+            int             first, last;
+            bool            depth;
+            bool            needed;
+        };
+
+        void Release();
+
+        std::vector<pass_t>     m_Passes;
+        std::vector<resource_t> m_Resources;
+
+        CRenderTargetPool*  mp_Pool;
+        uint16_t            m_w, m_h;
+        size_t              m_current;
+        uint32_t            m_culled;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__RENDER_GRAPH_HPP
+
+/** @} **/
@@ -0,0 +1,203 @@
+/**
+ * @file
+ *  Graphics/RenderQueue.hpp - Declares the CRenderQueue class, which
+ *  orders scene surfaces by a packed sort key before submission.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__RENDER_QUEUE_HPP
+#define IRON_CLAD__GRAPHICS__RENDER_QUEUE_HPP
+
+#include <vector>
+
+#include "IronClad/Base/Types.hpp"
+#include "IronClad/Entity/Entity.hpp"
+#include "Surface.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A single surface waiting to be drawn.
+     **/
+    struct IRONCLAD_API render_item_t
+    {
+        uint64_t        key;            // Packed sort key, see CRenderQueue.
+        obj::CEntity*   pEntity;        // Entity the surface belongs to.
+        surface_t*      pSurface;       // Surface to draw.
+        uint32_t        program;        // Program that will be bound.
+        uint32_t        texture;        // Texture that will be bound.
+        float           depth;          // Place in draw order, 1 is last.
+        bool            translucent;    // Does it need blending?
+    };
+
+    /**
+     * A per-frame queue of surfaces, sorted to minimize state changes.
+     *  Surfaces are drawn in order of their entity's layer, then its
+     *  z within the layer (see obj::CEntity::SetDepth()), and then its
+     *  draw order in the scene, so ordering an entity never means
+     *  moving it around in a container.
+     *
+     *  Whatever is drawn last is on top, so nothing that might overlap
+     *  can be reordered. Every surface pushed gets a 64-bit key laid
+     *  out as follows:
+     *
+     *      [63..56] layer  [55..40] z  [31..0] order
+     *
+     *  Surfaces with the same key, such as those of one entity, stay
+     *  in submission order.
+     *
+     *  Without depth testing, the sorted queue is then cut into runs of
+     *  up to MAX_RUN entity surfaces whose world bounds don't overlap,
+     *  and each run is sorted by program, texture and geometry, since
+     *  their order can't show. Surfaces without an entity have no
+     *  bounds and always stay put. Only consecutive surfaces that
+     *  share a texture and geometry may then be batched together, see
+     *  StartsGroup().
+     *
+     *  With depth testing (see SetDepthTested()), each surface is given
+     *  a depth from its place in that order, so no two share one and
+     *  the depth test hides exactly what drawing in order would. The
+     *  queue is then sorted again by a second key:
+     *
+     *      opaque:      [62..47] program  [46..31] texture  [30..0] ~rank
+     *      translucent: [63] 1            [31..0] rank
+     *
+     *  Opaque surfaces come first, grouped by state and front to back
+     *  within a group, so the depth test rejects whatever they cover
+     *  before it's shaded; batches may span all of them. Translucent
+     *  surfaces follow in draw order, without writing depth.
+     *
+     *  The queue is sorted with an LSD radix sort, which is stable and
+     *  skips any byte that is identical across all keys.
+     **/
+    class IRONCLAD_API CRenderQueue
+    {
+    public:
+        static const uint16_t MAX_RUN = 64;
+
+        CRenderQueue();
+        ~CRenderQueue();
+
+        /**
+         * Empties the queue, keeping its memory around for next frame.
+         **/
+        void Clear();
+
+        /**
+         * Adds a surface to the queue.
+         *
+         * @param   obj::CEntity*   Entity owning the surface
+         * @param   surface_t*      Surface to draw
+         * @param   uint32_t        Program the surface uses (0 = default)
+         * @param   uint32_t        Texture the surface uses
+         * @param   bool            Does the surface need blending?
+         * @param   uint32_t        Entity's draw order in the scene
+         **/
+        void Push(obj::CEntity* pEntity, surface_t* pSurface,
+                  const uint32_t program, const uint32_t texture,
+                  const bool translucent, const uint32_t order);
+
+        /**
+         * Adds a surface that belongs to no entity.
+         *  Used for geometry already in world space, such as the
+         *  chunks of a CStaticGeometry. The item's entity is NULL,
+         *  and it goes under any entity at the same layer and z.
+         *
+         * @param   uint8_t     Layer to draw the surface in
+         **/
+        void Push(const uint8_t layer, const float z, surface_t* pSurface,
+                  const uint32_t program, const uint32_t texture,
+                  const bool translucent);
+
+        /**
+         * Picks how the queue is sorted, see above.
+         *  Takes effect on the next Sort().
+         **/
+        inline void SetDepthTested(const bool flag)
+        { m_depth_tested = flag; }
+
+        inline bool IsDepthTested() const
+        { return m_depth_tested; }
+
+        /**
+         * Must a sorted item be drawn after everything before it?
+         *  Batches of sprites must not span such an item. Without depth
+         *  testing, this is any item that isn't the same sprite as the
+         *  one before it. With it, opaque surfaces never need to be, and
+         *  translucent ones at every change of layer or z.
+         **/
+        bool StartsGroup(const size_t i) const;
+
+        /**
+         * Sorts the queue by key.
+         *  After sorting, the state change counts and each item's depth
+         *  become valid.
+         **/
+        void Sort();
+
+        inline size_t Size() const
+        { return m_Items.size(); }
+
+        inline const render_item_t& operator[](const size_t i) const
+        { return m_Items[i]; }
+
+        /**
+         * Program and texture changes that would occur when drawing
+         * the queue in submission order and sorted order, respectively.
+         **/
+        inline uint32_t GetUnsortedChanges() const
+        { return m_unsorted_changes; }
+
+        inline uint32_t GetSortedChanges() const
+        { return m_sorted_changes; }
+
+        static uint64_t MakeKey(const uint8_t layer, const uint16_t z,
+                                const uint32_t order);
+
+        static uint64_t MakeDepthKey(const uint32_t rank,
+                                     const bool translucent,
+                                     const uint32_t program,
+                                     const uint32_t texture);
+
+    private:
+        struct bounds_t
+        {
+            math::vector2_t Min, Max;
+            bool            valid;
+        };
+
+        void RadixSort();
+        void SortRuns();
+        static uint32_t CountChanges(const std::vector<render_item_t>& Items);
+
+        std::vector<render_item_t>  m_Items;
+        std::vector<render_item_t>  m_Swap;
+        std::vector<bounds_t>       m_Bounds;
+
+        uint32_t    m_unsorted_changes, m_sorted_changes;
+        bool        m_depth_tested;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__RENDER_QUEUE_HPP
+
+/** @} **/
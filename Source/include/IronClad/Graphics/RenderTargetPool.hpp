@@ -0,0 +1,96 @@
+/**
+ * @file
+ *  Graphics/RenderTargetPool.hpp - Declares the CRenderTargetPool class,
+ *  which recycles off-screen frame-buffers between passes.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__RENDER_TARGET_POOL_HPP
+#define IRON_CLAD__GRAPHICS__RENDER_TARGET_POOL_HPP
+
+#include <vector>
+
+#include "IronClad/Base/Types.hpp"
+#include "Framebuffer.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A pool of frame-buffers, recycled by size.
+     *  Post-processing passes borrow a target, render into it, and
+     *  give it back once the next pass has read from it. Targets are
+     *  only ever created when no free one of the right size exists,
+     *  so after the first frame a chain of effects allocates nothing.
+     *
+     *  Targets are color-only unless asked for depth, which only the
+     *  scene's geometry needs. Borrowed targets are not cleared.
+     **/
+    class IRONCLAD_API CRenderTargetPool
+    {
+    public:
+        CRenderTargetPool() {}
+        ~CRenderTargetPool();
+
+        /**
+         * Borrows a target of the given size, creating it if needed.
+         *
+         * @param   uint16_t    Width
+         * @param   uint16_t    Height
+         * @param   bool        Does it need a depth buffer? (optional=false)
+         *
+         * @return  The target, or NULL if it couldn't be created.
+         **/
+        CFrameBuffer* Acquire(const uint16_t w, const uint16_t h,
+                              const bool depth = false);
+
+        /**
+         * Gives a borrowed target back to the pool.
+         **/
+        void Release(const CFrameBuffer* pTarget);
+
+        /**
+         * Deletes every target, borrowed or not.
+         **/
+        void Clear();
+
+        /**
+         * Number of targets the pool has created.
+         **/
+        inline size_t GetSize() const
+        { return m_Targets.size(); }
+
+    private:
+        struct target_t
+        {
+            CFrameBuffer*   pTarget;
+            uint16_t        w, h;
+            bool            depth;
+            bool            used;
+        };
+
+        std::vector<target_t> m_Targets;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__RENDER_TARGET_POOL_HPP
+
+/** @} **/
@@ -24,6 +24,8 @@
 #define IRON_CLAD__GRAPHICS__SCENE_HPP
 
 #include <vector>
+#include <map>
+#include <fstream>
 
 #include "IronClad/Math/Line2.hpp"
 
@@ -33,10 +35,21 @@
 
 #include "Globals.hpp"
 #include "Framebuffer.hpp"
+#include "Batch.hpp"
+#include "RenderQueue.hpp"
+#include "Visibility.hpp"
+#include "StaticGeometry.hpp"
+#include "UniformBuffer.hpp"
+#include "LightBuffer.hpp"
+#include "ShadowMap.hpp"
 #include "MeshInstance.hpp"
 #include "Material.hpp"
 #include "Light.hpp"
 #include "Effect.hpp"
+#include "EffectChain.hpp"
+#include "RenderGraph.hpp"
+#include "GPUTimer.hpp"
+#include "Counters.hpp"
 
 namespace ic
 {
@@ -58,6 +71,56 @@ namespace gfx
         IC_STATIC_SCENE
     };
 
+    /**
+     * Parts of the frame timed on the GPU when profiling.
+     *  Lighting includes the shadow map, if it was built.
+     **/
+    enum SceneTimer
+    {
+        IC_GEOMETRY_TIMER,
+        IC_SHADOW_TIMER,
+        IC_LIGHTING_TIMER,
+        IC_POSTFX_TIMER,
+        IC_PRESENT_TIMER,
+        IC_TIMER_COUNT
+    };
+
+    /**
+     * Per-frame statistics gathered by CScene::Render().
+     **/
+    struct IRONCLAD_API scene_stats_t
+    {
+        scene_stats_t() : draw_calls(0), queued_surfaces(0),
+            culled_entities(0), culled_lights(0), shadow_rebuilds(0),
+            state_changes(0), state_changes_saved(0), culled_passes(0),
+            render_targets(0), program_binds(0), texture_binds(0),
+            triangles(0), bytes_uploaded(0), redundant_calls(0),
+            static_draws(0)
+        {
+            for(uint8_t i = 0; i < IC_TIMER_COUNT; ++i) gpu_time[i] = 0.f;
+        }
+
+        uint32_t    draw_calls;             // Geometry draw calls issued
+        uint32_t    queued_surfaces;        // Surfaces in the render queue
+        uint32_t    culled_entities;        // Entities outside the camera
+        uint32_t    culled_lights;          // Lights that reach no pixels
+        uint32_t    shadow_rebuilds;        // Cached shadows that moved
+        uint32_t    state_changes;          // Program/texture changes, sorted
+        int32_t     state_changes_saved;    // Changes avoided by sorting
+        uint32_t    culled_passes;          // Render passes nobody needed
+        uint32_t    render_targets;         // Off-screen targets allocated
+        uint32_t    program_binds;          // Shader programs bound
+        uint32_t    texture_binds;          // Textures bound
+        uint32_t    triangles;              // Triangles submitted
+        uint32_t    bytes_uploaded;         // Buffer data sent to the GPU
+        uint32_t    redundant_calls;        // State changes skipped
+        uint32_t    static_draws;           // Baked chunk pieces queued
+
+        // Milliseconds per SceneTimer, a few frames old. Only filled in
+        // when profiling (see CScene::ToggleProfiling()).
+        float       gpu_time[IC_TIMER_COUNT];
+    };
+
     /**
      * A collection of various graphical elements that interact together.
      *  A scene is the high-level rendering interface in IronClad, taking
@@ -84,8 +147,10 @@ namespace gfx
          *  instances loaded a single time at the creation of the scene
          *  (before any calls to CScene::Render()) simply pass IC_STATIC_SCENE
          *  on creation. 
-         *  All these flags really do is hint to the VBO how often it should
-         *  expect to have vertex data added to the buffer.
+         *  These flags hint to the VBO how often it should expect to have
+         *  vertex data added to the buffer. A static scene also bakes
+         *  every entity that can be baked (see CStaticGeometry), while
+         *  other scenes only bake entities marked with SetStatic().
          *
          * @param   CWindow&    Current window, for projection matrix
          * @param   SceneType   How often will the scene be changed?
@@ -103,6 +168,18 @@ namespace gfx
          **/
         bool Init();
 
+        /**
+         * Uses 32-bit indices for the scene geometry.
+         *  Meshes are drawn relative to their own base vertex, so the
+         *  scene itself can hold any number of vertices either way.
+         *  This is only needed when a single mesh or baked chunk has
+         *  more than 65536 vertices, such as large level geometry;
+         *  without it, such meshes fail to upload.
+         *  Must be called before Init().
+         **/
+        inline void UseWideIndices()
+        { m_GeometryVBO.SetIndexType(GL_UNSIGNED_INT); }
+
         /**
          * Adds an entity to be rendered in the current scene.
          *  This method will load the mesh (if it doesn't exist), and
@@ -121,18 +198,30 @@ namespace gfx
         obj::CEntity* AddMesh(const std::string& filename, const math::vector2_t& Pos,
             bool anim = false, bool rigid = false);
         obj::CEntity* AddMesh(asset::CMesh* pMesh, const math::vector2_t& Pos);
-        inline void AddMesh(asset::obj::CEntity* pEntity)
-        { mp_sceneObjects.push_back(pEntity); }
+
+        /**
+         * Adds an existing entity to the scene.
+         *  An entity can only be in one scene at a time, so this fails
+         *  if it's already in this or another one.
+         *
+         * @return  TRUE if added, FALSE if already in a scene.
+         **/
+        bool AddMesh(obj::CEntity* pEntity);
 
         /**
          * Adds an entity to be rendered in a specific order in the scene.
          *  This method will insert an entity (provided it loaded
          *  successfully) into the drawing queue at a certain position.
          *  If the provided position does not exist, the entity will be
-         *  added at the end, just like CScene::AddMesh. 
-         *  Index data can be retrieved from the queue using
-         *  GetQueuePosition() or by searching yourself through the vector
-         *  returned by GetObjects().
+         *  added at the end, just like CScene::AddMesh. Otherwise, it
+         *  is drawn right before the entity at that index of
+         *  GetObjects(), see GetQueuePosition().
+         *  Draw order only matters among entities at the same layer and
+         *  depth, whether or not depth testing is on. Each entity has a
+         *  sparse order value, and the new one gets the value halfway
+         *  between its neighbors', so inserting takes O(log n) and
+         *  never touches the rest of the scene. Only once a gap runs
+         *  out is every entity renumbered.
          *  
          * @param   uint16_t        Position to insert entity at
          * @param   std::string     Filename of mesh to load
@@ -155,22 +244,15 @@ namespace gfx
 
         /**
          * Deletes an existing mesh entity from the scene.
-         *  This, as well as CScene::InsertMesh() should be used sparingly,
-         *  and preferably prior to the main game loop, since the
-         *  underlying container is an std::vector.
+         *  Finding the entity takes a linear search, but nothing else
+         *  is moved around: the last entity of GetObjects() takes its
+         *  place there, keeping its draw order.
          *
          * @param   obj::CEntity*    Entity to remove
          * 
          * @bool    TRUE if exists and removed, FALSE otherwise.
          **/
-        bool RemoveMesh(const obj::CEntity* pEntity)
-        {
-            int pos = this->GetQueuePosition(pEntity);
-            if(pos == -1) return false;
-
-            mp_sceneObjects.erase(mp_sceneObjects.begin() + pos);
-            return true;
-        }
+        bool RemoveMesh(const obj::CEntity* pEntity);
         
         /**
          * Adds a pre-loaded light to the scene. 
@@ -289,6 +371,106 @@ namespace gfx
         inline bool ToggleLighting()
         { return !(m_lighting = !m_lighting); }
 
+        /**
+         * Toggles instanced sprite batching.
+         *  When enabled, single-surface entities using the default shader
+         *  are grouped by texture and mesh and drawn in a single instanced
+         *  call. Overlapping batched sprites with different textures may
+         *  then be drawn out of insertion order.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleBatching()
+        { return !(m_batching = !m_batching); }
+
+        /**
+         * Toggles camera culling.
+         *  When enabled, only entities whose bounding box touches the
+         *  camera's view are submitted for rendering.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleCulling()
+        { return !(m_culling = !m_culling); }
+
+        /**
+         * Toggles drawing static entities from baked geometry.
+         *  When enabled, entities that are baked (see AddMesh() and
+         *  CStaticGeometry) are drawn as merged world-space chunks, a
+         *  call per chunk, instead of one by one. Chunks are only
+         *  rebuilt when a baked entity changes, so it's best kept to
+         *  things that never move.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleBaking()
+        { return !(m_baking = !m_baking); }
+
+        /**
+         * Toggles depth testing of the scene's geometry.
+         *  Either way, surfaces end up on top of each other exactly as
+         *  if drawn in order. When enabled, opaque surfaces are drawn
+         *  first, grouped by texture, without blending and with the
+         *  depth test rejecting whatever they cover. Translucent
+         *  surfaces are then blended in order. When disabled,
+         *  everything is blended in order, from the back. Depth testing
+         *  is never used with a projection that flattens z.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleDepth()
+        { return !(m_depth = !m_depth); }
+
+        /**
+         * Toggles single-pass lighting.
+         *  When enabled, every light is packed into a uniform buffer
+         *  and the scene is lit in one full-screen pass, rather than
+         *  one additive pass per light. Lights past the buffer's limit
+         *  (see CLightBuffer::MAX_LIGHTS) are still drawn separately.
+         *  Off by default.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleLightBuffer()
+        { return !(m_light_buffer = !m_light_buffer); }
+
+        /**
+         * Toggles shadows for point lights.
+         *  Entities marked with CEntity::SetShadowCaster() block light
+         *  from point lights. Lights in the single-pass light buffer
+         *  (see ToggleLightBuffer()) use a polar shadow map on the GPU
+         *  (see CShadowMap). Lights drawn one at a time have shadow
+         *  geometry extruded from each caster's outline instead, which
+         *  masks them out through the depth buffer.
+         *  Off by default.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleShadows()
+        { return !(m_shadows = !m_shadows); }
+
+        /**
+         * Toggles GPU profiling.
+         *  When enabled, each part of the frame is timed on the GPU (see
+         *  SceneTimer), and the times show up in GetStats() a few frames
+         *  later. Does nothing if timer queries aren't supported.
+         *  Off by default.
+         *  
+         * @return  What the value was originally, BEFORE toggling.
+         **/
+        inline bool ToggleProfiling()
+        { return !(m_profiling = !m_profiling); }
+
+        /**
+         * Writes the stats of every following frame to a CSV file.
+         *
+         * @param   char*   File to (over)write
+         *
+         * @return  TRUE if the file was opened, FALSE otherwise.
+         **/
+        bool StartStatsLog(const char* pfilename);
+        void StopStatsLog();
+
         /**
          * Toggles wire-mesh rendering.
          * @return  What the value was originally, BEFORE toggling.
@@ -318,6 +500,7 @@ namespace gfx
 
          /**
           * Returns the position in the object queue of the object.
+          *  The queue is in no particular order, see InsertMesh().
           * 
           * @param  obj::CEntity*    Object to search for
           * 
@@ -340,9 +523,47 @@ namespace gfx
          inline CVertexBuffer& GetGeometryBuffer()
          { return m_GeometryVBO; }
 
+         /**
+          * Retrieves statistics about the last call to Render().
+          **/
+         inline const scene_stats_t& GetStats() const
+         { return m_Stats; }
+
          friend class CLevel;
 
     private:
+        enum ScenePass
+        {
+            IC_GEOMETRY_PASS,
+            IC_LIGHTING_PASS,
+            IC_PRESENT_PASS
+        };
+
+        /**
+         * Draws the render queue into the current pass's output.
+         **/
+        void GeometryRender(const bool wire);
+
+        /**
+         * Model-view z that puts a render_item_t::depth into the
+         * depth buffer, nearest first.
+         **/
+        float GetDepthOffset(const float depth);
+
+        /**
+         * Adds every light to the scene.
+         *
+         * @param   uint32_t    Texture with the unlit scene
+         **/
+        void LightingRender(const uint32_t source);
+
+        /**
+         * Runs the post-processing effects and copies the result to
+         * the screen.
+         *
+         * @param   uint32_t    Texture with the finished scene
+         **/
+        void PresentRender(uint32_t source);
 
         /**
          * Renders a mesh surface.
@@ -355,74 +576,201 @@ namespace gfx
          *
          * @param   surface_t*      Mesh instance to render indices from
          * @param   matrix4x4_t&    Position matrix of mesh surface
+         * @param   uint32_t        Texture to bind instead of the
+         *                          material's, such as the atlas page
+         *                          baked geometry samples (optional=0)
          * 
          * @pre     VBO must be bound.
          * @see     PostFXRender()
          */
         void StandardRender(
             gfx::surface_t* pSurface,
-            const math::matrix4x4_t& ModelView);
+            const math::matrix4x4_t& ModelView,
+            const uint32_t texture = 0);
 
         void StandardRender(obj::CEntity* pEntity,
             const math::matrix4x4_t& ModelView);
 
+        /**
+         * Spreads the draw orders of all entities out evenly again,
+         * once InsertMesh() has used up the gap between two of them.
+         **/
+        void Renumber();
+
         /**
          * Renders lights on top of the entire scene.
          *  When a scene has multiple lights acting on everything,
          *  this method will be called for each light after a
          *  StandardRender is performed.
-         *  Rendering is simply done using additive blending.
+         *  Rendering is simply done using additive blending, scissored
+         *  to the part of the screen the light can reach. Lights that
+         *  reach nothing on-screen are skipped entirely.
          *
          * @param   CLight*     Light to add to the scene
          **/
         void LightRender(gfx::CLight* pEffect);
 
         /**
-         * Renders post-processing effects on top of the entire scene.
-         *  When a scene has multiple effects acting on everything,
-         *  this method will be called for each effect after all other 
-         *  rendering has been performed.
-         *  Rendering is done by ping-pong'ing between frame-buffers.
+         * Packs as many lights as fit into the light buffer. Lights
+         * that can't reach the screen are skipped, as in LightRender().
+         *  Also finds the area the packed lights reach, clipped to the
+         *  shadow occlusion map.
          *
-         * @param   CEffect*        Effect to render over the scene
-         * @param   CFramebuffer    Target to render scene onto
-         * @param   uint32_t        Texture containing current scene
-         * 
-         * @return  The last FBO texture that was rendered onto.
+         * @return  Index of the first light that didn't fit.
+         **/
+        size_t PackLights();
+
+        /**
+         * Renders the packed lights in a single full-screen pass.
+         **/
+        void LightBufferRender();
+
+        /**
+         * Draws the shadow casters into the occlusion map, and builds
+         * the polar shadow map for the packed lights from it.
+         *  Casters are found within the packed lights' reach rather
+         *  than on-screen, see PackLights().
+         **/
+        void ShadowMapRender();
+
+        /**
+         * Finds the part of the screen a light can reach.
+         *
+         * @param   CLight*         Light to check
+         * @param   math::rect_t&   Clipped, top-down box in pixels
+         * @param   bool&           FALSE if the light reaches everything
+         *
+         * @return  FALSE if the light is entirely off-screen.
+         **/
+        bool ClipLight(const gfx::CLight* pLight, math::rect_t& Box,
+                       bool& bounded) const;
+
+        /**
+         * Masks out a light's shadows before drawing it.
+         *  The light's cached shadow geometry is drawn into the depth
+         *  buffer only, in front of where the light's full-screen quad
+         *  will be, and the depth test is left set up so that the
+         *  light is only drawn where there's no shadow.
+         *
+         * @param   CLight*     Light whose shadows to draw
+         *
+         * @return  TRUE if the depth test was left on, FALSE if there
+         *          are no shadows to draw.
+         **/
+        bool ShadowRender(const gfx::CLight* pLight);
+
+        /**
+         * Brings a light's shadow geometry up to date.
+         *  Shadows are cached per light and caster. Only casters that
+         *  moved since the last frame are looked at, unless the light
+         *  itself moved or wasn't drawn last frame, so a static light
+         *  over static geometry costs nothing.
+         *
+         * @param   CLight*     Light casting the shadows
          **/
-        uint32_t PostProcessingRender(gfx::CEffect* pEffect,
-            gfx::CFrameBuffer& Target, uint32_t source);
+        void UpdateShadows(const gfx::CLight* pLight);
 
         /**
-         * Renders shadow geometry.
-         *    This is called internally every frame. 
+         * Rebuilds the shadow of one caster from one light, if either
+         * moved since it was built. Shadows are extruded from the
+         * outline each mesh calculates on loading.
          **/
-        void ShadowRender();
+        void BuildShadow(const gfx::CLight* pLight,
+                         obj::CEntity* pCaster);
 
         /**
-         * Updates shadow casting vertex positions.
-         *  This is called internally every frame. The shadow is drawn
-         *  later on the GPU, this pushes new vertices to the VBO.
+         * Drops cached shadows, giving their space back to the buffer.
+         *
+         * @param   CLight*     Light to forget, NULL for any light
+         * @param   CEntity*    Caster to forget, NULL for any caster
          **/
-        void UpdateShadows(const math::vector2_t& LightPosition);
+        void ForgetShadows(const gfx::CLight* pLight,
+                           const obj::CEntity* pCaster);
+
+        /**
+         * Uploads the projection, camera, and time to the per-frame
+         * uniform block. This is called internally every frame.
+         **/
+        void UpdateFrameData();
+
+        /**
+         * Appends the last frame's stats to the CSV log.
+         **/
+        void LogStats();
+
+        /**
+         * A shadow cast by one entity from one light, and the positions
+         * it was built for.
+         **/
+        struct shadow_t
+        {
+            math::vector2_t     Light, Caster;
+            geometry_range_t    Range;
+        };
+
+        typedef std::pair<const CLight*, const obj::CEntity*> ShadowKey_t;
+        typedef std::map<ShadowKey_t, shadow_t> ShadowMap_t;
+
+        /**
+         * Where a light was, and in which frame, when its shadows were
+         * last brought up to date.
+         **/
+        struct shadow_light_t
+        {
+            math::vector2_t     Position;
+            uint32_t            frame;
+        };
+
+        typedef std::map<const CLight*, shadow_light_t> ShadowLightMap_t;
+
+        // Entities by their draw order, see InsertMesh().
+        typedef std::map<uint32_t, obj::CEntity*> OrderMap_t;
+        static const uint32_t   ORDER_STEP = 1024;
 
         static material_t       m_ShadowShader;
 
         CWindow*                mp_Window;
-        CVertexBuffer           m_GeometryVBO, m_ShadowVBO;
-        CFrameBuffer            m_FBO, m_FBOSwap;
+        CVertexBuffer           m_GeometryVBO;
+        CStaticGeometry         m_Static;
+        CVertexBuffer           m_ShadowVBO;
+        ShadowMap_t             m_Shadows;
+        ShadowLightMap_t        m_ShadowLights;
+        OrderMap_t              m_Order;
+        CRenderTargetPool       m_TargetPool;
+        CRenderGraph            m_Graph;
+        CEffectChain            m_EffectChain;
+        CUniformBuffer          m_FrameUBO;
+        CSpriteBatch            m_Batch;
+        CLightBuffer            m_LightBuffer;
+        CShadowMap              m_ShadowMap;
+        CRenderQueue            m_Queue;
+        CVisibilityGrid         m_Visibility;
+        CGPUTimer               m_GPUTimer;
+        scene_stats_t           m_Stats;
+        std::ofstream           m_StatsLog;
+        uint32_t                m_log_frame;
+        uint32_t                m_shadow_frame;
 
         math::vector2_t         m_Camera, m_WindowDim;
         math::matrix4x4_t       m_WindowProj;
+        math::rect_t            m_ShadowArea;
 
         std::vector<obj::CEntity*>   mp_sceneObjects;
+        std::vector<obj::CEntity*>   mp_visibleObjects;
         std::vector<CEffect*>   mp_sceneEffects;
         std::vector<CLight*>    mp_sceneLights;
+        std::vector<obj::CEntity*>   mp_movedObjects;
+        std::vector<obj::CEntity*>   mp_shadowCasters;
+        std::vector<float>      m_shadowScratch;
         std::vector<vertex2_t>  m_shadowVertices;
         std::vector<uint16_t>   m_shadowIndices;
 
         uint32_t m_geo_type;
-        bool m_lighting, m_postfx;
+        bool m_lighting, m_postfx, m_batching, m_culling;
+        bool m_baking, m_bake_all, m_depth;
+        bool m_light_buffer, m_light_buffer_ok;
+        bool m_shadows, m_shadows_ok;
+        bool m_profiling, m_profiling_ok;
     };
 
 }   // namespace gfx
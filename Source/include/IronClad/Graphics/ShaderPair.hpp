@@ -23,6 +23,9 @@
 #define IRON_CLAD__GRAPHICS__SHADER_HPP
 
 #include <string>
+#include <cstring>
+#include <vector>
+#include <algorithm>
 
 #include "IronClad/Base/Types.hpp"
 #include "IronClad/Asset/Shader.hpp"
@@ -32,6 +35,21 @@ namespace ic
 {
 namespace gfx
 {
+    /**
+     * An active uniform, found by reflection when a program is linked.
+     **/
+    struct IRONCLAD_API uniform_t
+    {
+        inline bool operator<(const uniform_t& Other) const
+        { return hash < Other.hash; }
+
+        uint32_t    hash;       // Hash of the uniform name
+        std::string name;       // Name, to tell apart hash collisions
+        int         location;   // Location in the program
+        uint32_t    type;       // GL_FLOAT_MAT4, GL_SAMPLER_2D, etc.
+        int         size;       // Array size, 1 if not an array
+    };
+
     /**
      * An OpenGL shader wrapper class.
      *  This class will load both a vertex and fragment shader, linking
@@ -66,6 +84,8 @@ namespace gfx
          * Loads a shader file from source code.
          *  On returning false, an error string is stored internally, which
          *  can be accessed by calling GetError().
+         *  The sources are NULL-terminated arrays of lines, which are
+         *  concatenated (one line per entry) before compilation.
          *  
          * @param   char**  Vertex shader source
          * @param   char**  Fragment shader source
@@ -83,10 +103,62 @@ namespace gfx
         inline uint32_t GetProgram() const
         { return m_program; }
 
+        /**
+         * Finds the location of a uniform.
+         *  Active uniforms are enumerated once at link time, so this is
+         *  a lookup in a small sorted table rather than a GL call.
+         *  Names that aren't in the table (such as individual array
+         *  elements) fall back to asking OpenGL.
+         *
+         * @param   char*   Uniform name
+         * @return  The uniform location, -1 if it doesn't exist.
+         **/
         short   GetUniformLocation(const char* uni)     const;
         short   GetAttributeLocation(const char* attr)  const;
 
+        /**
+         * Retrieves the reflected info on a uniform.
+         * @return  The uniform info, NULL if it's not active.
+         **/
+        const uniform_t* FindUniform(const char* uni) const;
+
+        inline const std::vector<uniform_t>& GetUniforms() const
+        { return m_Uniforms; }
+
+        /**
+         * Locations of the standard "mv" and "proj" uniforms,
+         * cached at link time.
+         **/
+        inline short GetMVLocation() const
+        { return m_mv_loc; }
+
+        inline short GetProjLocation() const
+        { return m_proj_loc; }
+
+        /**
+         * Does the program read the shared per-frame uniform block?
+         * @see     gfx::frame_data_t
+         **/
+        inline bool HasFrameData() const
+        { return m_frame_data; }
+
+        static inline uint32_t HashName(const char* pname)
+        { return util::Murmur2(pname, strlen(pname), 0); }
+
     private:
+        /**
+         * Links the currently loaded vertex and fragment shader
+         * objects into a program.
+         **/
+        bool Link();
+
+        /**
+         * Enumerates the active uniforms and blocks of the program.
+         **/
+        void Reflect();
+
+        std::vector<uniform_t>  m_Uniforms;
+
         asset::CShader* mp_VShader;
         asset::CShader* mp_FShader;
 
@@ -95,6 +167,8 @@ namespace gfx
         uint32_t m_program;
         
         int     m_error;
+        short   m_mv_loc, m_proj_loc;
+        bool    m_frame_data;
     };
 
 }   // namespace gfx
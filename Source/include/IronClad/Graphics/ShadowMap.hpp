@@ -0,0 +1,140 @@
+/**
+ * @file
+ *  Graphics/ShadowMap.hpp - Declares the CShadowMap class, which builds
+ *  1D polar occlusion maps for point lights on the GPU.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__SHADOW_MAP_HPP
+#define IRON_CLAD__GRAPHICS__SHADOW_MAP_HPP
+
+#include "IronClad/Base/Types.hpp"
+#include "IronClad/Math/Matrix.hpp"
+#include "Framebuffer.hpp"
+#include "ShaderPair.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * GPU shadows for point lights.
+     *  Shadow casters are first drawn into an occlusion map covering
+     *  the screen plus some padding around it. Then, in a single pass, every texel of a polar map marches
+     *  outward from its light along its own angle, storing how far it
+     *  got before hitting an occluder. Each light in the "LightData"
+     *  block gets one row of the polar map, and the lighting shader
+     *  compares a pixel's distance to the stored one.
+     *
+     *  The cost depends on the number of lights and the resolution of
+     *  the map, never on the complexity of the casters.
+     *
+     *  Usage, once the lights have been packed and uploaded:
+     *
+     *      Shadows.BeginOccluders();
+     *      for(...)
+     *      {
+     *          Shadows.SetModelView(MV);
+     *          // Draw the caster's surfaces.
+     *      }
+     *      Shadows.EndOccluders();
+     *      Shadows.Build(Lights.GetCount());
+     *      Shadows.Bind(1);
+     *
+     *  Lights may sit anywhere, even off of the map, since their rays
+     *  are clipped to it before marching. Only casters within the
+     *  padding of the screen can block light, anything outside of the
+     *  occlusion map is treated as empty space.
+     **/
+    class IRONCLAD_API CShadowMap
+    {
+    public:
+        CShadowMap();
+        ~CShadowMap();
+
+        /**
+         * Creates the maps and compiles the shaders.
+         *
+         * @param   uint16_t    Screen width
+         * @param   uint16_t    Screen height
+         * @param   uint16_t    Angular resolution (optional=512)
+         * @param   uint16_t    Pixels the occlusion map reaches past
+         *                      each edge of the screen (optional=256)
+         *
+         * @return  TRUE on success, FALSE on error.
+         **/
+        bool Init(const uint16_t w, const uint16_t h,
+                  const uint16_t resolution = 512,
+                  const uint16_t padding = 256);
+
+        /**
+         * Clears the occlusion map and prepares to draw casters into it.
+         *  Casters are drawn with their own textures, and any texel
+         *  with an alpha over one half blocks light.
+         **/
+        void BeginOccluders();
+
+        /**
+         * Positions the next caster.
+         *  The camera offset is added in the shader.
+         **/
+        void SetModelView(const math::matrix4x4_t& MV);
+
+        /**
+         * Sets the part of the bound texture the next caster samples,
+         * see asset::CTexture::GetRegion().
+         **/
+        void SetRegion(const float* region);
+
+        void EndOccluders();
+
+        /**
+         * Builds the polar map for the lights in the light buffer.
+         *  The full-screen VBO must be bound.
+         *
+         * @param   uint32_t    Number of lights in the buffer
+         **/
+        void Build(const uint32_t count);
+
+        /**
+         * Binds the polar map to a texture unit.
+         *  The active unit is left at 0 afterwards.
+         **/
+        void Bind(const uint32_t unit);
+
+        inline uint16_t GetResolution() const
+        { return m_resolution; }
+
+        inline uint16_t GetPadding() const
+        { return m_padding; }
+
+    private:
+        CFrameBuffer    m_Occluders;
+        CShaderPair     m_OccluderShader, m_PolarShader;
+
+        uint32_t        m_fbo, m_texture;
+        uint16_t        m_resolution, m_padding;
+        int             m_mvloc, m_regionloc;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__SHADOW_MAP_HPP
+
+/** @} **/
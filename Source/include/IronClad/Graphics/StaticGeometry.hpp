@@ -0,0 +1,235 @@
+/**
+ * @file
+ *  Graphics/StaticGeometry.hpp - Declares the CStaticGeometry class,
+ *  which merges entities that don't change into world-space chunks.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__STATIC_GEOMETRY_HPP
+#define IRON_CLAD__GRAPHICS__STATIC_GEOMETRY_HPP
+
+#include <map>
+#include <vector>
+
+#include "IronClad/Math/Shapes.hpp"
+#include "IronClad/Entity/Entity.hpp"
+
+#include "VertexBuffer.hpp"
+#include "RenderQueue.hpp"
+#include "Material.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * Bakes entities that never change into merged world-space geometry.
+     *  Every surface of a baked entity is transformed into world space
+     *  and merged with the others that share its layer, depth, and
+     *  texture and lie in the same square chunk of the world. Each
+     *  chunk is then a single range in the scene's geometry buffer,
+     *  drawn with a single call whenever it's on-screen.
+     *
+     *  Entities register through their CMeshInstance, which calls
+     *  Update() whenever they change, just like the CVisibilityGrid;
+     *  only chunks whose entities changed are rebuilt by Rebake().
+     *  Changing an entity's texture, visibility, layer, or depth isn't
+     *  noticed, so use Remove() and Add() to re-bake it.
+     *
+     *  Only opaque entities using the default shader without sprite
+     *  animation can be baked, since merging loses their draw order.
+     *  Textures packed into a CTextureAtlas are fine, their region is
+     *  baked into the texture coordinates.
+     *
+     *  The mesh data is read back from the geometry buffer the first
+     *  time a surface is baked, and is kept for as long as a baked
+     *  entity uses it, so moving a baked entity doesn't stall.
+     **/
+    class IRONCLAD_API CStaticGeometry
+    {
+    public:
+        static const uint16_t CHUNK_SIZE = 512;
+
+        CStaticGeometry();
+        ~CStaticGeometry();
+
+        /**
+         * Sets the buffer that holds both the meshes of baked entities
+         * and the baked chunks.
+         **/
+        void Init(gfx::CVertexBuffer& VBO);
+
+        /**
+         * Starts baking an entity.
+         *  The entity is actually baked on the next call to Rebake(),
+         *  so it can be moved into place before then.
+         *
+         * @return  TRUE if it will be baked, FALSE if it already is or
+         *          can't be (see above).
+         **/
+        bool Add(obj::CEntity* pEntity);
+
+        /**
+         * Stops baking an entity, it has to be drawn normally again.
+         * @return  TRUE if removed, FALSE if it isn't baked here.
+         **/
+        bool Remove(obj::CEntity* pEntity);
+
+        /**
+         * Marks an entity as changed.
+         *  Called by CMeshInstance, you shouldn't need to do this.
+         *
+         * @param   int32_t     ID of the entity
+         **/
+        void Update(const int32_t id);
+
+        /**
+         * Stops baking an entity by its ID.
+         *  Called by CMeshInstance on destruction.
+         **/
+        void Detach(const int32_t id);
+
+        /**
+         * Re-bakes every chunk whose entities changed.
+         **/
+        void Rebake();
+
+        /**
+         * Queues the chunks touching a rectangle.
+         *  Chunks are queued as opaque surfaces that belong to no
+         *  entity, and must be drawn without a transformation. Queue
+         *  them before any entity, so they're drawn underneath the
+         *  others at the same layer and depth.
+         *
+         * @param   rect_t*         World-space rectangle, NULL for all
+         * @param   CRenderQueue&   Queue to add to
+         *
+         * @return  The number of surfaces queued.
+         **/
+        uint32_t Submit(const math::rect_t* pView, CRenderQueue& Queue);
+
+        /**
+         * Stops baking everything, giving the chunks' space back.
+         **/
+        void Clear();
+
+        inline size_t GetCount() const
+        { return m_Members.size() - m_freeList.size(); }
+
+        inline size_t GetChunkCount() const
+        { return m_Chunks.size(); }
+
+    private:
+        // Chunks are unique per layer, depth, texture, and cell.
+        struct chunk_key_t
+        {
+            uint32_t    texture;
+            int32_t     x, y;
+            float       depth;
+            uint8_t     layer;
+
+            bool operator<(const chunk_key_t& Other) const
+            {
+                if(layer   != Other.layer)   return layer   < Other.layer;
+                if(depth   != Other.depth)   return depth   < Other.depth;
+                if(texture != Other.texture) return texture < Other.texture;
+                if(x       != Other.x)       return x       < Other.x;
+                return y < Other.y;
+            }
+        };
+
+        // A part of a chunk small enough for the buffer's index type.
+        struct piece_t
+        {
+            surface_t           Surface;
+            geometry_range_t    Range;
+        };
+
+        struct chunk_t
+        {
+            chunk_t() : dirty(true) {}
+
+            material_t              Material;
+            std::vector<int32_t>    members;
+            std::vector<piece_t>    Pieces;
+            math::vector2_t         Min, Max;
+            bool                    dirty;
+        };
+
+        struct member_t
+        {
+            member_t() : pEntity(NULL), dirty(false) {}
+
+            obj::CEntity*                   pEntity;
+            std::vector<chunk_key_t>        Chunks;
+            std::vector<const surface_t*>   Surfaces;
+            bool                            dirty;
+        };
+
+        // Local-space copy of a mesh surface, indices start at zero.
+        struct source_t
+        {
+            source_t() : refs(0), loaded(false) {}
+
+            std::vector<vertex2_t>  Vertices;
+            std::vector<uint32_t>   Indices;
+            uint32_t                refs;
+            bool                    loaded;
+        };
+
+        typedef std::map<chunk_key_t, chunk_t> ChunkMap_t;
+        typedef std::map<const surface_t*, source_t> SourceMap_t;
+
+        /// Texture a surface of an entity is drawn with.
+        static asset::CTexture* GetTexture(obj::CEntity* pEntity,
+                                           const surface_t* pSurface);
+
+        bool CanBake(obj::CEntity* pEntity) const;
+
+        /// Puts a member into the chunks it belongs to.
+        void Link(const int32_t id);
+
+        /// Takes a member out of its chunks.
+        void Unlink(const int32_t id);
+
+        void Build(const chunk_key_t& Key, chunk_t& Chunk);
+        void Flush(chunk_t& Chunk);
+        void FreePieces(chunk_t& Chunk);
+        void ReleaseSources();
+        bool Load(const surface_t* pSurface, source_t& Source);
+
+        gfx::CVertexBuffer*     mp_VBO;
+        ChunkMap_t              m_Chunks;
+        SourceMap_t             m_Sources;
+        std::vector<member_t>   m_Members;
+        std::vector<int32_t>    m_freeList;
+        std::vector<int32_t>    m_dirty;
+
+        std::vector<vertex2_t>  m_vertices;
+        std::vector<uint32_t>   m_indices;
+        std::vector<uint8_t>    m_raw;
+
+        bool m_rebuild;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__STATIC_GEOMETRY_HPP
+
+/** @} **/
@@ -0,0 +1,151 @@
+/**
+ * @file
+ *  Graphics/StreamBuffer.hpp - Declares the CStreamBuffer class, a
+ *  fenced ring buffer for geometry that is rebuilt every frame.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__STREAM_BUFFER_HPP
+#define IRON_CLAD__GRAPHICS__STREAM_BUFFER_HPP
+
+#include <vector>
+
+#include "IronClad/Base/Types.hpp"
+#include "VertexBuffer.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * A ring buffer for streaming per-frame geometry to the GPU.
+     *  The vertex and index buffers are split into a number of regions,
+     *  and each frame writes into the next one. A fence is placed after
+     *  a region is used, and only waited on when the ring comes back
+     *  around to it, so in practice the CPU never stalls on the GPU.
+     *
+     *  Geometry is written straight into mapped GPU memory:
+     *
+     *      vertex2_t* pVertices; uint16_t* pIndices;
+     *      geometry_range_t Range;
+     *      if(Stream.Map(4, 6, pVertices, pIndices, Range))
+     *      {
+     *          // Fill in, indices start at 0 for this range.
+     *          Stream.Unmap();
+     *          Stream.Bind();
+     *          Stream.Draw(Range);
+     *          Stream.Unbind();
+     *      }
+     *
+     *  Mapped memory is write-only, never read it back.
+     *  A range stays valid until the ring wraps back around to it, so
+     *  draw it in the frame it was written. If a single request can't
+     *  fit in a region, the buffers grow, orphaning the old storage.
+     **/
+    class IRONCLAD_API CStreamBuffer
+    {
+    public:
+        CStreamBuffer();
+        ~CStreamBuffer();
+
+        /**
+         * Creates the buffers.
+         *
+         * @param   uint32_t    Vertices per region
+         * @param   uint32_t    Indices per region
+         * @param   uint8_t     Number of regions (optional=3)
+         *
+         * @return  TRUE on success, FALSE on lack of function pointer.
+         **/
+        bool Init(const uint32_t vcount, const uint32_t icount,
+                  const uint8_t regions = 3);
+
+        /**
+         * Reserves space for geometry and maps it for writing.
+         *  Only one range may be mapped at a time.
+         *
+         * @param   uint32_t            Vertex count
+         * @param   uint32_t            Index count
+         * @param   vertex2_t*&         Vertices are written here
+         * @param   uint16_t*&          Indices are written here
+         * @param   geometry_range_t&   The range is stored here
+         *
+         * @return  TRUE if mapped, FALSE on error.
+         **/
+        bool Map(const uint32_t vcount, const uint32_t icount,
+                 vertex2_t*& pVertices, uint16_t*& pIndices,
+                 geometry_range_t& Range);
+
+        /**
+         * Finishes writing the mapped range.
+         **/
+        void Unmap();
+
+        /**
+         * Binds the stream's VAO for drawing.
+         **/
+        void Bind();
+        void Unbind();
+
+        /**
+         * Draws part of a range.
+         *
+         * @param   geometry_range_t&   Range given by Map()
+         * @param   uint32_t            First index in the range
+         * @param   uint32_t            Index count, 0 for all of them
+         * @param   uint32_t            Primitive type (optional=GL_TRIANGLES)
+         **/
+        void Draw(const geometry_range_t& Range,
+                  const uint32_t first = 0, const uint32_t count = 0,
+                  const uint32_t geo_type = GL_TRIANGLES);
+
+        /**
+         * Deletes the buffers and any pending fences.
+         **/
+        void Release();
+
+    private:
+        /**
+         * Fences the current region, then moves on to the next one,
+         * waiting on its fence if the GPU might still be reading it.
+         **/
+        void NextRegion();
+
+        /**
+         * Reallocates the buffers with bigger regions.
+         **/
+        bool Grow(const uint32_t vcount, const uint32_t icount);
+
+        void Attach();
+
+        std::vector<GLsync> m_Fences;
+
+        uint32_t    m_vao, m_vbo, m_ibo;
+        uint32_t    m_vregion, m_iregion;   // Region sizes, in elements
+        uint32_t    m_voffset, m_ioffset;   // Write cursor in the region
+        uint32_t    m_frame;
+        uint8_t     m_regions, m_region;
+        bool        m_mapped;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__STREAM_BUFFER_HPP
+
+/** @} **/
@@ -56,7 +56,8 @@ namespace gfx
 
         material_t* pMaterial;  // The material to bind for the surface.
         uint32_t    start;      // The starting point in the buffer.
-        uint16_t    icount;     // The number of indices.
+        uint32_t    base;       // Base vertex the indices are relative to.
+        uint32_t    icount;     // The number of indices.
     };
 
 }   // namespace gfx
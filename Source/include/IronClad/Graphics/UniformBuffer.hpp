@@ -0,0 +1,113 @@
+/**
+ * @file
+ *  Graphics/UniformBuffer.hpp - Declares the CUniformBuffer class, a
+ *  wrapper for OpenGL uniform buffer objects.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__UNIFORM_BUFFER_HPP
+#define IRON_CLAD__GRAPHICS__UNIFORM_BUFFER_HPP
+
+#include "GL/glew.h"
+
+#include "IronClad/Base/Types.hpp"
+
+namespace ic
+{
+namespace gfx
+{
+    /**
+     * Binding points for the uniform blocks IronClad knows about.
+     *  CShaderPair automatically attaches any block with a matching
+     *  name to these points when linking.
+     **/
+    enum UniformBinding
+    {
+        IC_FRAME_DATA_BINDING = 0,  // "FrameData"
+        IC_LIGHT_DATA_BINDING = 1   // "LightData", see CLightBuffer
+    };
+
+    /**
+     * Per-frame data shared by every shader, laid out as std140.
+     *  Shaders access it by declaring:
+     *
+     *      layout(std140) uniform FrameData
+     *      {
+     *          mat4  proj;
+     *          vec2  camera;
+     *          float time;
+     *      };
+     *
+     *  The projection is stored row-major, matching math::matrix4x4_t,
+     *  so the block should be declared with layout(row_major).
+     **/
+    struct IRONCLAD_API frame_data_t
+    {
+        float proj[16];
+        float camera[2];
+        float time;
+        float padding;
+    };
+
+    /**
+     * A wrapper for OpenGL uniform buffer objects.
+     *  The buffer is bound to a fixed binding point, and any shader
+     *  program with a block attached to that point reads from it.
+     **/
+    class IRONCLAD_API CUniformBuffer
+    {
+    public:
+        CUniformBuffer();
+        ~CUniformBuffer();
+
+        /**
+         * Creates the buffer and attaches it to a binding point.
+         *
+         * @param   uint32_t    Buffer size, in bytes
+         * @param   uint32_t    Binding point (see UniformBinding)
+         *
+         * @return  TRUE on success, FALSE if UBOs are unsupported.
+         **/
+        bool Init(const uint32_t size, const uint32_t binding);
+
+        /**
+         * Replaces the contents of the buffer.
+         *  The previous storage is orphaned, so this never waits on
+         *  draws still reading the old data.
+         **/
+        void Update(const void* pdata, const uint32_t size);
+
+        /**
+         * Re-attaches the buffer to its binding point.
+         *  Only necessary if something else was bound there since.
+         **/
+        void Bind();
+
+        inline uint32_t GetBuffer() const
+        { return m_ubo; }
+
+    private:
+        uint32_t m_ubo, m_size, m_binding;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__UNIFORM_BUFFER_HPP
+
+/** @} **/
@@ -29,6 +29,7 @@
 #include "IronClad/Utils/Utilities.hpp"
 #include "IronClad/Base/Types.hpp"
 #include "Window.hpp"
+#include "BufferArena.hpp"
 
 /**
  * Dirty macro to determine the offset of a field within a struct.
@@ -40,8 +41,25 @@
 
 namespace ic
 {
+    // Forward declaration for friendship.
+    namespace asset { class CMesh; }
+
 namespace gfx
 {
+    /**
+     * A range of vertices and indices within a CVertexBuffer.
+     *  Both starts are in elements, not bytes. Indices uploaded to a
+     *  range are relative to vstart, which should be passed as the
+     *  base vertex when drawing.
+     **/
+    struct IRONCLAD_API geometry_range_t
+    {
+        geometry_range_t() : vstart(0), vcount(0), istart(0), icount(0) {}
+
+        uint32_t vstart, vcount;
+        uint32_t istart, icount;
+    };
+
     /**
      * A wrapper for OpenGL VBO's.
      *  This wrapper includes many features that allow versatile VBO buffer
@@ -49,6 +67,16 @@ namespace gfx
      *  data to the buffer, and once your completely finished, a call to
      *  FinalizeBuffer() will wrap everything up nicely for you, offloading
      *  everything you've specified to the GPU and cleaning up CPU memory.
+     *
+     *  The vertex and index buffers are CBufferArena's, so geometry can
+     *  also be given its own range with Allocate() and Upload(), and
+     *  handed back with Free() when it's no longer needed. Neither
+     *  touches any data but the range in question.
+     *
+     *  Indices are 16-bit by default. Since ranges are drawn with a base
+     *  vertex, that only limits the size of a single range, not the
+     *  whole buffer; use SetIndexType(GL_UNSIGNED_INT) for buffers that
+     *  hold bigger ranges than that.
      **/
     class IRONCLAD_API CVertexBuffer
     {
@@ -88,10 +116,41 @@ namespace gfx
         /**
          * Offloads everything to the GPU.
          *  Data is stored as [v0|v1|t0|t1|c0|...|v2|v3|...] in the buffer.
+         *  The pending data gets its own range, and its indices are
+         *  shifted to wherever its vertices ended up.
          *  All of the copied buffers will be emptied after this call.
          **/
         void FinalizeBuffer();
 
+        /**
+         * Reserves space for geometry in the GPU buffers.
+         *
+         * @param   uint32_t            Vertex count
+         * @param   uint32_t            Index count
+         * @param   geometry_range_t&   The reserved range is stored here
+         *
+         * @return  TRUE on success, FALSE if out of space.
+         **/
+        bool Allocate(const uint32_t vcount, const uint32_t icount,
+                      geometry_range_t& Range);
+
+        /**
+         * Copies geometry into a range reserved by Allocate().
+         *  Indices are relative to the start of the range, and are
+         *  converted to the buffer's index type if necessary.
+         **/
+        void Upload(const geometry_range_t& Range,
+                    const vertex2_t* pVertices,
+                    const uint16_t*  pIndices);
+        void Upload(const geometry_range_t& Range,
+                    const vertex2_t* pVertices,
+                    const uint32_t*  pIndices);
+
+        /**
+         * Returns a range to the buffer for re-use.
+         **/
+        void Free(const geometry_range_t& Range);
+
         /**
          * Binds the VAO, VBO, and IBO for use.
          *  Also, this enables the active vertex shader attributes.
@@ -112,11 +171,32 @@ namespace gfx
          **/
         void Draw();
 
+        /**
+         * Specifies the index type, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+         *  This must be called before Init().
+         **/
+        inline void SetIndexType(const uint32_t type)
+        { m_index_type = type; }
+
+        inline uint32_t GetIndexType() const
+        { return m_index_type; }
+
+        /**
+         * Size of a single index, in bytes.
+         *  Multiply a surface's start by this for the draw offset.
+         **/
+        inline uint32_t GetIndexSize() const
+        { return (m_index_type == GL_UNSIGNED_INT) ? 4 : 2; }
+
         /**
          * Specifies the type of VBO (static, dynamic, etc).
          **/
         inline void SetType(const uint16_t type)
-        { m_bo_type = type; }
+        {
+            m_bo_type = type;
+            m_VertexArena.SetUsage(type);
+            m_IndexArena.SetUsage(type);
+        }
 
         /**
          * Clears contents of GPU buffers.
@@ -176,6 +256,7 @@ namespace gfx
 
         /**
          * Provides raw access to the OpenGL VBO.
+         *  This changes whenever the buffer has to grow.
          **/
         inline uint32_t GetVBO() const
         { return m_vbo; }
@@ -186,11 +267,15 @@ namespace gfx
         inline uint32_t GetIBO() const
         { return m_ibo; }
 
+        /**
+         * Vertex / index counts, up to the last one in use.
+         *  Ranges that have been freed are still included.
+         **/
         inline uint32_t GetVCount() const
-        { return m_vertex_count; }
+        { return m_VertexArena.GetUsed(); }
 
         inline uint32_t GetICount() const
-        { return m_index_count; }
+        { return m_IndexArena.GetUsed(); }
 
         inline void* GetTemporaryBuffer(const int buffer_type) const
         { return glMapBuffer(buffer_type, GL_READ_ONLY); }
@@ -198,13 +283,32 @@ namespace gfx
         inline uint32_t GetError() const 
         { return m_last_error; }
 
+        friend class asset::CMesh;
+
     private:
+        /**
+         * Points the VAO at the current arena buffers.
+         *  Needed after either arena grows into a new buffer.
+         **/
+        void Attach();
+
+        /**
+         * Meshes living in this buffer are tracked so that they can
+         * be told when their range goes away on Clear() / Release().
+         **/
+        void AddResident(asset::CMesh* pMesh);
+        void RemoveResident(asset::CMesh* pMesh);
+        void EvictResidents();
+
+        CBufferArena            m_VertexArena, m_IndexArena;
+
         std::vector<vertex2_t>  m_vertexBuffer;
         std::vector<uint16_t>   m_indexBuffer;
         std::vector<uint16_t>   m_enabledAttributes;
+        std::vector<uint32_t>   m_wideIndices;
+        std::vector<asset::CMesh*>  mp_Residents;
 
-        uint32_t    m_vbo, m_ibo, m_vao, m_bo_type;
-        uint32_t    m_vertex_count, m_index_count;
+        uint32_t    m_vbo, m_ibo, m_vao, m_bo_type, m_index_type;
         uint32_t    m_last_error;
     };
 
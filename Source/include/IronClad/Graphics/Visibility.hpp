@@ -0,0 +1,170 @@
+/**
+ * @file
+ *  Graphics/Visibility.hpp - Declares the CVisibilityGrid class, a
+ *  spatial index used by CScene to cull entities outside the camera.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").         \n
+ *  You may not use this file except in compliance with the License.        \n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0                              \n
+ *  Unless required by applicable law or agreed to in writing, software     \n
+ *  distributed under the License is distributed on an "AS IS" BASIS,       \n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and     \n
+ *  limitations under the License.
+ *
+ * @addtogroup Graphics
+ * @{
+ **/
+
+#ifndef IRON_CLAD__GRAPHICS__VISIBILITY_HPP
+#define IRON_CLAD__GRAPHICS__VISIBILITY_HPP
+
+#include <map>
+#include <vector>
+#include <algorithm>
+
+#include "IronClad/Base/Types.hpp"
+#include "IronClad/Math/Shapes.hpp"
+
+namespace ic
+{
+    namespace obj { class CEntity; }
+
+namespace gfx
+{
+    /**
+     * A uniform grid of entities, used for visibility queries.
+     *  Unlike the CQuadTree, this has no fixed world size and tracks
+     *  every entity in a scene, not just rigid bodies. Each entity is
+     *  stored in every cell its bounding box touches. Entities register
+     *  themselves through their CMeshInstance, which calls Update()
+     *  whenever they are moved or flipped, so the grid is always current
+     *  and a query only ever touches the cells under the given rect.
+     *
+     *  Query results are returned in scene order, as set by SetOrder().
+     **/
+    class IRONCLAD_API CVisibilityGrid
+    {
+    public:
+        CVisibilityGrid(const uint16_t cell_size = 256);
+        ~CVisibilityGrid();
+
+        /**
+         * Adds an entity to the grid.
+         *  The entity's mesh instance is attached to the grid, and will
+         *  keep its position in the grid up to date from then on.
+         *
+         * @param   obj::CEntity*   Entity to track
+         * @param   uint32_t        Position of the entity in draw order
+         *
+         * @return  TRUE if added, FALSE if already in a grid.
+         **/
+        bool Insert(obj::CEntity* pEntity, const uint32_t order);
+
+        /**
+         * Stops tracking an entity.
+         * @return  TRUE if removed, FALSE if it isn't in this grid.
+         **/
+        bool Remove(obj::CEntity* pEntity);
+
+        /**
+         * Re-bins an entity after it has moved.
+         *  Called by CMeshInstance, you shouldn't need to do this.
+         *
+         * @param   int32_t     Proxy ID of the entity
+         **/
+        void Update(const int32_t proxy);
+
+        /**
+         * Stops tracking an entity by its proxy ID.
+         *  Called by CMeshInstance on destruction.
+         **/
+        void Detach(const int32_t proxy);
+
+        /**
+         * Changes the draw order of an entity.
+         **/
+        void SetOrder(obj::CEntity* pEntity, const uint32_t order);
+
+        /**
+         * @return  Draw order of an entity, 0 if it isn't in this grid.
+         **/
+        uint32_t GetOrder(obj::CEntity* pEntity) const;
+
+        /**
+         * Finds all entities whose bounding box touches a rectangle.
+         *
+         * @param   rect_t&         World-space rectangle to look in
+         * @param   vector<CEntity*>&   Results are stored here, in order
+         **/
+        void Query(const math::rect_t& Rect,
+                   std::vector<obj::CEntity*>& Results);
+
+        /**
+         * Collects every entity added or moved since the last call.
+         *  Each entity is listed once, no matter how often it moved.
+         *
+         * @param   vector<CEntity*>&   Results are stored here
+         **/
+        void ConsumeMoved(std::vector<obj::CEntity*>& Results);
+
+        /**
+         * Stops tracking all entities.
+         **/
+        void Clear();
+
+        inline size_t GetCount() const
+        { return m_Proxies.size() - m_freeList.size(); }
+
+    private:
+        struct proxy_t
+        {
+            obj::CEntity*   pEntity;
+            int32_t         x0, y0, x1, y1;     // Covered cell range
+            uint32_t        order;
+            uint32_t        query;              // Last query that saw this
+            bool            moved;              // Listed in m_moved?
+        };
+
+        // Sorts proxy IDs by the draw order of their entity.
+        struct OrderCompare
+        {
+            OrderCompare(const std::vector<proxy_t>& Proxies) :
+                Proxies(Proxies) {}
+
+            bool operator()(const int32_t a, const int32_t b) const
+            { return Proxies[a].order < Proxies[b].order; }
+
+            const std::vector<proxy_t>& Proxies;
+        };
+
+        typedef std::map<uint64_t, std::vector<int32_t> > CellMap_t;
+
+        static inline uint64_t CellKey(const int32_t x, const int32_t y)
+        { return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y; }
+
+        void Bin(const int32_t proxy);
+        void Unbin(const int32_t proxy);
+        void CalculateCells(proxy_t& Proxy) const;
+        void MarkMoved(const int32_t proxy);
+
+        CellMap_t               m_Cells;
+        std::vector<proxy_t>    m_Proxies;
+        std::vector<int32_t>    m_freeList;
+        std::vector<int32_t>    m_queryResults;
+        std::vector<int32_t>    m_moved;
+
+        float       m_cell_size;
+        uint32_t    m_query;
+    };
+
+}   // namespace gfx
+}   // namespace ic
+
+#endif // IRON_CLAD__GRAPHICS__VISIBILITY_HPP
+
+/** @} **/
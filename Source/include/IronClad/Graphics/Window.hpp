@@ -132,9 +132,27 @@ namespace gfx
 
         /**
          * Swaps the OpenGL buffers, rendering everything on-screen.
+         *  This also marks the end of a frame.
          **/
         virtual void Update();
 
+        /**
+         * Number of frames presented so far.
+         *  Used by per-frame resources (such as CStreamBuffer) to
+         *  tell when a new frame has started.
+         **/
+        static inline uint32_t GetFrameCount()
+        { return m_frame_count; }
+
+        /**
+         * The frame-buffer that counts as the screen.
+         *  This is 0 (the window itself) unless there's no window, as
+         *  with CHeadlessWindow. Anything that renders off-screen
+         *  should come back to this rather than to 0.
+         **/
+        static inline uint32_t GetScreenBuffer()
+        { return m_screen; }
+
         inline uint16_t GetW() const
         { return m_width; }
 
@@ -156,6 +174,8 @@ namespace gfx
 
     protected:
         static math::matrix4x4_t   m_ProjectionMatrix;
+        static uint32_t            m_frame_count;
+        static uint32_t            m_screen;
 
         uint16_t    m_width, m_height;
         bool        m_fullscreen;
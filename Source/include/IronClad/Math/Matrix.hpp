@@ -34,6 +34,26 @@ namespace ic
 {
 namespace math
 {
+    /**
+     * 2x3 affine matrix, for 2D transformations.
+     *  The linear part is stored column by column, followed by the
+     *  translation, so that it can be handed straight to GLSL as a
+     *  mat2 and a vec2:
+     *
+     *      | m[0] m[2] m[4] |
+     *      | m[1] m[3] m[5] |
+     **/
+    struct IRONCLAD_API affine2x3_t
+    {
+        /// Identity.
+        affine2x3_t();
+
+        /// Transforms a point.
+        vector2_t operator*(const vector2_t& Point) const;
+
+        float m[6];
+    };
+
     /**
      * 4x4 matrix.
      *  There is support for rotation, translation, scaling,
@@ -61,12 +81,20 @@ namespace math
          * @return  The float array at that index.
          **/
         float* operator[](uint8_t index);
+        const float* operator[](uint8_t index) const;
 
         matrix4x4_t operator*(matrix4x4_t& Other)   const;
         vector2_t   operator*(vector2_t& Other)     const;
 
         void Print() const;
 
+        /**
+         * Loads a 2D affine transformation into the matrix.
+         *  Only the upper-left 2x2 and the translation column are
+         *  written, the rest is left as-is.
+         **/
+        void LoadAffine(const affine2x3_t& Affine);
+
         inline const float* GetMatrixPointer() const
         { return reinterpret_cast<const float*>(m_values); }
 
@@ -0,0 +1,133 @@
+/**
+ * @file
+ *  Utils/Profiler.hpp - Declares the CProfiler class and the scoped
+ *  profiling macros.
+ *
+ * @author      George Kudrayvtsev (halcyon)
+ * @version     1.0
+ * @copyright   Apache License v2.0
+ *  Licensed under the Apache License, Version 2.0 (the "License").\n
+ *  You may not use this file except in compliance with the License.\n
+ *  You may obtain a copy of the License at:
+ *  http://www.apache.org/licenses/LICENSE-2.0 \n
+ *  Unless required by applicable law or agreed to in writing, software\n
+ *  distributed under the License is distributed on an "AS IS" BASIS,\n
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.\n
+ *  See the License for the specific language governing permissions and\n
+ *  limitations under the License.
+ *
+ * @addtogroup Utilities
+ * @{
+ **/
+
+#ifndef IRON_CLAD__UTILS__PROFILER_HPP
+#define IRON_CLAD__UTILS__PROFILER_HPP
+
+#include "IronClad/Base/Types.hpp"
+
+/**
+ * Profiling macros are compiled out of release builds, unless
+ * IC_PROFILING is defined.
+ *
+ *      void CThing::Update()
+ *      {
+ *          IC_PROFILE_FUNCTION();
+ *          ...
+ *          {
+ *              IC_PROFILE_SCOPE("Collision");
+ *              ...
+ *          }
+ *      }
+ **/
+#if defined(_DEBUG) || defined(IC_PROFILING)
+  #define IC_PROFILE_JOIN2(a, b) a##b
+  #define IC_PROFILE_JOIN(a, b) IC_PROFILE_JOIN2(a, b)
+  #define IC_PROFILE_SCOPE(name) \
+    ic::util::CProfileScope IC_PROFILE_JOIN(ic_profile_, __LINE__)(name)
+  #define IC_PROFILE_FUNCTION() IC_PROFILE_SCOPE(__FUNCTION__)
+#else
+  #define IC_PROFILE_SCOPE(name)
+  #define IC_PROFILE_FUNCTION()
+#endif // _DEBUG || IC_PROFILING
+
+namespace ic
+{
+namespace util
+{
+    /**
+     * Records nested timings and saves them as a Chrome trace.
+     *  Every thread records into its own buffer, so recording never
+     *  takes a lock; only a thread's first event does, to register
+     *  its buffer. Timings are written to a JSON file that can be
+     *  opened in chrome://tracing or ui.perfetto.dev, where each
+     *  thread shows up as its own track.
+     *
+     *  Names aren't copied, so they must outlive the profiler (string
+     *  literals and __FUNCTION__ are fine). Save() and Clear() read
+     *  every thread's buffer, so only call them while no other thread
+     *  is recording, such as between frames or at shutdown.
+     *
+     * @see IC_PROFILE_SCOPE
+     **/
+    class IRONCLAD_API CProfiler
+    {
+    public:
+        static const uint32_t MAX_EVENTS = 1 << 18; // Per thread
+        static const uint8_t  MAX_DEPTH  = 64;
+
+        /**
+         * A monotonic clock, in microseconds.
+         **/
+        static uint64_t GetTime();
+
+        /**
+         * Starts timing something on the calling thread.
+         *  Events past MAX_EVENTS or MAX_DEPTH are dropped.
+         **/
+        static void Begin(const char* pname);
+
+        /**
+         * Stops timing the last thing started on the calling thread.
+         **/
+        static void End();
+
+        /**
+         * Writes every finished event to a Chrome trace file.
+         *
+         * @param   char*   File to (over)write
+         *
+         * @return  TRUE if the file was written, FALSE otherwise.
+         **/
+        static bool Save(const char* pfilename);
+
+        /**
+         * Throws away every finished event.
+         **/
+        static void Clear();
+
+    private:
+        CProfiler();
+    };
+
+    /**
+     * Times the scope it's declared in, see IC_PROFILE_SCOPE.
+     **/
+    class CProfileScope
+    {
+    public:
+        explicit CProfileScope(const char* pname)
+        { CProfiler::Begin(pname); }
+
+        ~CProfileScope()
+        { CProfiler::End(); }
+
+    private:
+        CProfileScope(const CProfileScope&);
+        void operator=(const CProfileScope&);
+    };
+}   // namespace util
+}   // namespace ic
+
+#endif // IRON_CLAD__UTILS__PROFILER_HPP
+
+/** @} **/
@@ -64,7 +64,7 @@ namespace util
         **/
         void Start()
         {
-            m_started = glfwGetTime();
+            m_started = CTimer::GetTimeElapsed();
         }
 
         /**
@@ -76,7 +76,7 @@ namespace util
         double GetElapsed()
         {
             double old_time = m_started;
-            m_started = glfwGetTime();
+            m_started = CTimer::GetTimeElapsed();
             return m_started - old_time;
         }
 
@@ -96,9 +96,9 @@ namespace util
 
         /**
          * Retrieves the amount of time (in sec) since the program started.
+         *  This doesn't need GLFW, so it works with a CHeadlessWindow.
          */
-        static inline double GetTimeElapsed()
-        { return glfwGetTime(); }
+        static double GetTimeElapsed();
 
         inline int GetFramerate() const
         { return m_framerate; }
@@ -4,6 +4,7 @@
  **/
 
 #include "IronClad/Asset/Mesh.hpp"
+#include "IronClad/Utils/Profiler.hpp"
 
 using namespace ic;
 using asset::CMesh;
@@ -11,6 +12,7 @@ using util::g_Log;
 
 CMesh::~CMesh()
 {
+    this->Evict();
     this->Release();
 }
 
@@ -21,12 +23,17 @@ CMesh& ic::asset::CMesh::operator=(const CMesh& Copy)
 
     m_icount = Copy.m_icount;
     m_vcount = Copy.m_vcount;
+    m_Min    = Copy.m_Min;
+    m_Max    = Copy.m_Max;
+    m_Outline= Copy.m_Outline;
 
     return (*this);
 }
 
 bool CMesh::LoadFromFile(const char* pfilename)
 {
+    IC_PROFILE_FUNCTION();
+
     std::ifstream   file;
     std::string     line;
 
@@ -155,6 +162,7 @@ bool CMesh::LoadFromFile(const char* pfilename)
     m_filename  = pfilename;
     m_vcount    = m_vBuffer.size();
     m_icount    = m_iBuffer.size();
+    this->CalculateBounds();
 
     return true;
 }
@@ -285,6 +293,7 @@ bool CMesh::LoadFromStr(const char** data, const int size)
     m_filename.clear();
     m_vcount    = m_vBuffer.size();
     m_icount    = m_iBuffer.size();
+    this->CalculateBounds();
 
     return true;
 }
@@ -417,6 +426,7 @@ bool CMesh::LoadFromExisting(std::ifstream& file,
     // Assign final attributes.
     m_vcount    = m_vBuffer.size();
     m_icount    = m_iBuffer.size();
+    this->CalculateBounds();
 
     return true;
 }
@@ -428,6 +438,15 @@ bool CMesh::LoadFromExisting(std::ifstream& file,
 bool CMesh::LoadFromRaw(
     const vertex2_t* pvertices, const uint32_t vsize,
     const uint16_t*  pindices,  const uint32_t isize)
+{
+    std::vector<uint32_t> Indices(pindices, pindices + isize);
+    return this->LoadFromRaw(pvertices, vsize,
+                             Indices.empty() ? NULL : &Indices[0], isize);
+}
+
+bool CMesh::LoadFromRaw(
+    const vertex2_t* pvertices, const uint32_t vsize,
+    const uint32_t*  pindices,  const uint32_t isize)
 {
     this->Clear();
 
@@ -444,46 +463,59 @@ bool CMesh::LoadFromRaw(
 
     m_vcount = vsize;
     m_icount = isize;
+    this->CalculateBounds();
     return true;
 }
 
 bool CMesh::Offload(gfx::CVertexBuffer& VBO)
 {
-    std::vector<uint16_t>&  ibo_buffer = VBO.GetIndexBufferVec();
-    std::vector<vertex2_t>& vbo_buffer = VBO.GetVertexBufferVec();
+    // Already uploaded, another instance is just re-using it.
+    if(mp_Resident == &VBO) return true;
 
     // Verify that a mesh has been loaded.
     if(m_vBuffer.empty() || m_iBuffer.empty()) return false;
 
+    // Indices are local to the mesh, so 16-bit ones only fall short
+    // when the mesh itself is too big for them.
+    if(VBO.GetIndexType() != GL_UNSIGNED_INT && m_vcount > 0x10000)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Mesh has " << m_vcount << " vertices, which ";
+        g_Log << "needs 32-bit indices (see CScene::UseWideIndices()).\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    // Find room for the mesh in the VBO.
+    if(!VBO.Allocate(m_vcount, m_icount, m_Range)) return false;
+
     // Calculate the index offset for the various surfaces.
     // This is important to track, as when the mesh is rendered,
     // glDrawElements will use this information to draw the 
     // proper number of vertices.
     // 
     // For example, if the surface's local starting point is at the
-    // index 8, and the local buffer gets added to the global buffer
-    // after index 32, the local buffer's new starting point is index 40.
-    uint32_t start = ibo_buffer.size() + VBO.GetICount();
+    // index 8, and the mesh's range starts at index 32, the surface's
+    // new starting point is index 40.
+    //
+    // Indices stay local to the mesh, the draw call adds the base
+    // vertex instead. That way 16-bit indices only have to address
+    // this mesh, not the whole buffer.
     for(size_t i = 0; i < mp_Surfaces.size(); ++i)
-        mp_Surfaces[i]->start += start;
-
-    // Load the local indices in the VBO's index buffer.
-    ibo_buffer.reserve(ibo_buffer.size() + m_icount);
-    for(size_t i = 0; i < m_icount; ++i)
     {
-        if(start) m_iBuffer[i] += vbo_buffer.size() + VBO.GetVCount();
-        ibo_buffer.push_back(m_iBuffer[i]);
+        mp_Surfaces[i]->start += m_Range.istart;
+        mp_Surfaces[i]->base   = m_Range.vstart;
     }
 
-    // Repeat process for local vertices.
-    vbo_buffer.reserve(vbo_buffer.size() + m_vcount);
-    for(size_t i = 0; i < m_vcount; ++i)
-        vbo_buffer.push_back(m_vBuffer[i]);
+    VBO.Upload(m_Range, &m_vBuffer[0], &m_iBuffer[0]);
 
     // Delete the local buffers.
     m_iBuffer.clear();
     m_vBuffer.clear();
 
+    mp_Resident = &VBO;
+    VBO.AddResident(this);
+
     this->SetOwner(&VBO);
     return true;
 }
@@ -513,7 +545,7 @@ void CMesh::MergeSurfaces()
     // |------S1M1------|--S2M2--|
     // [0, 1, 3, 1, 2, 3, 3, 1, 2]
     
-    std::vector<uint16_t>           alignedIndices;
+    std::vector<uint32_t>           alignedIndices;
     std::vector<gfx::surface_t*>    alignedSurfaces;
 
     // The current material we're merging.
@@ -524,6 +556,7 @@ void CMesh::MergeSurfaces()
 
     // Since first, surface starts at index 0 and uses current material.
     pAligned->start     = 0;
+    pAligned->base      = 0;
     pAligned->icount    = 0;
     pAligned->pMaterial = pActiveMat;
 
@@ -556,6 +589,7 @@ void CMesh::MergeSurfaces()
             pAligned            = new gfx::surface_t;
             pAligned->start     = alignedSurfaces.back()->start + 
                 alignedSurfaces.back()->icount;
+            pAligned->base      = 0;
             pAligned->icount    = mp_Surfaces[i]->icount;
             pAligned->pMaterial = pActiveMat;
         }
@@ -595,6 +629,7 @@ bool CMesh::LoadSurface(const char** lines, const uint32_t s,
     bool success = true;
 
     // Calculate this surface's starting offset.
+    pSurface->base  = 0;
     pSurface->start = 0;
     for(size_t i = 0; i < mp_Surfaces.size(); ++i)
         pSurface->start += mp_Surfaces[i]->icount;
@@ -676,6 +711,7 @@ bool CMesh::LoadSurface(std::ifstream& file,
     bool success = false;
 
     // Calculate this surface's starting offset.
+    pSurface->base  = 0;
     pSurface->start = 0;
     for(size_t i = 0; i < mp_Surfaces.size(); ++i)
         pSurface->start += mp_Surfaces[i]->icount;
@@ -749,32 +785,62 @@ void CMesh::Release()
 
 int CMesh::GetMeshWidth() const
 {
-    int max_value = 0, min_value = 0;
-
-    for(size_t i = 0; i < m_vBuffer.size(); ++i)
-    {
-        max_value = math::max<int>(max_value, m_vBuffer[i].Position.x);
-        min_value = math::min<int>(min_value, m_vBuffer[i].Position.x);
-    }
-
-    return (max_value - min_value);
+    return math::max<int>(0, m_Max.x) - math::min<int>(0, m_Min.x);
 }
 
 int CMesh::GetMeshHeight() const
 {
-    int max_value = 0, min_value = 0;
+    return math::max<int>(0, m_Max.y) - math::min<int>(0, m_Min.y);
+}
+
+void CMesh::CalculateBounds()
+{
+    m_Min = m_Max = math::vector2_t(0.f, 0.f);
+    m_Outline.clear();
+    if(m_vBuffer.empty()) return;
 
-    for(size_t i = 0; i < m_vBuffer.size(); ++i)
+    m_Min = m_Max = m_vBuffer[0].Position;
+    for(size_t i = 1; i < m_vBuffer.size(); ++i)
     {
-        max_value = math::max<int>(max_value, m_vBuffer[i].Position.y);
-        min_value = math::min<int>(min_value, m_vBuffer[i].Position.y);
+        const math::vector2_t& Pos = m_vBuffer[i].Position;
+        m_Min.x = math::min<float>(m_Min.x, Pos.x);
+        m_Min.y = math::min<float>(m_Min.y, Pos.y);
+        m_Max.x = math::max<float>(m_Max.x, Pos.x);
+        m_Max.y = math::max<float>(m_Max.y, Pos.y);
     }
 
-    return (max_value - min_value);
+    // The outline is every vertex the indices touch, in buffer order,
+    // which is clock-wise for the meshes IronClad loads. Shadows are
+    // cast from it, so the GPU copy never has to be read back.
+    if(m_iBuffer.empty()) return;
+
+    uint32_t mindex = m_iBuffer[0], maxdex = m_iBuffer[0];
+    for(size_t i = 1; i < m_iBuffer.size(); ++i)
+    {
+        mindex = math::min<uint32_t>(mindex, m_iBuffer[i]);
+        maxdex = math::max<uint32_t>(maxdex, m_iBuffer[i]);
+    }
+
+    if(maxdex >= m_vBuffer.size()) return;
+
+    m_Outline.reserve(maxdex - mindex + 1);
+    for(size_t i = mindex; i <= maxdex; ++i)
+        m_Outline.push_back(m_vBuffer[i].Position);
+}
+
+void CMesh::Evict()
+{
+    if(mp_Resident == NULL) return;
+
+    mp_Resident->Free(m_Range);
+    mp_Resident->RemoveResident(this);
+    mp_Resident = NULL;
 }
 
 void CMesh::Clear()
 {
+    this->Evict();
+
     for(size_t i = 0; i < mp_Surfaces.size(); ++i) delete mp_Surfaces[i];
 
     mp_Surfaces.clear();
@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "IronClad/Asset/Shader.hpp"
 
 using namespace ic;
@@ -18,8 +20,6 @@ bool CShader::LoadFromFile(const char* pfilename)
 
     std::ifstream   file;
     std::string     source, line;
-    uint32_t        shader;
-    int             length;
 
     // Load shader source file.
     file.open(pfilename);
@@ -39,13 +39,29 @@ bool CShader::LoadFromFile(const char* pfilename)
     }
 
     file.close();
-    const char* psrc = source.c_str();
+
+    if(!this->LoadFromStr(source.c_str(), type))
+    {
+        util::g_Log.Flush();
+        util::g_Log << "[ERROR] Failed to compile " << pfilename << "\n";
+        util::g_Log << "[ERROR] OpenGL error: " << m_error_str << "\n";
+        util::g_Log.PrintLastLog();
+        return false;
+    }
+
+    m_filename  = pfilename;
+    return true;
+}
+
+bool CShader::LoadFromStr(const char* psrc, const int type)
+{
+    if(psrc == NULL) return false;
 
     // Create shader.
-    shader = glCreateShader(type);
+    uint32_t shader = glCreateShader(type);
 
     // Compile shader.
-    length = source.length();
+    int length = strlen(psrc);
     glShaderSource(shader, 1, &psrc, &length);
     glCompileShader(shader);
 
@@ -69,16 +85,10 @@ bool CShader::LoadFromFile(const char* pfilename)
 
         m_error_str = buf;
         delete[] buf;
-
-        util::g_Log.Flush();
-        util::g_Log << "[ERROR] Failed to compile " << pfilename << "\n";
-        util::g_Log << "[ERROR] OpenGL error: " << m_error_str << "\n";
-        util::g_Log.PrintLastLog();
         return false;
     }
 
-    m_shader    = shader;
-    m_filename  = pfilename;
+    m_shader = shader;
     return true;
 }
 
@@ -1,4 +1,5 @@
 #include "IronClad/Asset/Sound2D.hpp"
+#include "IronClad/Utils/Profiler.hpp"
 
 using namespace ic;
 using asset::CSound2D;
@@ -93,6 +94,8 @@ void CSound2D::GetAvailableSource()
 
 bool CSound2D::LoadFromFile(const std::string& filename)
 {
+    IC_PROFILE_FUNCTION();
+
     /// Buffer size for .ogg decoding (32 bytes).
     static const int BUFFER_SIZE = 32768;
 
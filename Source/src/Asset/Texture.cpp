@@ -14,6 +14,12 @@ CTexture& CTexture::operator=(const CTexture& Copy)
     m_texture   = Copy.GetTextureID();
     m_height    = Copy.GetH();
     m_width     = Copy.GetW();
+    m_opaque    = Copy.IsOpaque();
+
+    // Copies don't own the stand-alone texture either way, they just
+    // need to know where in the page to look.
+    m_standalone = Copy.m_standalone;
+    for(uint8_t i = 0; i < 4; ++i) m_region[i] = Copy.m_region[i];
 
     return (*this);
 }
@@ -39,12 +45,13 @@ bool CTexture::LoadFromFile(const char* pfilename)
     }
 
     // Sets up some texture parameters and determines dimensions.
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    gfx::CGLState::BindTexture(m_texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  &m_width);
     glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &m_height);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    this->QueryOpacity();
+    gfx::CGLState::BindTexture(0);
 
     m_filename = pfilename;
     return true;
@@ -55,7 +62,11 @@ void CTexture::Release()
     if(m_original)
     {
         CAsset::Release();
-        glDeleteTextures(1, &m_texture);
+
+        // Atlas pages belong to the atlas.
+        uint32_t& texture = this->IsAtlased() ? m_standalone : m_texture;
+        gfx::CGLState::ForgetTexture(texture);
+        glDeleteTextures(1, &texture);
     }
 }
 
@@ -64,6 +75,14 @@ bool CTexture::LoadFromRaw(const int iformat,
                            const int w, const int h,
                            const unsigned char* buffer )
 {
+    // New pixels don't fit the atlas region, so go back to our own.
+    if(this->IsAtlased())
+    {
+        m_texture = m_standalone;
+        m_standalone = 0;
+        m_region[0] = m_region[1] = 0.f; m_region[2] = m_region[3] = 1.f;
+    }
+
     if(m_texture == 0) glGenTextures(1, &m_texture);
 
     this->Bind();
@@ -73,6 +92,7 @@ bool CTexture::LoadFromRaw(const int iformat,
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);    
     glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  &m_width);
     glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &m_height);
+    this->QueryOpacity();
     this->Unbind();
 
     return true;
@@ -89,13 +109,13 @@ bool ic::asset::CTexture::LoadFromTexture(const uint32_t texture,
     if(copy)
     {
         int w, h;
-        glBindTexture(GL_TEXTURE_2D, texture);
+        gfx::CGLState::BindTexture(texture);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  &w);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
 
         unsigned char* data = new unsigned char[w * h * 4];
         glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        gfx::CGLState::BindTexture(0);
 
         // Since we made a new texture, we need to make sure it gets 
         // cleaned up properly by the asset manager.
@@ -106,6 +126,13 @@ bool ic::asset::CTexture::LoadFromTexture(const uint32_t texture,
     }
     else
     {
+        // The region was for the atlas page, the new texture is whole.
+        if(this->IsAtlased())
+        {
+            m_standalone = 0;
+            m_region[0] = m_region[1] = 0.f; m_region[2] = m_region[3] = 1.f;
+        }
+
         m_texture = texture;
 
         this->Bind();
@@ -113,8 +140,16 @@ bool ic::asset::CTexture::LoadFromTexture(const uint32_t texture,
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH,  &m_width);
         glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &m_height);
+        this->QueryOpacity();
         this->Unbind();
     }
 
     return true;
 }
+
+void CTexture::QueryOpacity()
+{
+    int alpha = 0;
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_ALPHA_SIZE, &alpha);
+    m_opaque = (alpha == 0);
+}
@@ -0,0 +1,190 @@
+#include <cstring>
+
+#include "IronClad/Math/MathDef.hpp"
+#include "IronClad/Asset/TextureAtlas.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+
+using namespace ic;
+using asset::CTextureAtlas;
+using util::g_Log;
+
+CTextureAtlas::CTextureAtlas(const uint16_t size, const uint8_t padding) :
+    m_size(size), m_padding(padding) {}
+
+CTextureAtlas::~CTextureAtlas()
+{
+    for(size_t i = 0; i < m_Pages.size(); ++i)
+    {
+        gfx::CGLState::ForgetTexture(m_Pages[i].texture);
+        glDeleteTextures(1, &m_Pages[i].texture);
+    }
+}
+
+bool CTextureAtlas::Add(asset::CTexture* pTexture)
+{
+    if(pTexture == NULL || pTexture->IsAtlased() ||
+       pTexture->GetTextureID() == 0) return false;
+
+    const int w = pTexture->GetW(), h = pTexture->GetH();
+    const int pw = w + m_padding * 2, ph = h + m_padding * 2;
+
+    if(w <= 0 || h <= 0 || pw > m_size || ph > m_size) return false;
+
+    // Try every page before starting a new one.
+    uint16_t x = 0, y = 0;
+    size_t page = 0;
+    for( ; page < m_Pages.size(); ++page)
+    {
+        if(this->Fit(m_Pages[page], pw, ph, x, y)) break;
+    }
+
+    if(page == m_Pages.size() &&
+      (!this->AddPage() || !this->Fit(m_Pages.back(), pw, ph, x, y)))
+    {
+        return false;
+    }
+
+    // Read the image back and surround it with copies of its edges.
+    m_pixels.resize(w * h * 4);
+    m_padded.resize(pw * ph * 4);
+
+    gfx::CGLState::BindTexture(pTexture->GetTextureID());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, &m_pixels[0]);
+
+    for(int py = 0; py < ph; ++py)
+    {
+        int sy = math::min<int>(h - 1, math::max<int>(0, py - m_padding));
+        for(int px = 0; px < pw; ++px)
+        {
+            int sx = math::min<int>(w - 1, math::max<int>(0, px - m_padding));
+            memcpy(&m_padded[(py * pw + px) * 4],
+                   &m_pixels[(sy * w + sx) * 4], 4);
+        }
+    }
+
+    gfx::CGLState::BindTexture(m_Pages[page].texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, pw, ph,
+                    GL_RGBA, GL_UNSIGNED_BYTE, &m_padded[0]);
+    gfx::CGLState::BindTexture(0);
+
+    // Point the texture at its spot in the page.
+    pTexture->m_standalone  = pTexture->m_texture;
+    pTexture->m_texture     = m_Pages[page].texture;
+    pTexture->m_region[0]   = float(x + m_padding) / m_size;
+    pTexture->m_region[1]   = float(y + m_padding) / m_size;
+    pTexture->m_region[2]   = float(w) / m_size;
+    pTexture->m_region[3]   = float(h) / m_size;
+
+    return true;
+}
+
+bool CTextureAtlas::Fit(page_t& Page, const uint16_t w, const uint16_t h,
+                        uint16_t& x, uint16_t& y) const
+{
+    std::vector<skyline_t>& Sky = Page.Skyline;
+
+    // Find the segment where the rectangle sits lowest, preferring
+    // narrower segments to keep wide gaps for wide textures.
+    size_t best = Sky.size();
+    uint32_t best_y = m_size, best_w = m_size;
+
+    for(size_t i = 0; i < Sky.size(); ++i)
+    {
+        if(uint32_t(Sky[i].x) + w > m_size) break;
+
+        // The rectangle rests on the highest segment under it.
+        uint32_t top = 0;
+        int32_t left = w;
+        for(size_t j = i; j < Sky.size() && left > 0; ++j)
+        {
+            top   = math::max<uint32_t>(top, Sky[j].y);
+            left -= Sky[j].w;
+        }
+
+        if(top + h > m_size) continue;
+        if(top < best_y || (top == best_y && Sky[i].w < best_w))
+        {
+            best    = i;
+            best_y  = top;
+            best_w  = Sky[i].w;
+        }
+    }
+
+    if(best == Sky.size()) return false;
+
+    x = Sky[best].x;
+    y = best_y;
+
+    skyline_t Node = { x, uint16_t(y + h), w };
+    Sky.insert(Sky.begin() + best, Node);
+
+    // Cut away whatever the new segment now covers.
+    for(size_t i = best + 1; i < Sky.size(); )
+    {
+        skyline_t& Next = Sky[i];
+        if(Next.x >= x + w) break;
+
+        uint16_t covered = x + w - Next.x;
+        if(Next.w <= covered)
+        {
+            Sky.erase(Sky.begin() + i);
+            continue;
+        }
+
+        Next.x += covered;
+        Next.w -= covered;
+        break;
+    }
+
+    // Join neighbours at the same height.
+    for(size_t i = 0; i + 1 < Sky.size(); )
+    {
+        if(Sky[i].y == Sky[i + 1].y)
+        {
+            Sky[i].w += Sky[i + 1].w;
+            Sky.erase(Sky.begin() + i + 1);
+        }
+        else ++i;
+    }
+
+    return true;
+}
+
+bool CTextureAtlas::AddPage()
+{
+    page_t Page;
+    skyline_t Floor = { 0, 0, m_size };
+    Page.Skyline.push_back(Floor);
+
+    glGenTextures(1, &Page.texture);
+    gfx::CGLState::BindTexture(Page.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_size, m_size, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    gfx::CGLState::BindTexture(0);
+
+    if(Page.texture == 0 ||
+       gfx::CGLError::Query("CTextureAtlas::AddPage") != GL_NO_ERROR)
+    {
+        gfx::CGLState::ForgetTexture(Page.texture);
+        glDeleteTextures(1, &Page.texture);
+
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to create " << m_size << "x" << m_size;
+        g_Log << " atlas page.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] Created atlas page " << m_Pages.size() + 1 << ".\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    m_Pages.push_back(Page);
+    return true;
+}
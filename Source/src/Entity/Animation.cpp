@@ -19,8 +19,6 @@ bool CAnimation::LoadFromFile(const std::string& filename,
         m_SheetDetails.pMesh    = &m_Mesh;
         m_SheetDetails.pTexture = this->GetTexture();
 
-        m_TexcDim = 1.f;
-
         // Rigid body collision.
         m_CollisionBox.w = m_SheetDetails.width;
         m_CollisionBox.h = m_SheetDetails.height;
@@ -46,127 +44,166 @@ bool CAnimation::LoadFromFile(const std::string& filename,
     if(!(header.width && header.height && header.columns))
         return false;
 
-    // Get file size.
-    const std::streampos begin = anim.tellg();
-    anim.seekg(0, std::ios::end);
-    const std::streampos end = anim.tellg();
-    anim.seekg(begin);
-
-    // Texture data.
-    unsigned char* data = new unsigned char[end - begin];
-    anim.read((char*)data, end - begin);
-
-    GLFWimage img;
-    glfwReadMemoryImage(data, end - begin, &img, GLFW_NO_RESCALE_BIT);
-
     uint16_t w = (header.width);
     uint16_t h = (header.height);
 
     uint16_t sprite_w = w / header.columns;
     uint16_t sprite_h = h;
 
-    vertex2_t quad_v[4];
-    uint16_t  quad_i[6] = {0, 1, 3, 3, 2, 1};
-
-    m_TexcDim = 1.f / header.columns;
+    // Every animation loaded from this file shares the sheet, so they
+    // can all be batched together.
+    asset::CTexture* pTexture = (asset::CTexture*)
+        asset::CAssetManager::Find(filename);
 
-    quad_v[0].Position = math::vector2_t(0,         0);
-    quad_v[1].Position = math::vector2_t(sprite_w,  0);
-    quad_v[2].Position = math::vector2_t(sprite_w,  sprite_h);
-    quad_v[3].Position = math::vector2_t(0,         sprite_h);
+    if(pTexture == NULL)
+    {
+        // Get file size.
+        const std::streampos begin = anim.tellg();
+        anim.seekg(0, std::ios::end);
+        const std::streampos end = anim.tellg();
+        anim.seekg(begin);
+
+        // Texture data.
+        unsigned char* data = new unsigned char[end - begin];
+        anim.read((char*)data, end - begin);
+
+        GLFWimage img;
+        glfwReadMemoryImage(data, end - begin, &img, GLFW_NO_RESCALE_BIT);
+        delete[] data;
+
+        g_Log.Flush();
+        g_Log << "[INFO] Loading animation file: " << filename << "\n";
+        g_Log.PrintLastLog();
+
+        g_Log.Flush();
+        g_Log << "[DEBUG] Expecting " << (w / sprite_w) * (h / sprite_h);
+        g_Log << " sprite(s).\n";
+        g_Log.PrintLastLog();
+
+        pTexture = asset::CAssetManager::Create<asset::CTexture>();
+        pTexture->SetFilename(filename);
+        pTexture->LoadFromRaw(img.Format, img.Format, w, h, img.Data);
+
+        glfwFreeImage(&img);
+    }
 
-    quad_v[0].TexCoord = math::vector2_t(0.f,   1.f);
-    quad_v[1].TexCoord = math::vector2_t(1.f,   1.f);
-    quad_v[2].TexCoord = math::vector2_t(1.f,   0.f);
-    quad_v[3].TexCoord = math::vector2_t(0.f,   0.f);
+    header.pTexture = pTexture;
 
-    g_Log.Flush();
-    g_Log << "[INFO] Loading animation file: " << filename << "\n";
-    g_Log.PrintLastLog();
+    // Same goes for the quad.
+    asset::CMesh* pMesh = (asset::CMesh*)
+        asset::CAssetManager::Find(filename + ":Sheet", &VBO);
 
-    g_Log.Flush();
-    g_Log << "[DEBUG] Expecting " << (w / sprite_w) * (h / sprite_h);
-    g_Log << " sprite(s).\n";
-    g_Log.PrintLastLog();
+    if(pMesh == NULL)
+    {
+        vertex2_t quad_v[4];
+        uint16_t  quad_i[6] = {0, 1, 3, 3, 2, 1};
 
-    std::stringstream ss;
+        quad_v[0].Position = math::vector2_t(0,         0);
+        quad_v[1].Position = math::vector2_t(sprite_w,  0);
+        quad_v[2].Position = math::vector2_t(sprite_w,  sprite_h);
+        quad_v[3].Position = math::vector2_t(0,         sprite_h);
 
-    asset::CTexture* pTexture = asset::CAssetManager::Create<asset::CTexture>();
-    pTexture->SetFilename(filename);
-    pTexture->LoadFromRaw(img.Format, img.Format, w, h, img.Data);
-    header.pTexture = pTexture;
+        quad_v[0].TexCoord = math::vector2_t(0.f,   1.f);
+        quad_v[1].TexCoord = math::vector2_t(1.f,   1.f);
+        quad_v[2].TexCoord = math::vector2_t(1.f,   0.f);
+        quad_v[3].TexCoord = math::vector2_t(0.f,   0.f);
 
-    glfwFreeImage(&img);
+        pMesh = asset::CAssetManager::Create<asset::CMesh>(&VBO);
+        if(!pMesh->LoadFromRaw(quad_v, 4, quad_i, 6)) return false;
 
-    // Load mesh
-    m_Mesh.LoadMesh(quad_v, 4, quad_i, 6);
-
-    gfx::CShaderPair* pShader = m_Mesh.GetSurfaces()[0]->pMaterial->pShader;
-    if(pShader == NULL)
-    {
-        pShader = new gfx::CShaderPair;
-        if(!pShader->LoadFromFile("Shaders/Default.vs", "Shaders/Animate.fs"))
-            return false;
+        pMesh->SetFilename(filename + ":Sheet");
     }
-    
-    // The shader contains an offset so that the texture coordinates
-    // can be shifted to reflect the current sprite.
-    pShader->Bind();
-    m_tc_loc = pShader->GetUniformLocation("tc_offset");
-    m_tc_str = pShader->GetUniformLocation("tc_start");
-    glUniform1f(m_tc_loc, m_TexcDim);
-    pShader->Unbind();
-
-    // Load whole atlas into surface, then load custom shader.
-    m_Mesh.GetSurfaces()[0]->pMaterial->pTexture = pTexture;
-    m_Mesh.GetSurfaces()[0]->pMaterial->pShader = pShader;
 
     // Rigid body collision.
     m_CollisionBox.w = m_SheetDetails.width  / m_SheetDetails.columns;
     m_CollisionBox.h = m_SheetDetails.height;
 
-    return m_Mesh.LoadIntoVBO(VBO);
+    m_start = util::CTimer::GetTimeElapsed();
+    m_first = 0;
+
+    if(!this->LoadFromMesh(pMesh, VBO)) return false;
+
+    // Load whole sheet into surface, the sprite batch picks the sprite
+    // out of it.
+    m_Mesh.GetSurfaces()[0]->pMaterial->pTexture = pTexture;
+    return true;
 }
 
 bool CAnimation::NextSprite()
 {
-    if(++m_active >= this->GetAnimationCount())
+    this->Rebase();
+
+    if(++m_first >= this->GetAnimationCount())
     {
         ++m_loops_done;
-        m_active = 0;
+        m_first = 0;
     }
 
-#ifdef _DEBUG
-    //util::g_Log.Flush();
-    //util::g_Log << "[DEBUG] Rendering texture[" << (int)m_active << "]: ";
-    //util::g_Log << m_Mesh.GetSurfaces()[0]->pMaterial->pTexture->GetFilename() << "\n";
-    //util::g_Log.PrintLastLog();
-#endif // _DEBUG
+    return (m_first > 0);
+}
 
-    //printf("Sprite index: %d\n", m_active);
+bool CAnimation::PrevSprite()
+{
+    this->Rebase();
 
-    // Adjust for current texture
-    gfx::CShaderPair* pShader = m_Mesh.GetSurfaces()[0]->pMaterial->pShader;
-    pShader->Bind();
-    glUniform2f(m_tc_str, m_active * m_TexcDim, m_active);
-    pShader->Unbind();
+    if(m_first == 0)
+    {
+        m_first = this->GetAnimationCount() - 1;
+        return false;
+    }
+
+    --m_first;
+    return true;
+}
 
-    return (m_active > 0);
+bool CAnimation::LoadSpriteFrame(float* pFrame) const
+{
+    pFrame[0] = math::max<uint16_t>(1, this->GetAnimationCount());
+    pFrame[1] = m_enabled ? m_delay : 0.f;
+    pFrame[2] = (float)m_start;
+    pFrame[3] = m_first;
+    return (pFrame[0] > 1.f);
+}
+
+uint32_t CAnimation::GetLoopCount() const
+{
+    uint32_t loops = 0;
+    this->GetFrame(&loops);
+    return m_loops_done + loops;
 }
 
-void CAnimation::Update()
+uint8_t CAnimation::GetFrame(uint32_t* pLoops) const
 {
-    CRigidBody::Update();
+    uint32_t count = math::max<uint16_t>(1, this->GetAnimationCount());
+    uint32_t frame = m_first;
 
-    if(util::CTimer::GetTimeElapsed() - m_last >= m_delay && m_enabled)
+    if(m_enabled && m_delay > 0.f)
     {
-        this->NextSprite();
-        m_last = util::CTimer::GetTimeElapsed();
+        double elapsed = util::CTimer::GetTimeElapsed() - m_start;
+        frame += (uint32_t)math::max<double>(0.0, elapsed / m_delay);
     }
+
+    if(pLoops != NULL) *pLoops = frame / count;
+    return frame % count;
+}
+
+void CAnimation::Rebase()
+{
+    uint32_t loops = 0;
+    m_first = this->GetFrame(&loops);
+    m_loops_done += loops;
+    m_start = util::CTimer::GetTimeElapsed();
+}
+
+void CAnimation::EnableAnimation(bool flag)
+{
+    this->Rebase();
+    m_enabled = flag;
 }
 
 void CAnimation::SetAnimationRate(const float delta)
 {
+    this->Rebase();
     m_delay = delta;
 }
 
@@ -179,18 +216,14 @@ void CAnimation::SwapSpriteSheet(const AnimationHeader& Header)
     math::vector2_t Pos = m_Mesh.GetPosition();
     math::vector2_t Dim = m_Mesh.GetDimensions();
 
+    this->Rebase();
+
     m_Mesh = *Header.pMesh;
     m_Mesh.Move(Pos + (Dim - m_Mesh.GetDimensions()));
     m_Mesh.GetSurfaces()[0]->pMaterial->pTexture = Header.pTexture;
     m_SheetDetails  = Header;
-    m_TexcDim       = 1.f / Header.columns;
+    m_first        %= math::max<uint16_t>(1, Header.columns);
     m_loops_done    = 0;
-
-    // Adjust for new texture dimensions.
-    gfx::CShaderPair* pShader = m_Mesh.GetSurfaces()[0]->pMaterial->pShader;
-    pShader->Bind();
-    glUniform1f(m_tc_loc, m_TexcDim);
-    pShader->Unbind();
 }
 
 void CAnimation::SwapSpriteSheet(const CAnimation* pAnimation)
@@ -200,6 +233,7 @@ void CAnimation::SwapSpriteSheet(const CAnimation* pAnimation)
 
 void CAnimation::SetAnimation(const uint8_t index)
 {
-    m_active = (math::min<int>(index, this->GetAnimationCount()))-2;
-    this->NextSprite(); 
+    this->Rebase();
+    m_first = math::max<int>(1, math::min<int>(index,
+                             this->GetAnimationCount())) - 1;
 }
@@ -1,3 +1,5 @@
+#include <sstream>
+
 #include "IronClad/Entity/Entity.hpp"
 
 using namespace ic;
@@ -61,6 +63,9 @@ void CEntity::Adjust(const float dx, const float dy)
 void CEntity::SetMaterialOverride(asset::CTexture* pTexture)
 {
     mp_Override = pTexture;
+
+    // Baked chunks are keyed on the texture.
+    m_Mesh.Invalidate();
 }
 
 bool CEntity::LoadFromImage(const char* pimg_name,
@@ -83,9 +88,24 @@ bool CEntity::LoadFromImage(const char* pimg_name,
     v[1].TexCoord = math::vector2_t(1, 1);
     v[2].TexCoord = math::vector2_t(1, 0);
     v[3].TexCoord = math::vector2_t(0, 0);
-    
-    asset::CMesh* pMesh = asset::CAssetManager::Create<asset::CMesh>(&VBO);
 
     this->SetMaterialOverride(pTGA);
-    return pMesh->LoadFromRaw(v, 4, i, 6) && this->LoadFromMesh(pMesh, VBO);
+
+    // Images of the same size share a quad, so that sprites using
+    // textures from the same atlas page can be batched together.
+    std::stringstream name;
+    name << pTGA->GetW() << "x" << pTGA->GetH() << ":Quad";
+
+    asset::CMesh* pMesh = (asset::CMesh*)
+        asset::CAssetManager::Find(name.str(), &VBO);
+
+    if(pMesh == NULL)
+    {
+        pMesh = asset::CAssetManager::Create<asset::CMesh>(&VBO);
+        if(!pMesh->LoadFromRaw(v, 4, i, 6)) return false;
+
+        pMesh->SetFilename(name.str());
+    }
+
+    return this->LoadFromMesh(pMesh, VBO);
 }
@@ -1,4 +1,5 @@
 #include "IronClad/Entity/QuadTree.hpp"
+#include "IronClad/Utils/Profiler.hpp"
 
 using namespace ic;
 
@@ -213,6 +214,8 @@ void CQuadTree::Print() const
 
 void CQuadTree::Update()
 {
+    IC_PROFILE_FUNCTION();
+
     for(size_t i = 0; i < mp_allBodies.size(); ++i)
     {
         if(mp_allBodies[i]->NeedsUpdate())
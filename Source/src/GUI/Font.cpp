@@ -1,4 +1,5 @@
 #include "IronClad/GUI/Font.hpp"
+#include "IronClad/Utils/Profiler.hpp"
 
 using namespace ic;
 using util::g_Log;
@@ -36,7 +37,8 @@ bool CFont::LoadFromFile(const std::string& filename, const uint16_t size)
     m_FontRender.Disable();
 
     (!m_Cache.GetVBO()) ? m_Cache.Init() : m_Cache.Clear();
-    if(!m_VBO.GetVBO()) m_VBO.Init();
+    // Room for 256 characters a frame, it grows if need be.
+    if(!m_loaded && !m_Stream.Init(256 * 4, 256 * 6)) return false;
 
     g_Log.Flush();
     g_Log << "[INFO] Loading font:      " << filename << "\n";
@@ -135,6 +137,8 @@ bool CFont::LoadFromFile(const std::string& filename, const uint16_t size)
 math::rect_t CFont::RenderText(const std::string& text,
                                math::vector2_t Pos)
 {
+    IC_PROFILE_FUNCTION();
+
     // Track total text size.
     math::rect_t Size(Pos.x, Pos.y, 0, 0);
 
@@ -144,12 +148,13 @@ math::rect_t CFont::RenderText(const std::string& text,
     uint16_t vlen = text.length() << 2;
     uint16_t ilen = text.length() * 6;
 
-    // Create buffers and zero them.
-    vertex2_t* verts = new vertex2_t[vlen];
-    uint16_t*  inds  = new uint16_t [ilen];
+    // Write straight into the GPU's stream buffer. This memory is
+    // write-only, so nothing below may read from verts / inds.
+    vertex2_t* verts = NULL;
+    uint16_t*  inds  = NULL;
+    gfx::geometry_range_t Range;
 
-    memset(inds,  NULL, sizeof(uint16_t)  * ilen);
-    memset(verts, NULL, sizeof(vertex2_t) * vlen);
+    if(!m_Stream.Map(vlen, ilen, verts, inds, Range)) return Size;
 
     // Track width and max height.
     int max_w = 0, max_h = 0;
@@ -225,22 +230,15 @@ math::rect_t CFont::RenderText(const std::string& text,
     Size.w = max_w;
     Size.h = max_h;
 
+    // Done writing.
+    m_Stream.Unmap();
+
     // Enable font-rendering shader.
     m_FontRender.Enable();
+    m_Stream.Bind();
 
-    // Clear the GPU buffers from the last render.
-    // The handle remains valid for the next time around, of course.
-    // If the m_VBO was local in scope, this would cause an immense amount
-    // of lag after a while.
-    m_VBO.Clear();
-
-    // Give data to GPU.
-    m_VBO.AddData(verts, vlen, inds, ilen);
-    m_VBO.FinalizeBuffer();
-    m_VBO.Bind();
-
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gfx::CGLState::EnableBlending(true);
+    gfx::CGLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Draw each character with its texture enabled.
     for(size_t i = 0; i < text.length(); ++i)
@@ -250,21 +248,16 @@ math::rect_t CFont::RenderText(const std::string& text,
         else
             mp_glyphTextures[text[i]].pTexture->Bind();
 
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT,
-            (void*)(sizeof(uint16_t) * i * 6));
+        m_Stream.Draw(Range, i * 6, 6);
     }
 
-    glDisable(GL_BLEND);
+    gfx::CGLState::EnableBlending(false);
 
     // Unbind all the things.
-    glBindTexture(GL_TEXTURE_2D, 0);
-    m_VBO.Unbind();
+    gfx::CGLState::BindTexture(0);
+    m_Stream.Unbind();
     m_FontRender.Disable();
 
-    // Delete old buffers in RAM.
-    delete[] verts;
-    delete[] inds;
-
     m_last_text = text;
     
     return Size;
@@ -277,8 +270,8 @@ math::rect_t CFont::RenderCached()
 
     m_Cache.Bind();
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    gfx::CGLState::EnableBlending(true);
+    gfx::CGLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     // Draw each character with its texture enabled.
     for(size_t i = 0; i < m_last_text.length(); ++i)
@@ -294,10 +287,10 @@ math::rect_t CFont::RenderCached()
             (void*)(sizeof(uint16_t) * i * 6));
     }
 
-    glDisable(GL_BLEND);
+    gfx::CGLState::EnableBlending(false);
 
     // Unbind all the things.
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gfx::CGLState::BindTexture(0);
     m_Cache.Unbind();
     m_FontRender.Disable();
 
@@ -0,0 +1,248 @@
+#include <cstring>
+
+#include "IronClad/Graphics/Batch.hpp"
+#include "IronClad/Graphics/Globals.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+
+using namespace ic;
+using gfx::CSpriteBatch;
+using util::g_Log;
+
+namespace
+{
+    // Built-in batch shaders. Attributes 0-2 match vertex2_t, and
+    // attributes 3-6 are the per-instance data (see gfx::instance_t).
+    const char* s_BatchVS[] = {
+        "#version 330 core",
+        "layout(location = 0) in vec2 in_vert;",
+        "layout(location = 1) in vec2 in_texc;",
+        "layout(location = 2) in vec4 in_color;",
+        "layout(location = 3) in vec4 in_linear;",
+        "layout(location = 4) in vec4 in_region;",
+        "layout(location = 5) in vec4 in_frame;",
+        "layout(location = 6) in vec3 in_pos;",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "smooth out vec2 fs_texc;",
+        "smooth out vec4 fs_color;",
+        "void main()",
+        "{",
+        "    vec2 pos    = mat2(in_linear.xy, in_linear.zw) * in_vert +",
+        "                  in_pos.xy + camera;",
+        "    float frame = in_frame.w;",
+        "    if(in_frame.y > 0.0)",
+        "        frame += floor(max(time - in_frame.z, 0.0) / in_frame.y);",
+        "    vec2 texc   = vec2((in_texc.x + mod(frame, in_frame.x)) / in_frame.x,",
+        "                       in_texc.y);",
+        "    fs_texc     = in_region.xy + texc * in_region.zw;",
+        "    fs_color    = in_color;",
+        "    gl_Position = proj * vec4(pos, in_pos.z, 1.0);",
+        "}",
+        NULL
+    };
+
+    const char* s_BatchFS[] = {
+        "#version 330 core",
+        "uniform sampler2D tex;",
+        "smooth in vec2 fs_texc;",
+        "smooth in vec4 fs_color;",
+        "out vec4 out_color;",
+        "void main()",
+        "{",
+        "    out_color = texture(tex, fs_texc) * fs_color;",
+        "}",
+        NULL
+    };
+}
+
+CSpriteBatch::CSpriteBatch() : m_instance_vbo(0) {}
+
+CSpriteBatch::~CSpriteBatch()
+{
+    if(glDeleteBuffers != NULL && m_instance_vbo != 0)
+        glDeleteBuffers(1, &m_instance_vbo);
+}
+
+bool CSpriteBatch::Init()
+{
+    if(!glDrawElementsInstancedBaseVertex || !glVertexAttribDivisor ||
+       !glUniformBlockBinding)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Instanced rendering is not supported.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    if(!m_Shader.LoadFromSource(s_BatchVS, s_BatchFS)) return false;
+
+    m_Shader.Bind();
+    glUniform1i(m_Shader.GetUniformLocation("tex"), 0);
+    m_Shader.Unbind();
+
+    glGenBuffers(1, &m_instance_vbo);
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] GFX: Created sprite batch.\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    return (gfx::CGLError::Query("CBatch::Init") == GL_NO_ERROR);
+}
+
+bool CSpriteBatch::Add(obj::CEntity* pEntity, const bool wire,
+                       const float z)
+{
+    if(m_instance_vbo == 0) return false;
+
+    const std::vector<gfx::surface_t*>& Surfaces =
+        pEntity->GetMesh().GetSurfaces();
+
+    if(Surfaces.size() != 1) return false;
+
+    gfx::surface_t* pSurface    = Surfaces[0];
+    gfx::material_t* pMaterial  = pSurface->pMaterial;
+
+    // Custom shaders expect the usual "mv" uniform, so can't be batched.
+    if(pMaterial == NULL || pMaterial->pShader != NULL) return false;
+
+    asset::CTexture* pTexture = pEntity->GetTexture();
+    if(wire || pTexture == NULL) pTexture = Globals::g_WhiteTexture;
+
+    batch_key_t Key;
+    Key.texture = pTexture->GetTextureID();
+    Key.start   = pSurface->start;
+    Key.base    = pSurface->base;
+    Key.icount  = pSurface->icount;
+
+    // Find the batch, creating it if this is the first time we've seen
+    // this texture / geometry combination.
+    uint32_t index = 0;
+    std::map<batch_key_t, uint32_t>::iterator i = m_batchIndex.find(Key);
+    if(i == m_batchIndex.end())
+    {
+        index = m_Batches.size();
+        m_Batches.push_back(batch_t());
+        m_Batches.back().Key = Key;
+        m_batchIndex[Key] = index;
+    }
+    else
+    {
+        index = i->second;
+    }
+
+    batch_t& Batch = m_Batches[index];
+    if(Batch.instances.empty()) m_order.push_back(index);
+
+    // Only rebuilt if the entity has changed since it was last drawn.
+    const math::affine2x3_t& World = pEntity->GetMesh().GetWorldTransform();
+    instance_t Instance;
+    memcpy(Instance.linear, World.m, sizeof Instance.linear);
+    Instance.x  = World.m[4];
+    Instance.y  = World.m[5];
+    Instance.z  = z;
+
+    const float* region = pTexture->GetRegion();
+    Instance.u  = region[0];
+    Instance.v  = region[1];
+    Instance.tw = region[2];
+    Instance.th = region[3];
+
+    float frame[4];
+    pEntity->LoadSpriteFrame(frame);
+    Instance.frames = frame[0];
+    Instance.delay  = frame[1];
+    Instance.start  = frame[2];
+    Instance.first  = frame[3];
+
+    Batch.instances.push_back(Instance);
+    return true;
+}
+
+uint32_t CSpriteBatch::Flush(gfx::CVertexBuffer& Geometry,
+                             const uint32_t geo_type)
+{
+    if(m_order.empty()) return 0;
+
+    // Pack every batch's instances into one contiguous buffer.
+    m_packed.clear();
+    for(size_t i = 0; i < m_order.size(); ++i)
+    {
+        const std::vector<instance_t>& Insts = m_Batches[m_order[i]].instances;
+        m_packed.insert(m_packed.end(), Insts.begin(), Insts.end());
+    }
+
+    // Orphan the old storage so we don't stall on the previous frame.
+    glBindBuffer(GL_ARRAY_BUFFER, m_instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(instance_t) * m_packed.size(),
+        NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0,
+        sizeof(instance_t) * m_packed.size(), &m_packed[0]);
+
+    gfx::Counters::bytes_uploaded += sizeof(instance_t) * m_packed.size();
+
+    m_Shader.Bind();
+
+    glEnableVertexAttribArray(3);
+    glEnableVertexAttribArray(4);
+    glEnableVertexAttribArray(5);
+    glEnableVertexAttribArray(6);
+    glVertexAttribDivisor(3, 1);
+    glVertexAttribDivisor(4, 1);
+    glVertexAttribDivisor(5, 1);
+    glVertexAttribDivisor(6, 1);
+
+    uint32_t offset = 0;
+    for(size_t i = 0; i < m_order.size(); ++i)
+    {
+        batch_t& Batch = m_Batches[m_order[i]];
+
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t),
+            VBO_OFFSET(offset, instance_t, linear));
+        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t),
+            VBO_OFFSET(offset, instance_t, u));
+        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(instance_t),
+            VBO_OFFSET(offset, instance_t, frames));
+        glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, sizeof(instance_t),
+            VBO_OFFSET(offset, instance_t, x));
+
+        gfx::CGLState::BindTexture(Batch.Key.texture);
+        gfx::Counters::triangles += Batch.Key.icount / 3 *
+                                    Batch.instances.size();
+
+        glDrawElementsInstancedBaseVertex(
+            geo_type,                                       // Tris, lines, ...
+            Batch.Key.icount,                               // Index count
+            Geometry.GetIndexType(),                        // 16/32-bit indices
+            (void*)(size_t)(Geometry.GetIndexSize() *       // Offset
+                            Batch.Key.start),
+            Batch.instances.size(),                         // Instance count
+            Batch.Key.base);                                // Base vertex
+
+        offset += Batch.instances.size();
+        Batch.instances.clear();
+    }
+
+    uint32_t calls = m_order.size();
+    m_order.clear();
+
+    // Leave the geometry VAO how we found it.
+    glVertexAttribDivisor(3, 0);
+    glVertexAttribDivisor(4, 0);
+    glVertexAttribDivisor(5, 0);
+    glVertexAttribDivisor(6, 0);
+    glDisableVertexAttribArray(3);
+    glDisableVertexAttribArray(4);
+    glDisableVertexAttribArray(5);
+    glDisableVertexAttribArray(6);
+    glBindBuffer(GL_ARRAY_BUFFER, Geometry.GetVBO());
+    gfx::CGLState::BindTexture(0);
+    m_Shader.Unbind();
+
+    return calls;
+}
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "IronClad/Graphics/Benchmark.hpp"
+#include "IronClad/GUI/Font.hpp"
+#include "IronClad/Utils/Profiler.hpp"
+
+using namespace ic;
+using gfx::CBenchmark;
+using util::CProfiler;
+using util::g_Log;
+
+namespace
+{
+    double percentile(const std::vector<double>& Sorted, const double p)
+    {
+        if(Sorted.empty()) return 0.0;
+        size_t i = size_t(std::ceil(p * Sorted.size()));
+        return Sorted[std::min(Sorted.size(), std::max<size_t>(i, 1)) - 1];
+    }
+
+    double elapsed(const uint64_t start, const uint64_t end)
+    {
+        return (end - start) / 1000.0;
+    }
+}
+
+CBenchmark::CBenchmark(gfx::CWindow& Window) : m_Window(Window),
+                                               m_state(1) {}
+
+CBenchmark::~CBenchmark() {}
+
+bool CBenchmark::Run(const gfx::benchmark_config_t& Config,
+                     gfx::benchmark_result_t& Result)
+{
+    memset(&Result, 0, sizeof Result);
+    m_state = Config.seed ? Config.seed : 1;
+
+    // Baked entities rebuild their chunk whenever they move, so only
+    // bake when asked to, otherwise the batched path is what's timed.
+    gfx::CScene Scene(m_Window, Config.baked ? gfx::IC_STATIC_SCENE :
+                                               gfx::IC_DYNAMIC_SCENE);
+
+    uint64_t start = CProfiler::GetTime();
+    if(!Scene.Init() || !this->Build(Config, Scene))
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to build benchmark scene '";
+        g_Log << Config.pname << "'.\n";
+        g_Log.PrintLastLog();
+
+        this->Release(Scene);
+        return false;
+    }
+
+    // Uploads happen on the first render, so it's part of setting up.
+    Scene.Render();
+    m_Window.Update();
+    Result.setup_ms = elapsed(start, CProfiler::GetTime());
+    Result.lights   = mp_Lights.size();
+    Result.effects  = mp_Effects.size();
+
+    gui::CFont Font;
+    bool text = Config.text_lines > 0 && Config.pfont != NULL &&
+                gui::CFont::Initialize() &&
+                Font.LoadFromFile(Config.pfont, Config.font_size);
+
+    // Scratch space for streaming, sized for one frame's worth.
+    gfx::CVertexBuffer Stream;
+    std::vector<gfx::geometry_range_t> Ranges(Config.streamed_meshes);
+    bool stream = Config.streamed_meshes > 0 && Stream.Init();
+
+    vertex2_t quad_v[4];
+    uint16_t  quad_i[6] = {0, 1, 3, 3, 2, 1};
+    for(uint8_t i = 0; i < 4; ++i)
+    {
+        quad_v[i].Position = math::vector2_t((i == 1 || i == 2) * 16.f,
+                                             (i >= 2) * 16.f);
+        quad_v[i].TexCoord = quad_v[i].Position * (1 / 16.f);
+        quad_v[i].Color    = color4f_t();
+    }
+
+    if(stream)
+    {
+        Stream.SetType(GL_DYNAMIC_DRAW);
+        Stream.AddData(quad_v, 4, quad_i, 6);
+        Stream.FinalizeBuffer();
+    }
+
+    const math::vector2_t Area(m_Window.GetW() * Config.spread,
+                               m_Window.GetH() * Config.spread);
+    const uint32_t moving = uint32_t(mp_Entities.size() * Config.moving);
+
+    std::vector<double> Render;
+    Render.reserve(Config.frames);
+
+    Scene.ToggleProfiling();
+
+    for(uint32_t f = 0; f < Config.warmup + Config.frames; ++f)
+    {
+        for(uint32_t i = 0; i < moving; ++i)
+        {
+            obj::CEntity* pEntity = mp_Entities[Random() % mp_Entities.size()];
+            pEntity->Move(Random(0.f, Area.x), Random(0.f, Area.y));
+        }
+
+        uint64_t t0 = CProfiler::GetTime();
+        Scene.Render();
+        uint64_t t1 = CProfiler::GetTime();
+
+        for(uint16_t i = 0; text && i < Config.text_lines; ++i)
+        {
+            Font.RenderText("The quick brown fox jumps over the lazy dog.",
+                math::vector2_t(8.f, 8.f + i * Config.font_size));
+        }
+
+        uint64_t t2 = CProfiler::GetTime();
+
+        for(uint32_t i = 0; stream && i < Ranges.size(); ++i)
+        {
+            if(Stream.Allocate(4, 6, Ranges[i]))
+                Stream.Upload(Ranges[i], quad_v, quad_i);
+        }
+
+        for(uint32_t i = 0; stream && i < Ranges.size(); ++i)
+            Stream.Free(Ranges[i]);
+
+        uint64_t t3 = CProfiler::GetTime();
+        m_Window.Update();
+        uint64_t t4 = CProfiler::GetTime();
+
+        if(f < Config.warmup) continue;
+
+        const gfx::scene_stats_t& Stats = Scene.GetStats();
+
+        Render.push_back(elapsed(t0, t1));
+        Result.render_mean      += elapsed(t0, t1);
+        Result.frame_mean       += elapsed(t0, t4);
+        Result.text_mean        += elapsed(t1, t2);
+        Result.stream_mean      += elapsed(t2, t3);
+        Result.draw_calls       += Stats.draw_calls;
+        Result.program_binds    += Stats.program_binds;
+        Result.texture_binds    += Stats.texture_binds;
+        Result.triangles        += Stats.triangles;
+        Result.bytes_uploaded   += Stats.bytes_uploaded;
+        Result.culled_entities  += Stats.culled_entities;
+        Result.redundant_calls  += Stats.redundant_calls;
+
+        for(uint8_t i = 0; i < gfx::IC_TIMER_COUNT; ++i)
+            Result.gpu_time[i] += Stats.gpu_time[i];
+    }
+
+    Result.frames = Render.size();
+    if(Result.frames > 0)
+    {
+        const double n = Result.frames;
+        Result.render_mean      /= n;
+        Result.frame_mean       /= n;
+        Result.text_mean        /= n;
+        Result.stream_mean      /= n;
+        Result.draw_calls       /= n;
+        Result.program_binds    /= n;
+        Result.texture_binds    /= n;
+        Result.triangles        /= n;
+        Result.bytes_uploaded   /= n;
+        Result.culled_entities  /= n;
+        Result.redundant_calls  /= n;
+
+        for(uint8_t i = 0; i < gfx::IC_TIMER_COUNT; ++i)
+            Result.gpu_time[i] /= n;
+    }
+
+    std::sort(Render.begin(), Render.end());
+    Result.render_p50 = percentile(Render, 0.50);
+    Result.render_p90 = percentile(Render, 0.90);
+    Result.render_p99 = percentile(Render, 0.99);
+    Result.render_max = Render.empty() ? 0.0 : Render.back();
+
+    this->Release(Scene);
+    return true;
+}
+
+void CBenchmark::Write(std::ostream& out,
+                       const gfx::benchmark_config_t& Config,
+                       const gfx::benchmark_result_t& Result)
+{
+    static const char* s_Timers[gfx::IC_TIMER_COUNT] = {
+        "geometry", "shadow", "lighting", "postfx", "present"
+    };
+
+    out << "{\"name\":\""           << Config.pname               << "\""
+        << ",\"seed\":"             << Config.seed
+        << ",\"entities\":"         << Config.entities
+        << ",\"materials\":"        << Config.materials
+        << ",\"meshes_per_material\":" << Config.meshes_per_material
+        << ",\"baked\":"            << (Config.baked ? "true" : "false")
+        << ",\"lights\":"           << Result.lights
+        << ",\"effects\":"          << Result.effects
+        << ",\"frames\":"           << Result.frames
+        << ",\"setup_ms\":"         << Result.setup_ms
+        << ",\"render_ms\":{\"p50\":" << Result.render_p50
+        << ",\"p90\":"              << Result.render_p90
+        << ",\"p99\":"              << Result.render_p99
+        << ",\"max\":"              << Result.render_max
+        << ",\"mean\":"             << Result.render_mean << "}"
+        << ",\"frame_ms\":"         << Result.frame_mean
+        << ",\"text_ms\":"          << Result.text_mean
+        << ",\"stream_ms\":"        << Result.stream_mean
+        << ",\"draw_calls\":"       << Result.draw_calls
+        << ",\"program_binds\":"    << Result.program_binds
+        << ",\"texture_binds\":"    << Result.texture_binds
+        << ",\"triangles\":"        << Result.triangles
+        << ",\"bytes_uploaded\":"   << Result.bytes_uploaded
+        << ",\"culled_entities\":"  << Result.culled_entities
+        << ",\"redundant_calls\":"  << Result.redundant_calls
+        << ",\"gpu_ms\":{";
+
+    for(uint8_t i = 0; i < gfx::IC_TIMER_COUNT; ++i)
+    {
+        out << (i ? "," : "") << "\"" << s_Timers[i] << "\":"
+            << Result.gpu_time[i];
+    }
+
+    out << "}}\n";
+}
+
+bool CBenchmark::Build(const gfx::benchmark_config_t& Config,
+                       gfx::CScene& Scene)
+{
+    const uint16_t materials = math::max<uint16_t>(1, Config.materials);
+    const uint16_t shapes = math::max<uint16_t>(1, Config.meshes_per_material);
+
+    // A small checker per material, odd ones see-through. The others
+    // have no alpha channel at all, so they count as opaque.
+    for(uint16_t m = 0; m < materials; ++m)
+    {
+        unsigned char pixels[16 * 16 * 4];
+        unsigned char r = Random(), g = Random(), b = Random();
+        const bool    translucent = (m % 2) != 0;
+        const uint8_t channels    = translucent ? 4 : 3;
+
+        for(uint16_t i = 0; i < 16 * 16; ++i)
+        {
+            bool dark = ((i % 16) / 4 + (i / 16) / 4) % 2;
+            pixels[i * channels + 0] = dark ? r / 2 : r;
+            pixels[i * channels + 1] = dark ? g / 2 : g;
+            pixels[i * channels + 2] = dark ? b / 2 : b;
+            if(translucent) pixels[i * channels + 3] = 128;
+        }
+
+        asset::CTexture* pTexture =
+            asset::CAssetManager::Create<asset::CTexture>();
+        mp_Textures.push_back(pTexture);
+
+        const int format = translucent ? GL_RGBA : GL_RGB;
+        if(!pTexture->LoadFromRaw(format, format, 16, 16, pixels))
+            return false;
+    }
+
+    // Polygons, with two more sides for every shape of a material.
+    for(uint32_t s = 0; s < uint32_t(materials) * shapes; ++s)
+    {
+        const uint16_t sides = 4 + (s % shapes) * 2;
+        const float size = Random(8.f, 64.f);
+
+        std::vector<vertex2_t> v(sides + 1);
+        std::vector<uint16_t>  i(sides * 3);
+
+        v[0].Position = math::vector2_t(size / 2, size / 2);
+        for(uint16_t j = 0; j <= sides; ++j)
+        {
+            if(j > 0)
+            {
+                float angle = 2 * math::PI * (j - 1) / sides;
+                v[j].Position = math::vector2_t(
+                    size / 2 * (1 + std::cos(angle)),
+                    size / 2 * (1 + std::sin(angle)));
+
+                i[(j - 1) * 3 + 0] = 0;
+                i[(j - 1) * 3 + 1] = j;
+                i[(j - 1) * 3 + 2] = (j % sides) + 1;
+            }
+
+            v[j].TexCoord = v[j].Position * (1 / size);
+            v[j].Color    = color4f_t();
+        }
+
+        asset::CMesh* pMesh = asset::CAssetManager::Create<asset::CMesh>(
+            &Scene.GetGeometryBuffer());
+        mp_Meshes.push_back(pMesh);
+
+        if(!pMesh->LoadFromRaw(&v[0], v.size(), &i[0], i.size()))
+            return false;
+    }
+
+    const math::vector2_t Area(m_Window.GetW() * Config.spread,
+                               m_Window.GetH() * Config.spread);
+
+    for(uint32_t e = 0; e < Config.entities; ++e)
+    {
+        uint32_t m = Random() % materials;
+        uint32_t s = m * shapes + Random() % shapes;
+
+        obj::CEntity* pEntity = Scene.AddMesh(mp_Meshes[s],
+            math::vector2_t(Random(0.f, Area.x), Random(0.f, Area.y)));
+
+        if(pEntity == NULL) return false;
+
+        pEntity->SetMaterialOverride(mp_Textures[m]);
+        mp_Entities.push_back(pEntity);
+    }
+
+    // Lights and effects are optional, they need shader files.
+    const uint16_t counts[] = {
+        Config.ambient_lights, Config.directional_lights, Config.point_lights
+    };
+
+    const gfx::LightType types[] = {
+        gfx::IC_AMBIENT_LIGHT, gfx::IC_DIRECTIONAL_LIGHT, gfx::IC_POINT_LIGHT
+    };
+
+    for(uint8_t t = 0; t < 3; ++t)
+    {
+        for(uint16_t l = 0; l < counts[t]; ++l)
+        {
+            gfx::CLight* pLight = new gfx::CLight;
+            if(!pLight->Init(types[t], m_Window))
+            {
+                delete pLight;
+                break;
+            }
+
+            pLight->SetColor(Random(0.f, 1.f), Random(0.f, 1.f),
+                             Random(0.f, 1.f));
+            pLight->SetBrightness(Random(0.2f, 1.f));
+            pLight->SetPosition(Random(0.f, Area.x), Random(0.f, Area.y));
+            pLight->SetAttenuation(0.05f, 0.01f, 0.f);
+
+            mp_Lights.push_back(pLight);
+            Scene.AddLight(pLight);
+        }
+    }
+
+    const gfx::EffectType effects[] = {
+        gfx::IC_GRAYSCALE, gfx::IC_DUAL_BLUR, gfx::IC_FADE
+    };
+
+    for(uint8_t e = 0; e < Config.effects; ++e)
+    {
+        gfx::CEffect* pEffect = new gfx::CEffect;
+        if(!pEffect->Init(effects[e % 3]))
+        {
+            delete pEffect;
+            continue;
+        }
+
+        mp_Effects.push_back(pEffect);
+        Scene.AddMaterialOverlay(pEffect);
+    }
+
+    return true;
+}
+
+void CBenchmark::Release(gfx::CScene& Scene)
+{
+    Scene.Clear();
+
+    for(size_t i = 0; i < mp_Entities.size(); ++i) delete mp_Entities[i];
+    for(size_t i = 0; i < mp_Lights.size(); ++i)   delete mp_Lights[i];
+    for(size_t i = 0; i < mp_Effects.size(); ++i)  delete mp_Effects[i];
+
+    for(size_t i = 0; i < mp_Meshes.size(); ++i)
+        asset::CAssetManager::Destroy(mp_Meshes[i]);
+
+    for(size_t i = 0; i < mp_Textures.size(); ++i)
+        asset::CAssetManager::Destroy(mp_Textures[i]);
+
+    mp_Entities.clear();
+    mp_Lights.clear();
+    mp_Effects.clear();
+    mp_Meshes.clear();
+    mp_Textures.clear();
+}
+
+uint32_t CBenchmark::Random()
+{
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 17;
+    m_state ^= m_state << 5;
+    return m_state;
+}
+
+float CBenchmark::Random(const float lo, const float hi)
+{
+    return lo + (hi - lo) * ((this->Random() & 0xFFFFFF) / float(0xFFFFFF));
+}
@@ -0,0 +1,172 @@
+#include "IronClad/Graphics/BufferArena.hpp"
+#include "IronClad/Graphics/Counters.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+#include "IronClad/Utils/Utilities.hpp"
+
+using namespace ic;
+using gfx::CBufferArena;
+using util::g_Log;
+
+CBufferArena::CBufferArena() : m_buffer(0), m_stride(0), m_capacity(0),
+    m_tail(0), m_usage(GL_STATIC_DRAW) {}
+
+CBufferArena::~CBufferArena()
+{
+    this->Release();
+}
+
+bool CBufferArena::Init(const uint32_t stride, const uint16_t usage)
+{
+    if(!glCopyBufferSubData) return false;
+
+    this->Release();
+
+    m_stride    = stride;
+    m_usage     = usage;
+
+    glGenBuffers(1, &m_buffer);
+    return (gfx::CGLError::Query("CBufferArena::Init") == GL_NO_ERROR);
+}
+
+bool CBufferArena::Allocate(const uint32_t count, uint32_t& start)
+{
+    if(m_buffer == 0 || count == 0) return false;
+
+    // First-fit search through the free list.
+    for(size_t i = 0; i < m_freeList.size(); ++i)
+    {
+        block_t& Block = m_freeList[i];
+        if(Block.count < count) continue;
+
+        start = Block.start;
+        Block.start += count;
+        Block.count -= count;
+
+        if(Block.count == 0) m_freeList.erase(m_freeList.begin() + i);
+        return true;
+    }
+
+    // Nothing free, so take it from the end.
+    if(m_tail + count > m_capacity && !this->Grow(m_tail + count))
+        return false;
+
+    start   = m_tail;
+    m_tail += count;
+    return true;
+}
+
+void CBufferArena::Free(const uint32_t start, const uint32_t count)
+{
+    if(count == 0 || start + count > m_tail) return;
+
+    // Find where the block goes, keeping the list sorted.
+    size_t i = 0;
+    while(i < m_freeList.size() && m_freeList[i].start < start) ++i;
+
+    block_t Block = { start, count };
+    m_freeList.insert(m_freeList.begin() + i, Block);
+
+    // Merge with the following block.
+    if(i + 1 < m_freeList.size() &&
+       m_freeList[i].start + m_freeList[i].count == m_freeList[i + 1].start)
+    {
+        m_freeList[i].count += m_freeList[i + 1].count;
+        m_freeList.erase(m_freeList.begin() + i + 1);
+    }
+
+    // Merge with the preceding block.
+    if(i > 0 &&
+       m_freeList[i - 1].start + m_freeList[i - 1].count == m_freeList[i].start)
+    {
+        m_freeList[i - 1].count += m_freeList[i].count;
+        m_freeList.erase(m_freeList.begin() + i);
+    }
+
+    // Free space at the very end goes back to the tail.
+    if(!m_freeList.empty() &&
+       m_freeList.back().start + m_freeList.back().count == m_tail)
+    {
+        m_tail = m_freeList.back().start;
+        m_freeList.pop_back();
+    }
+}
+
+void CBufferArena::Upload(const uint32_t start, const uint32_t count,
+                          const void* pdata)
+{
+    if(m_buffer == 0 || count == 0 || start + count > m_capacity) return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, start * m_stride,
+                    count * m_stride, pdata);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    gfx::Counters::bytes_uploaded += count * m_stride;
+}
+
+void CBufferArena::Clear()
+{
+    m_tail = 0;
+    m_freeList.clear();
+
+    if(m_buffer == 0 || m_capacity == 0) return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, m_capacity * m_stride, NULL, m_usage);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void CBufferArena::Release()
+{
+    if(glDeleteBuffers != NULL && m_buffer != 0)
+        glDeleteBuffers(1, &m_buffer);
+
+    m_buffer = m_capacity = m_tail = 0;
+    m_freeList.clear();
+}
+
+bool CBufferArena::Grow(const uint32_t min_capacity)
+{
+    uint32_t capacity = (m_capacity == 0) ? 64 : m_capacity;
+    while(capacity < min_capacity) capacity *= 2;
+
+    uint32_t buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity * m_stride, NULL, m_usage);
+
+    if(gfx::CGLError::Query("CBufferArena::Grow") != GL_NO_ERROR)
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        glDeleteBuffers(1, &buffer);
+
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to grow buffer to " << capacity * m_stride;
+        g_Log << " bytes.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    // Copy the existing contents over without leaving the GPU.
+    if(m_tail > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, m_buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            0, 0, m_tail * m_stride);
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glDeleteBuffers(1, &m_buffer);
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] GFX: Grew buffer from " << m_capacity << " to ";
+    g_Log << capacity << " elements.\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    m_buffer    = buffer;
+    m_capacity  = capacity;
+    return true;
+}
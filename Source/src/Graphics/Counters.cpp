@@ -0,0 +1,19 @@
+#include "IronClad/Graphics/Counters.hpp"
+
+using namespace ic;
+using gfx::Counters;
+
+uint32_t Counters::program_binds    = 0;
+uint32_t Counters::texture_binds    = 0;
+uint32_t Counters::triangles        = 0;
+uint32_t Counters::bytes_uploaded   = 0;
+uint32_t Counters::redundant_calls  = 0;
+
+void Counters::Reset()
+{
+    program_binds   = 0;
+    texture_binds   = 0;
+    triangles       = 0;
+    bytes_uploaded  = 0;
+    redundant_calls = 0;
+}
@@ -1,15 +1,139 @@
+#include <sstream>
+
 #include "IronClad/Graphics/Effect.hpp"
+#include "IronClad/Graphics/Globals.hpp"
 
 using namespace ic;
 using gfx::CEffect;
+using gfx::Globals;
 
-CEffect::CEffect()
+namespace
 {
-    m_UniformHash.clear();
+    // Dual-filter blur: the down-sampling pass averages four diagonal
+    // bilinear taps around the center, the up-sampling pass a ring of
+    // eight around it. "halfpixel" is half a texel of the target.
+    const char* s_BlurVS[] = {
+        "#version 330 core",
+        "layout(location = 0) in vec2 in_vert;",
+        "layout(location = 1) in vec2 in_texc;",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "smooth out vec2 fs_texc;",
+        "void main()",
+        "{",
+        "    fs_texc     = in_texc;",
+        "    gl_Position = proj * vec4(in_vert, 0.0, 1.0);",
+        "}",
+        NULL
+    };
+
+    const char* s_DownsampleFS[] = {
+        "#version 330 core",
+        "uniform sampler2D tex;",
+        "uniform vec2 halfpixel;",
+        "smooth in vec2 fs_texc;",
+        "out vec4 out_color;",
+        "void main()",
+        "{",
+        "    vec2 hp = halfpixel;",
+        "    vec4 sum = texture(tex, fs_texc) * 4.0;",
+        "    sum += texture(tex, fs_texc - hp);",
+        "    sum += texture(tex, fs_texc + hp);",
+        "    sum += texture(tex, fs_texc + vec2(hp.x, -hp.y));",
+        "    sum += texture(tex, fs_texc - vec2(hp.x, -hp.y));",
+        "    out_color = sum / 8.0;",
+        "}",
+        NULL
+    };
+
+    const char* s_UpsampleFS[] = {
+        "#version 330 core",
+        "uniform sampler2D tex;",
+        "uniform vec2 halfpixel;",
+        "smooth in vec2 fs_texc;",
+        "out vec4 out_color;",
+        "void main()",
+        "{",
+        "    vec2 hp = halfpixel;",
+        "    vec4 sum = texture(tex, fs_texc + vec2(-hp.x * 2.0, 0.0));",
+        "    sum += texture(tex, fs_texc + vec2(-hp.x, hp.y)) * 2.0;",
+        "    sum += texture(tex, fs_texc + vec2(0.0, hp.y * 2.0));",
+        "    sum += texture(tex, fs_texc + vec2(hp.x, hp.y)) * 2.0;",
+        "    sum += texture(tex, fs_texc + vec2(hp.x * 2.0, 0.0));",
+        "    sum += texture(tex, fs_texc + vec2(hp.x, -hp.y)) * 2.0;",
+        "    sum += texture(tex, fs_texc + vec2(0.0, -hp.y * 2.0));",
+        "    sum += texture(tex, fs_texc + vec2(-hp.x, -hp.y)) * 2.0;",
+        "    out_color = sum / 12.0;",
+        "}",
+        NULL
+    };
+}
+
+namespace
+{
+    /**
+     * Effects that only ever read their own pixel. Each one is the body
+     * of a function taking the pixel's "color" and the effect's four
+     * "params", so any run of them can be chained in a single shader.
+     **/
+    struct pixel_effect_t
+    {
+        gfx::EffectType type;
+        const char*     names[4];   // Parameter names, in params order
+        const char*     body;
+    };
+
+    const pixel_effect_t s_PixelEffects[] = {
+        { gfx::IC_GRAYSCALE, { NULL },
+          "return vec4(vec3(dot(color.rgb, vec3(0.299, 0.587, 0.114))), "
+          "color.a);" },
+
+        { gfx::IC_FADE, { "alpha", NULL },
+          "return vec4(color.rgb * params.x, color.a);" }
+    };
+
+    const pixel_effect_t* FindPixelEffect(const gfx::EffectType type)
+    {
+        for(size_t i = 0; i < sizeof(s_PixelEffects) /
+                              sizeof(s_PixelEffects[0]); ++i)
+        {
+            if(s_PixelEffects[i].type == type) return &s_PixelEffects[i];
+        }
+
+        return NULL;
+    }
+}
+
+CEffect::CEffect() : m_type(IC_NO_EFFECT), m_scale(1.f), m_levels(2),
+    mp_pixel(NULL), m_paramloc(-1)
+{
+    m_params[0] = m_params[1] = m_params[2] = m_params[3] = 1.f;
 }
 
 bool CEffect::Init(const gfx::EffectType type)
 {
+    m_type = type;
+
+    // Per-pixel effects are built in, so they can be fused.
+    const pixel_effect_t* pPixel = FindPixelEffect(type);
+    if(pPixel != NULL)
+    {
+        const CEffect* pThis = this;
+        mp_pixel = pPixel->body;
+
+        if(!CEffect::LoadPixelProgram(m_Effect, &pThis, 1)) return false;
+
+        m_paramloc = m_Effect.GetUniformLocation("params");
+        m_Effect.Bind();
+        glUniform4fv(m_paramloc, 1, m_params);
+        m_Effect.Unbind();
+        return true;
+    }
+
     switch(type)
     {
     case IC_VERTICAL_GAUSSIAN_BLUR:
@@ -20,18 +144,14 @@ bool CEffect::Init(const gfx::EffectType type)
         return m_Effect.LoadFromFile("Shaders/Default.vs",
             "Shaders/GaussianBlurH.fs");
 
-    case IC_GRAYSCALE:
-        return m_Effect.LoadFromFile("Shaders/Default.vs",
-            "Shaders/FontRender.fs");
-
-    case IC_FADE:
-        return m_Effect.LoadFromFile("Shaders/Default.vs",
-            "Shaders/Fade.fs");
-
     case IC_RIPPLE:
         return m_Effect.LoadFromFile("Shaders/Default.vs",
             "Shaders/Ripple.fs");
 
+    case IC_DUAL_BLUR:
+        if(!m_Upsample.LoadFromSource(s_BlurVS, s_UpsampleFS)) return false;
+        return m_Effect.LoadFromSource(s_BlurVS, s_DownsampleFS);
+
     case IC_NO_EFFECT: 
         return m_Effect.LoadFromFile("Shaders/Default.vs",
             "Shaders/Default.fs");
@@ -74,6 +194,22 @@ bool CEffect::SetParameter(const char* pname, const int* pvalues,
 
 bool CEffect::SetParameter(const char* pname, const float value)
 {
+    // Built-in per-pixel parameters are kept around for fusing.
+    const pixel_effect_t* pPixel = FindPixelEffect(m_type);
+    if(pPixel != NULL)
+    {
+        for(size_t i = 0; i < 4 && pPixel->names[i] != NULL; ++i)
+        {
+            if(strcmp(pPixel->names[i], pname) != 0) continue;
+
+            m_params[i] = value;
+            glUniform4fv(m_paramloc, 1, m_params);
+            return true;
+        }
+
+        return false;
+    }
+
     int loc = this->GetLocation(pname);
     glUniform1f(loc, value);
     return (loc != -1);
@@ -101,31 +237,129 @@ bool CEffect::SetMatrix(const char* pname, const float* pvalues)
     return (loc != -1);
 }
 
-int CEffect::GetLocation(const char* pname)
+bool CEffect::LoadPixelProgram(gfx::CShaderPair& Program,
+                               const CEffect* const* ppEffects,
+                               const size_t count)
 {
-    if(m_Effect.GetProgram() == 0) return -1;
-    return m_Effect.GetUniformLocation(pname);    
-    
-    // Failed attempt at a uniform hash table is below.
+    if(count == 0 || count > MAX_FUSED) return false;
 
-    std::string name(pname);
-    name += m_Effect.GetProgram();
+    // Functions for each effect, then a main() that runs them in order.
+    std::stringstream fs;
+    fs << "#version 330 core\n"
+       << "uniform sampler2D tex;\n"
+       << "uniform vec4 params[" << count << "];\n"
+       << "smooth in vec2 fs_texc;\n"
+       << "out vec4 out_color;\n";
 
-    uint32_t searcher_hash = asset::CAsset::Hash(
-        name.c_str(), name.length());
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(!ppEffects[i]->IsPerPixel()) return false;
+
+        fs << "vec4 fx" << i << "(vec4 color, vec4 params)\n"
+           << "{\n" << ppEffects[i]->mp_pixel << "\n}\n";
+    }
+
+    fs << "void main()\n{\n"
+       << "    vec4 color = texture(tex, fs_texc);\n";
+
+    for(size_t i = 0; i < count; ++i)
+        fs << "    color = fx" << i << "(color, params[" << i << "]);\n";
 
-    std::map<uint32_t, uint32_t>::iterator i = 
-        m_UniformHash.find(searcher_hash);
+    fs << "    out_color = color;\n}";
+
+    std::string src = fs.str();
+    const char* pfs_src[] = { src.c_str(), NULL };
+    return Program.LoadFromSource(s_BlurVS, pfs_src);
+}
+
+gfx::CFrameBuffer* CEffect::Render(gfx::CRenderTargetPool& Pool,
+                                   const uint32_t source,
+                                   const uint16_t w, const uint16_t h)
+{
+    if(m_type == IC_DUAL_BLUR) return this->BlurRender(Pool, source, w, h);
 
-    if(i == m_UniformHash.end())
+    gfx::CFrameBuffer* pTarget = Pool.Acquire(
+        math::max<uint16_t>(1, w * m_scale),
+        math::max<uint16_t>(1, h * m_scale));
+
+    if(pTarget == NULL) return NULL;
+
+    m_Effect.Bind();
+    this->Pass(pTarget, source);
+    m_Effect.Unbind();
+
+    return pTarget;
+}
+
+gfx::CFrameBuffer* CEffect::BlurRender(gfx::CRenderTargetPool& Pool,
+                                       const uint32_t source,
+                                       const uint16_t w, const uint16_t h)
+{
+    // Every level is half the size of the one above it.
+    uint16_t lw[8], lh[8];
+    lw[0] = math::max<uint16_t>(1, w * m_scale);
+    lh[0] = math::max<uint16_t>(1, h * m_scale);
+
+    for(uint8_t i = 1; i <= m_levels; ++i)
     {
-        int result = m_Effect.GetUniformLocation(pname);
-        if(result == -1) return -1;
+        lw[i] = math::max<uint16_t>(1, lw[i - 1] / 2);
+        lh[i] = math::max<uint16_t>(1, lh[i - 1] / 2);
+    }
 
-        m_UniformHash[searcher_hash] = result;
+    gfx::CFrameBuffer* pLast = NULL;
+    uint32_t texture = source;
+
+    // Blur on the way down...
+    m_Effect.Bind();
+    int loc = m_Effect.GetUniformLocation("halfpixel");
+    for(uint8_t i = 1; i <= m_levels; ++i)
+    {
+        gfx::CFrameBuffer* pTarget = Pool.Acquire(lw[i], lh[i]);
+        if(pTarget == NULL) break;
+
+        glUniform2f(loc, 0.5f / lw[i], 0.5f / lh[i]);
+        this->Pass(pTarget, texture);
+
+        if(pLast) Pool.Release(pLast);
+        pLast   = pTarget;
+        texture = pTarget->GetTexture();
     }
-    else
+    m_Effect.Unbind();
+
+    // ...and again on the way back up.
+    m_Upsample.Bind();
+    loc = m_Upsample.GetUniformLocation("halfpixel");
+    for(int i = m_levels - 1; i >= 0 && pLast != NULL; --i)
     {
-        return m_UniformHash[searcher_hash];
+        gfx::CFrameBuffer* pTarget = Pool.Acquire(lw[i], lh[i]);
+        if(pTarget == NULL) break;
+
+        glUniform2f(loc, 0.5f / lw[i], 0.5f / lh[i]);
+        this->Pass(pTarget, texture);
+
+        Pool.Release(pLast);
+        pLast   = pTarget;
+        texture = pTarget->GetTexture();
     }
+    m_Upsample.Unbind();
+
+    return pLast;
+}
+
+void CEffect::Pass(gfx::CFrameBuffer* pTarget, const uint32_t source)
+{
+    // The quad covers the whole target, so there's nothing to clear.
+    pTarget->Enable();
+    gfx::CGLState::BindTexture(source);
+    Globals::g_FullscreenVBO.Draw();
+    gfx::CGLState::BindTexture(0);
+    pTarget->Disable();
+}
+
+int CEffect::GetLocation(const char* pname)
+{
+    // CShaderPair reflects its uniforms at link time, so this is
+    // a table lookup rather than a round-trip to the driver.
+    if(m_Effect.GetProgram() == 0) return -1;
+    return m_Effect.GetUniformLocation(pname);
 }
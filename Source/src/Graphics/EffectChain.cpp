@@ -0,0 +1,163 @@
+#include <cstring>
+#include <sstream>
+
+#include "IronClad/Graphics/EffectChain.hpp"
+#include "IronClad/Graphics/Globals.hpp"
+
+using namespace ic;
+using gfx::CEffectChain;
+using gfx::Globals;
+using util::g_Log;
+
+CEffectChain::CEffectChain() : mp_Pool(NULL), mp_Last(NULL) {}
+
+CEffectChain::~CEffectChain()
+{
+    this->Clear();
+}
+
+uint32_t CEffectChain::Render(const std::vector<gfx::CEffect*>& Effects,
+                              const uint32_t source,
+                              gfx::CRenderTargetPool& Pool,
+                              const uint16_t w, const uint16_t h)
+{
+    this->Finish();
+    mp_Pool = &Pool;
+
+    uint32_t texture = source;
+    size_t i = 0;
+
+    while(i < Effects.size())
+    {
+        if(Effects[i] == NULL)
+        {
+            ++i;
+            continue;
+        }
+
+        // Find the run of per-pixel effects starting here.
+        size_t end = i;
+        while(end < Effects.size() && end - i < CEffect::MAX_FUSED &&
+              Effects[end] != NULL && Effects[end]->IsPerPixel()) ++end;
+
+        gfx::CFrameBuffer* pTarget = NULL;
+
+        if(end == i)
+        {
+            pTarget = Effects[i]->Render(Pool, texture, w, h);
+            ++i;
+        }
+
+        // The last run is applied on the way to the screen.
+        else if(end == Effects.size())
+        {
+            mp_Tail.assign(Effects.begin() + i, Effects.end());
+            break;
+        }
+
+        else
+        {
+            gfx::CShaderPair* pProgram = this->UseProgram(&Effects[i], end - i);
+            pTarget = pProgram ? Pool.Acquire(w, h) : NULL;
+
+            if(pTarget != NULL)
+            {
+                pTarget->Enable();
+                gfx::CGLState::BindTexture(texture);
+                Globals::g_FullscreenVBO.Draw();
+                gfx::CGLState::BindTexture(0);
+                pTarget->Disable();
+            }
+
+            if(pProgram != NULL) pProgram->Unbind();
+            i = end;
+        }
+
+        if(pTarget == NULL) continue;
+        if(mp_Last != NULL) Pool.Release(mp_Last);
+
+        mp_Last = pTarget;
+        texture = pTarget->GetTexture();
+    }
+
+    return texture;
+}
+
+void CEffectChain::Present(const uint32_t texture)
+{
+    gfx::CShaderPair* pProgram = mp_Tail.empty() ? NULL :
+        this->UseProgram(&mp_Tail[0], mp_Tail.size());
+
+    if(pProgram == NULL)
+    {
+        Globals::g_DefaultEffect.Enable();
+        Globals::g_DefaultEffect.SetMatrix("mv", math::IDENTITY);
+    }
+
+    gfx::CGLState::BindTexture(texture);
+    Globals::g_FullscreenVBO.Draw();
+    gfx::CGLState::BindTexture(0);
+
+    if(pProgram == NULL)    Globals::g_DefaultEffect.Disable();
+    else                    pProgram->Unbind();
+}
+
+void CEffectChain::Finish()
+{
+    if(mp_Pool != NULL && mp_Last != NULL) mp_Pool->Release(mp_Last);
+
+    mp_Last = NULL;
+    mp_Tail.clear();
+}
+
+void CEffectChain::Clear()
+{
+    this->Finish();
+
+    std::map<std::string, gfx::CShaderPair*>::iterator i =
+        m_Programs.begin();
+
+    for( ; i != m_Programs.end(); ++i) delete i->second;
+    m_Programs.clear();
+}
+
+gfx::CShaderPair* CEffectChain::UseProgram(
+    const gfx::CEffect* const* ppEffects, const size_t count)
+{
+    // The code only depends on which effects run, and in what order.
+    std::stringstream key;
+    for(size_t i = 0; i < count; ++i) key << ppEffects[i]->GetType() << ',';
+
+    gfx::CShaderPair*& pProgram = m_Programs[key.str()];
+    if(pProgram == NULL)
+    {
+        pProgram = new gfx::CShaderPair;
+        if(!gfx::CEffect::LoadPixelProgram(*pProgram, ppEffects, count))
+        {
+            g_Log.Flush();
+            g_Log << "[ERROR] Failed to fuse " << count << " effects.\n";
+            g_Log.PrintLastLog();
+        }
+
+#ifdef _DEBUG
+        else
+        {
+            g_Log.Flush();
+            g_Log << "[DEBUG] GFX: Fused " << count << " effects (";
+            g_Log << key.str() << ").\n";
+            g_Log.PrintLastLog();
+        }
+#endif // _DEBUG
+    }
+
+    // Failures stay cached too, so they aren't recompiled every frame.
+    if(pProgram->GetProgram() == 0) return NULL;
+
+    m_params.resize(count * 4);
+    for(size_t i = 0; i < count; ++i)
+        memcpy(&m_params[i * 4], ppEffects[i]->GetParams(), sizeof(float) * 4);
+
+    pProgram->Bind();
+    glUniform4fv(pProgram->GetUniformLocation("params"), count, &m_params[0]);
+    return pProgram;
+}
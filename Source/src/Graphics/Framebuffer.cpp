@@ -1,4 +1,5 @@
 #include "IronClad/Graphics/Framebuffer.hpp"
+#include "IronClad/Graphics/GLState.hpp"
 
 using namespace ic;
 using gfx::CFrameBuffer;
@@ -6,12 +7,15 @@ using gfx::CFrameBuffer;
 CFrameBuffer::~CFrameBuffer()
 {
     // Delete everything.
+    gfx::CGLState::ForgetTexture(m_texture);
+    gfx::CGLState::ForgetFramebuffer(m_fbo);
     glDeleteTextures(1, &m_texture);
     glDeleteRenderbuffers(1, &m_db);
     glDeleteFramebuffers(1, &m_fbo);
 }
 
-bool CFrameBuffer::Init(const uint16_t width, const uint16_t height)
+bool CFrameBuffer::Init(const uint16_t width, const uint16_t height,
+                        const bool depth)
 {
     // Get old view port dimensions.
     GLint view[4];
@@ -20,7 +24,7 @@ bool CFrameBuffer::Init(const uint16_t width, const uint16_t height)
 
     // Create texture and allocate memory for full-screen on it.
     glGenTextures(1, &m_texture);
-    glBindTexture(GL_TEXTURE_2D, m_texture);
+    gfx::CGLState::BindTexture(m_texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
@@ -28,17 +32,20 @@ bool CFrameBuffer::Init(const uint16_t width, const uint16_t height)
 
     // Create frame-buffer and attach texture to it.
     glGenFramebuffers(1, &m_fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    gfx::CGLState::BindFramebuffer(m_fbo);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, 
                            GL_TEXTURE_2D, m_texture, 0);
 
     // Create depth buffer and attach to frame-buffer.
-    glGenRenderbuffers(1, &m_db);
-    glBindRenderbuffer(GL_RENDERBUFFER, m_db);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 
-                          width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER,  GL_DEPTH_ATTACHMENT, 
-                              GL_RENDERBUFFER, m_db);
+    if(depth)
+    {
+        glGenRenderbuffers(1, &m_db);
+        glBindRenderbuffer(GL_RENDERBUFFER, m_db);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 
+                              width, height);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER,  GL_DEPTH_ATTACHMENT, 
+                                  GL_RENDERBUFFER, m_db);
+    }
 
     // Check for awesomeness.
     uint32_t status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
@@ -47,23 +54,23 @@ bool CFrameBuffer::Init(const uint16_t width, const uint16_t height)
     m_ThisView.x = width; m_ThisView.y = height;
 
     // Unbind everything.
-    glBindFramebuffer(GL_FRAMEBUFFER,   0);
+    gfx::CGLState::BindFramebuffer(0);
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gfx::CGLState::BindTexture(0);
 
     return (status == GL_FRAMEBUFFER_COMPLETE);
 }
 
 void CFrameBuffer::Enable()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
-    glViewport(0, 0, m_ThisView.x, m_ThisView.y);
+    gfx::CGLState::BindFramebuffer(m_fbo);
+    gfx::CGLState::Viewport(0, 0, m_ThisView.x, m_ThisView.y);
 }
 
 void CFrameBuffer::Disable()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glViewport(0, 0, m_View.x, m_View.y);
+    gfx::CGLState::BindFramebuffer(gfx::CWindow::GetScreenBuffer());
+    gfx::CGLState::Viewport(0, 0, m_View.x, m_View.y);
 }
 
 void CFrameBuffer::Clear()
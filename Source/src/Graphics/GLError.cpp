@@ -0,0 +1,222 @@
+#include <string>
+#include <cstring>
+#include <vector>
+#include <mutex>
+
+#include "IronClad/Utils/Logging.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+
+using namespace ic;
+using gfx::CGLError;
+using util::g_Log;
+
+#ifndef IC_GL_ERROR_POLICY
+  #ifdef _DEBUG
+    #define IC_GL_ERROR_POLICY IC_GL_ERRORS_SYNC
+  #else
+    #define IC_GL_ERROR_POLICY IC_GL_ERRORS_OFF
+  #endif // _DEBUG
+#endif // IC_GL_ERROR_POLICY
+
+namespace
+{
+    // The driver may call back from any thread, so messages wait here
+    // until the next check logs them from the rendering thread.
+    const size_t MAX_PENDING = 64;
+
+    std::mutex                  s_Lock;
+    std::vector<std::string>    s_Pending;
+    uint32_t                    s_dropped = 0;
+
+    const char* GetTypeString(const GLenum type)
+    {
+        switch(type)
+        {
+        case GL_DEBUG_TYPE_ERROR:               return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "undefined";
+        case GL_DEBUG_TYPE_PORTABILITY:         return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE:         return "performance";
+        default:                                return "other";
+        }
+    }
+}
+
+gfx::GLErrorPolicy CGLError::s_policy = gfx::IC_GL_ERROR_POLICY;
+uint32_t CGLError::s_errors = 0;
+bool     CGLError::s_ready  = false;
+
+void CGLError::SetPolicy(const GLErrorPolicy policy)
+{
+    s_policy = policy;
+    if(s_ready) CGLError::Apply();
+}
+
+void CGLError::Init()
+{
+    // Whatever context creation or GLEW left behind isn't ours.
+    while(glGetError() != GL_NO_ERROR);
+
+    s_ready = true;
+    CGLError::Apply();
+}
+
+uint32_t CGLError::Check(const char* pfile, const int line)
+{
+    if(s_policy == IC_GL_ERRORS_OFF) return GL_NO_ERROR;
+
+    if(s_policy == IC_GL_ERRORS_SYNC)
+    {
+        uint32_t first = glGetError();
+        if(first == GL_NO_ERROR) return GL_NO_ERROR;
+
+        g_Log.Flush();
+        for(uint32_t error = first; error != GL_NO_ERROR;
+            error = glGetError())
+        {
+            ++s_errors;
+            g_Log << "[ERROR] GL: " << CGLError::GetErrorString(error);
+            g_Log << " at " << pfile << ":" << line << ".\n";
+        }
+        g_Log.PrintLastLog();
+        return first;
+    }
+
+    // Asynchronous messages can't be tied to a call, so this is only
+    // where they get logged.
+    std::vector<std::string> Messages;
+    uint32_t dropped;
+    {
+        std::lock_guard<std::mutex> Guard(s_Lock);
+        if(s_Pending.empty() && s_dropped == 0) return GL_NO_ERROR;
+
+        Messages.swap(s_Pending);
+        dropped   = s_dropped;
+        s_dropped = 0;
+    }
+
+    g_Log.Flush();
+    for(size_t i = 0; i < Messages.size(); ++i)
+        g_Log << Messages[i];
+
+    if(dropped > 0)
+        g_Log << "[ERROR] GL: " << dropped << " more message(s) dropped.\n";
+
+    g_Log << "[DEBUG] GL: Reported before " << pfile << ":" << line << ".\n";
+    g_Log.PrintLastLog();
+    return GL_NO_ERROR;
+}
+
+uint32_t CGLError::Query(const char* pwhere)
+{
+    uint32_t first = glGetError();
+    if(first == GL_NO_ERROR) return GL_NO_ERROR;
+
+    g_Log.Flush();
+    for(uint32_t error = first; error != GL_NO_ERROR; error = glGetError())
+    {
+        ++s_errors;
+        g_Log << "[ERROR] GL: " << CGLError::GetErrorString(error);
+        g_Log << " in " << pwhere << ".\n";
+    }
+    g_Log.PrintLastLog();
+    return first;
+}
+
+const char* CGLError::GetErrorString(const uint32_t error)
+{
+    switch(error)
+    {
+    case GL_NO_ERROR:                       return "GL_NO_ERROR";
+    case GL_INVALID_ENUM:                   return "GL_INVALID_ENUM";
+    case GL_INVALID_VALUE:                  return "GL_INVALID_VALUE";
+    case GL_INVALID_OPERATION:              return "GL_INVALID_OPERATION";
+    case GL_INVALID_FRAMEBUFFER_OPERATION:
+        return "GL_INVALID_FRAMEBUFFER_OPERATION";
+    case GL_OUT_OF_MEMORY:                  return "GL_OUT_OF_MEMORY";
+    default:                                return "Unknown GL error";
+    }
+}
+
+void CGLError::Apply()
+{
+    const bool khr = (GLEW_KHR_debug || GLEW_VERSION_4_3) &&
+                      glDebugMessageCallback != NULL;
+    const bool arb = !khr && GLEW_ARB_debug_output &&
+                      glDebugMessageCallbackARB != NULL;
+
+    if(s_policy == IC_GL_ERRORS_ASYNC && !khr && !arb)
+    {
+        g_Log.Flush();
+        g_Log << "[INFO] GL: No debug output available, ";
+        g_Log << "error checking is off.\n";
+        g_Log.PrintLastLog();
+        s_policy = IC_GL_ERRORS_OFF;
+    }
+
+    // Synchronous checks still get the driver's messages, which say a
+    // lot more than an error code, right as the bad call is made.
+    const bool output = (s_policy != IC_GL_ERRORS_OFF);
+    const bool sync   = (s_policy == IC_GL_ERRORS_SYNC);
+
+    if(khr)
+    {
+        if(output)
+        {
+            glDebugMessageCallback(&CGLError::DebugCallback, NULL);
+            glEnable(GL_DEBUG_OUTPUT);
+        }
+        else
+        {
+            glDisable(GL_DEBUG_OUTPUT);
+            glDebugMessageCallback(NULL, NULL);
+        }
+
+        if(sync) glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        else     glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    }
+    else if(arb)
+    {
+        glDebugMessageCallbackARB(output ? &CGLError::DebugCallback : NULL,
+                                  NULL);
+        if(sync) glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+        else     glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+    }
+
+    // Drivers without either extension don't know these enums.
+    while(glGetError() != GL_NO_ERROR);
+}
+
+void IC_GL_CALLBACK CGLError::DebugCallback(GLenum /*source*/, GLenum type,
+                                            GLuint /*id*/, GLenum severity,
+                                            GLsizei length,
+                                            const GLchar* pmessage,
+                                            GLvoid* /*puser*/)
+{
+    // Notifications are mostly drivers talking about buffer placement.
+    if(severity == GL_DEBUG_SEVERITY_NOTIFICATION) return;
+
+    std::string Message(type == GL_DEBUG_TYPE_ERROR ? "[ERROR]" : "[INFO]");
+    Message += " GL (";
+    Message += GetTypeString(type);
+    Message += "): ";
+    Message.append(pmessage, length > 0 ? length : strlen(pmessage));
+    if(Message[Message.size() - 1] != '\n') Message += '\n';
+
+    std::lock_guard<std::mutex> Guard(s_Lock);
+
+    // Synchronous callbacks come from the calling thread, so they can
+    // go straight out. The error itself is counted by the next check.
+    if(s_policy == IC_GL_ERRORS_SYNC)
+    {
+        g_Log.Flush();
+        g_Log << Message;
+        g_Log.PrintLastLog();
+        return;
+    }
+
+    if(type == GL_DEBUG_TYPE_ERROR) ++s_errors;
+
+    if(s_Pending.size() < MAX_PENDING) s_Pending.push_back(Message);
+    else                               ++s_dropped;
+}
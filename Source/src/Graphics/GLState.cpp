@@ -0,0 +1,186 @@
+#include "IronClad/Graphics/GLState.hpp"
+
+using namespace ic;
+using gfx::CGLState;
+using gfx::Counters;
+
+namespace
+{
+    // Never a valid name, so the first change of anything goes through.
+    const uint32_t UNKNOWN = ~0U;
+}
+
+uint32_t CGLState::s_program    = UNKNOWN;
+uint32_t CGLState::s_vao        = UNKNOWN;
+uint32_t CGLState::s_fbo        = UNKNOWN;
+uint32_t CGLState::s_unit       = UNKNOWN;
+uint32_t CGLState::s_textures[MAX_UNITS] = {
+    UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN
+};
+uint32_t CGLState::s_blend      = UNKNOWN;
+uint32_t CGLState::s_blend_func[4] = { UNKNOWN, UNKNOWN, UNKNOWN, UNKNOWN };
+uint32_t CGLState::s_depth      = UNKNOWN;
+uint32_t CGLState::s_depth_mask = UNKNOWN;
+int      CGLState::s_viewport[4]   = { -1, -1, -1, -1 };
+
+void CGLState::UseProgram(const uint32_t program)
+{
+    if(s_program == program)
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    glUseProgram(s_program = program);
+    ++Counters::program_binds;
+}
+
+void CGLState::BindVertexArray(const uint32_t vao)
+{
+    if(s_vao == vao)
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    glBindVertexArray(s_vao = vao);
+}
+
+void CGLState::BindFramebuffer(const uint32_t fbo)
+{
+    if(s_fbo == fbo)
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, s_fbo = fbo);
+}
+
+void CGLState::BindTexture(const uint32_t texture, const uint8_t unit)
+{
+    // Units past the tracked ones are always bound.
+    if(unit >= MAX_UNITS)
+    {
+        if(s_unit != unit) glActiveTexture(GL_TEXTURE0 + (s_unit = unit));
+        glBindTexture(GL_TEXTURE_2D, texture);
+        ++Counters::texture_binds;
+        return;
+    }
+
+    if(s_textures[unit] == texture)
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    if(s_unit != unit) glActiveTexture(GL_TEXTURE0 + (s_unit = unit));
+    glBindTexture(GL_TEXTURE_2D, s_textures[unit] = texture);
+    ++Counters::texture_binds;
+}
+
+void CGLState::EnableBlending(const bool flag)
+{
+    if(s_blend == uint32_t(flag))
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    s_blend = flag;
+    flag ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+}
+
+void CGLState::BlendFunc(const uint32_t src, const uint32_t dst)
+{
+    CGLState::BlendFuncSeparate(src, dst, src, dst);
+}
+
+void CGLState::BlendFuncSeparate(const uint32_t src_rgb,
+                                 const uint32_t dst_rgb,
+                                 const uint32_t src_alpha,
+                                 const uint32_t dst_alpha)
+{
+    if(s_blend_func[0] == src_rgb   && s_blend_func[1] == dst_rgb &&
+       s_blend_func[2] == src_alpha && s_blend_func[3] == dst_alpha)
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    s_blend_func[0] = src_rgb;   s_blend_func[1] = dst_rgb;
+    s_blend_func[2] = src_alpha; s_blend_func[3] = dst_alpha;
+    glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+}
+
+void CGLState::EnableDepthTest(const bool flag)
+{
+    if(s_depth == uint32_t(flag))
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    s_depth = flag;
+    flag ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
+}
+
+void CGLState::DepthMask(const bool flag)
+{
+    if(s_depth_mask == uint32_t(flag))
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    s_depth_mask = flag;
+    glDepthMask(flag ? GL_TRUE : GL_FALSE);
+}
+
+void CGLState::Viewport(const int x, const int y, const int w, const int h)
+{
+    if(s_viewport[0] == x && s_viewport[1] == y &&
+       s_viewport[2] == w && s_viewport[3] == h)
+    {
+        ++Counters::redundant_calls;
+        return;
+    }
+
+    s_viewport[0] = x; s_viewport[1] = y;
+    s_viewport[2] = w; s_viewport[3] = h;
+    glViewport(x, y, w, h);
+}
+
+void CGLState::ForgetProgram(const uint32_t program)
+{
+    if(s_program == program) s_program = UNKNOWN;
+}
+
+void CGLState::ForgetTexture(const uint32_t texture)
+{
+    for(uint8_t i = 0; i < MAX_UNITS; ++i)
+        if(s_textures[i] == texture) s_textures[i] = UNKNOWN;
+}
+
+void CGLState::ForgetVertexArray(const uint32_t vao)
+{
+    if(s_vao == vao) s_vao = UNKNOWN;
+}
+
+void CGLState::ForgetFramebuffer(const uint32_t fbo)
+{
+    if(s_fbo == fbo) s_fbo = UNKNOWN;
+}
+
+void CGLState::Invalidate()
+{
+    s_program = s_vao = s_fbo = s_unit = s_blend = UNKNOWN;
+    s_depth = s_depth_mask = UNKNOWN;
+
+    for(uint8_t i = 0; i < MAX_UNITS; ++i) s_textures[i] = UNKNOWN;
+    for(uint8_t i = 0; i < 4; ++i)
+    {
+        s_blend_func[i] = UNKNOWN;
+        s_viewport[i]   = -1;
+    }
+}
@@ -0,0 +1,85 @@
+#include <cstring>
+
+#include "IronClad/Utils/Logging.hpp"
+#include "IronClad/Graphics/GPUTimer.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+
+using namespace ic;
+using gfx::CGPUTimer;
+using util::g_Log;
+
+CGPUTimer::CGPUTimer() : m_frame(0), m_ok(false)
+{
+    memset(m_queries, 0, sizeof m_queries);
+    memset(m_issued,  0, sizeof m_issued);
+    memset(m_times,   0, sizeof m_times);
+}
+
+CGPUTimer::~CGPUTimer()
+{
+    if(m_ok) glDeleteQueries(LATENCY * MAX_TIMERS * 2, &m_queries[0][0]);
+}
+
+bool CGPUTimer::Init()
+{
+    if(m_ok) return true;
+
+    if(!glQueryCounter || !glGetQueryObjectui64v)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] GPU timer queries are not supported.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    glGenQueries(LATENCY * MAX_TIMERS * 2, &m_queries[0][0]);
+    m_ok = (gfx::CGLError::Query("CGPUTimer::Init") == GL_NO_ERROR);
+    return m_ok;
+}
+
+void CGPUTimer::BeginFrame()
+{
+    if(!m_ok) return;
+
+    m_frame = (m_frame + 1) % LATENCY;
+
+    // This slot was recorded LATENCY frames ago, read what's done.
+    for(uint8_t i = 0; i < MAX_TIMERS; ++i)
+    {
+        if(!m_issued[m_frame][i])
+        {
+            m_times[i] = 0.f;
+            continue;
+        }
+
+        m_issued[m_frame][i] = false;
+
+        GLint available = 0;
+        glGetQueryObjectiv(m_queries[m_frame][i * 2 + 1],
+                           GL_QUERY_RESULT_AVAILABLE, &available);
+
+        // Keep the old time rather than wait.
+        if(!available) continue;
+
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(m_queries[m_frame][i * 2],
+                              GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(m_queries[m_frame][i * 2 + 1],
+                              GL_QUERY_RESULT, &end);
+
+        m_times[i] = (end - start) / 1000000.f;
+    }
+}
+
+void CGPUTimer::Begin(const uint8_t timer)
+{
+    if(!m_ok || timer >= MAX_TIMERS) return;
+    glQueryCounter(m_queries[m_frame][timer * 2], GL_TIMESTAMP);
+}
+
+void CGPUTimer::End(const uint8_t timer)
+{
+    if(!m_ok || timer >= MAX_TIMERS) return;
+    glQueryCounter(m_queries[m_frame][timer * 2 + 1], GL_TIMESTAMP);
+    m_issued[m_frame][timer] = true;
+}
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifndef _WIN32
+  #include <EGL/egl.h>
+  #include <EGL/eglext.h>
+#endif // _WIN32
+
+#include "IronClad/Graphics/HeadlessWindow.hpp"
+#include "IronClad/Graphics/GLState.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+
+using namespace ic;
+using gfx::CHeadlessWindow;
+using util::g_Log;
+
+CHeadlessWindow::CHeadlessWindow() : mp_display(NULL), mp_context(NULL),
+    mp_surface(NULL), m_fbo(0), m_color(0), m_depth(0) {}
+
+CHeadlessWindow::~CHeadlessWindow()
+{
+    this->Destroy();
+}
+
+bool CHeadlessWindow::Create(const uint16_t width, const uint16_t height,
+                             const char* /*ptitle*/)
+{
+    m_width     = width;
+    m_height    = height;
+    m_fullscreen= false;
+
+    if(!this->CreateContext())
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to create headless OpenGL context!\n";
+        g_Log.PrintLastLog();
+
+        this->Destroy();
+        return false;
+    }
+
+    // GLEW builds that only know GLX fail here, but still find the
+    // functions through the EGL context, so only give up if they're
+    // actually missing.
+    glewExperimental = true;
+    if(glewInit() != GLEW_OK && glGenFramebuffers == NULL)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to load OpenGL functions.\n";
+        g_Log.PrintLastLog();
+
+        this->Destroy();
+        return false;
+    }
+
+    // Nothing is known about a new context.
+    gfx::CGLError::Init();
+    gfx::CGLState::Invalidate();
+
+    g_Log.Flush();
+    g_Log << "[INFO] OpenGL version : " << (char*)glGetString(GL_VERSION);
+    g_Log << "\n[INFO] OpenGL renderer: " << (char*)glGetString(GL_RENDERER);
+    g_Log << "\n";
+    g_Log.PrintLastLog();
+
+    // The "screen".
+    glGenRenderbuffers(1, &m_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, m_width, m_height);
+
+    glGenRenderbuffers(1, &m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8,
+                          m_width, m_height);
+
+    glGenFramebuffers(1, &m_fbo);
+    gfx::CGLState::BindFramebuffer(m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, m_color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                              GL_RENDERBUFFER, m_depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to create " << m_width << "x" << m_height;
+        g_Log << " headless frame-buffer.\n";
+        g_Log.PrintLastLog();
+
+        this->Destroy();
+        return false;
+    }
+
+    m_screen = m_fbo;
+
+    // Same state as a real window starts with.
+    glClearColor(0, 0, 0, 1);
+    gfx::CGLState::Viewport(0, 0, m_width, m_height);
+    glDisable(GL_DEPTH_TEST);
+    gfx::CGLState::EnableBlending(true);
+    gfx::CGLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    m_ProjectionMatrix = math::matrix4x4_t::Projection2D(
+        width, height, 10, -10);
+
+    return true;
+}
+
+void CHeadlessWindow::Update()
+{
+    glFinish();
+    ++m_frame_count;
+}
+
+bool CHeadlessWindow::ReadFrame(uint8_t* pPixels) const
+{
+    if(m_fbo == 0 || pPixels == NULL) return false;
+
+    GLint fbo = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, m_fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pPixels);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+
+    // OpenGL reads bottom-up.
+    const size_t pitch = m_width * 4;
+    std::vector<uint8_t> row(pitch);
+    for(uint16_t y = 0; y < m_height / 2; ++y)
+    {
+        uint8_t* pTop    = pPixels + y * pitch;
+        uint8_t* pBottom = pPixels + (m_height - 1 - y) * pitch;
+        memcpy(&row[0], pTop, pitch);
+        memcpy(pTop, pBottom, pitch);
+        memcpy(pBottom, &row[0], pitch);
+    }
+
+    // glReadPixels() already waited on the GPU, so asking is free.
+    return (gfx::CGLError::Query("CHeadlessWindow::ReadFrame") ==
+            GL_NO_ERROR);
+}
+
+bool CHeadlessWindow::SaveFrame(const char* pfilename) const
+{
+    std::vector<uint8_t> pixels(m_width * m_height * 4);
+    if(pixels.empty() || !this->ReadFrame(&pixels[0])) return false;
+
+    std::ofstream file(pfilename, std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to open " << pfilename << " for writing.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    // 32-bit true-color, top-left origin.
+    uint8_t header[18] = { 0 };
+    header[2]  = 2;
+    header[12] = m_width  & 0xFF; header[13] = m_width  >> 8;
+    header[14] = m_height & 0xFF; header[15] = m_height >> 8;
+    header[16] = 32;
+    header[17] = 0x28;
+    file.write((char*)header, sizeof header);
+
+    // TGA wants BGRA.
+    for(size_t i = 0; i < pixels.size(); i += 4)
+        std::swap(pixels[i], pixels[i + 2]);
+
+    file.write((char*)&pixels[0], pixels.size());
+    return file.good();
+}
+
+void CHeadlessWindow::Destroy()
+{
+    if(m_fbo != 0)
+    {
+        gfx::CGLState::ForgetFramebuffer(m_fbo);
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteRenderbuffers(1, &m_color);
+        glDeleteRenderbuffers(1, &m_depth);
+        m_fbo = m_color = m_depth = 0;
+        m_screen = 0;
+    }
+
+#ifndef _WIN32
+    EGLDisplay display = (EGLDisplay)mp_display;
+    if(display != EGL_NO_DISPLAY)
+    {
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE,
+                       EGL_NO_CONTEXT);
+
+        if(mp_context) eglDestroyContext(display, (EGLContext)mp_context);
+        if(mp_surface) eglDestroySurface(display, (EGLSurface)mp_surface);
+        eglTerminate(display);
+    }
+#endif // _WIN32
+
+    mp_display = mp_context = mp_surface = NULL;
+}
+
+bool CHeadlessWindow::CreateContext()
+{
+#ifdef _WIN32
+    g_Log.Flush();
+    g_Log << "[ERROR] Headless rendering needs EGL, which isn't ";
+    g_Log << "available on this platform.\n";
+    g_Log.PrintLastLog();
+    return false;
+#else
+    // Mesa's surfaceless platform needs no display server at all.
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC eglGetPlatformDisplayEXT =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+    if(eglGetPlatformDisplayEXT != NULL)
+    {
+        display = eglGetPlatformDisplayEXT(EGL_PLATFORM_SURFACELESS_MESA,
+                                           EGL_DEFAULT_DISPLAY, NULL);
+    }
+
+    if(display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if(display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL))
+        return false;
+
+    mp_display = display;
+
+    if(!eglBindAPI(EGL_OPENGL_API)) return false;
+
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE,       EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE,    EGL_OPENGL_BIT,
+        EGL_RED_SIZE,   8,  EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE,  8,  EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint count = 0;
+    if(!eglChooseConfig(display, config_attribs, &config, 1, &count) ||
+       count == 0) return false;
+
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION,  3,
+        EGL_CONTEXT_MINOR_VERSION,  3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG,
+            gfx::CGLError::GetPolicy() == gfx::IC_GL_ERRORS_OFF ?
+            EGL_FALSE : EGL_TRUE,
+        EGL_NONE
+    };
+
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT,
+                                          context_attribs);
+    if(context == EGL_NO_CONTEXT) return false;
+
+    mp_context = context;
+
+    // Everything is drawn into our own frame-buffer, so a surface is
+    // only needed if the driver can't do without one.
+    if(eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+        return true;
+
+    const EGLint pbuffer_attribs[] = {
+        EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE
+    };
+
+    EGLSurface surface = eglCreatePbufferSurface(display, config,
+                                                 pbuffer_attribs);
+    if(surface == EGL_NO_SURFACE) return false;
+
+    mp_surface = surface;
+    return (eglMakeCurrent(display, surface, surface, context) == EGL_TRUE);
+#endif // _WIN32
+}
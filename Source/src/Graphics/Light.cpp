@@ -156,6 +156,9 @@ void CLight::Disable()
 
 void CLight::SetMaximumAngle(const float degrees)
 {
+    m_max_angle = degrees;
+    m_angled    = true;
+
     m_Max = math::vector2_t(1, 0);
     m_Max.Rotate(math::rad(degrees));
 
@@ -164,8 +167,83 @@ void CLight::SetMaximumAngle(const float degrees)
 
 void CLight::SetMinimumAngle(const float degrees)
 {
+    m_min_angle = degrees;
+    m_angled    = true;
+
     m_Min = math::vector2_t(1, 0);
     m_Min.Rotate(math::rad(degrees));
 
     glUniform2f(m_minloc, m_Min.x, m_Min.y);
 }
+
+float CLight::GetRadius(const float cutoff) const
+{
+    // Solve brt / (c + l*d + q*d^2) = cutoff for d, which gives
+    // q*d^2 + l*d + (c - brt / cutoff) = 0.
+    float c = m_Att.x - m_brt / cutoff;
+
+    if(m_Att.z > 0.f)
+    {
+        float disc = m_Att.y * m_Att.y - 4.f * m_Att.z * c;
+        if(disc < 0.f) return 0.f;
+        return math::max<float>(0.f,
+            (-m_Att.y + sqrt(disc)) / (2.f * m_Att.z));
+    }
+    else if(m_Att.y > 0.f)
+    {
+        return math::max<float>(0.f, -c / m_Att.y);
+    }
+
+    // No falloff, unless it's too dim to ever be seen.
+    return (c >= 0.f) ? 0.f : -1.f;
+}
+
+bool CLight::GetInfluence(math::rect_t& Bounds, const float cutoff) const
+{
+    if(m_type == IC_AMBIENT_LIGHT || m_type == IC_NO_LIGHT) return false;
+
+    float r = this->GetRadius(cutoff);
+    if(r < 0.f) return false;
+
+    float x0 = m_Pos.x - r, x1 = m_Pos.x + r;
+    float y0 = m_Pos.y - r, y1 = m_Pos.y + r;
+
+    // Shrink the box down to the cone of a directional light.
+    if(m_type == IC_DIRECTIONAL_LIGHT && m_angled)
+    {
+        float a0 = m_min_angle, a1 = m_max_angle;
+        while(a1 < a0) a1 += 360.f;
+
+        if(a1 - a0 < 360.f)
+        {
+            // The cone's box holds the origin, both edges, and every
+            // axis the arc crosses between them.
+            x0 = x1 = m_Pos.x;
+            y0 = y1 = m_Pos.y;
+
+            float angles[2] = { a0, a1 };
+            for(size_t i = 0; i < 2; ++i)
+            {
+                float x = m_Pos.x + r * cos(math::rad(angles[i]));
+                float y = m_Pos.y + r * sin(math::rad(angles[i]));
+
+                x0 = math::min<float>(x0, x); x1 = math::max<float>(x1, x);
+                y0 = math::min<float>(y0, y); y1 = math::max<float>(y1, y);
+            }
+
+            for(float axis = ceil(a0 / 90.f) * 90.f; axis < a1; axis += 90.f)
+            {
+                switch(((int)(axis / 90.f) % 4 + 4) % 4)
+                {
+                case 0: x1 = m_Pos.x + r; break;
+                case 1: y1 = m_Pos.y + r; break;
+                case 2: x0 = m_Pos.x - r; break;
+                case 3: y0 = m_Pos.y - r; break;
+                }
+            }
+        }
+    }
+
+    Bounds = math::rect_t(x0, y0, ceil(x1 - x0), ceil(y1 - y0));
+    return true;
+}
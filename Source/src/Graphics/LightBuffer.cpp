@@ -0,0 +1,199 @@
+#include "IronClad/Graphics/LightBuffer.hpp"
+
+using namespace ic;
+using gfx::CLightBuffer;
+using util::g_Log;
+
+namespace
+{
+    // Built-in single-pass lighting shaders. The vertex shader draws
+    // the full-screen quad, the fragment shader sums every light's
+    // contribution with the same falloff as the per-light shaders.
+    const char* s_LightVS[] = {
+        "#version 330 core",
+        "layout(location = 0) in vec2 in_vert;",
+        "layout(location = 1) in vec2 in_texc;",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "smooth out vec2 fs_texc;",
+        "void main()",
+        "{",
+        "    fs_texc     = in_texc;",
+        "    gl_Position = proj * vec4(in_vert, 0.0, 1.0);",
+        "}",
+        NULL
+    };
+
+    const char* s_LightFS[] = {
+        "#version 330 core",
+        "struct light_t",
+        "{",
+        "    vec4 pos;      // x, y, type, brightness",
+        "    vec4 color;",
+        "    vec4 att;      // c, l, q, radius",
+        "    vec4 cone;     // min, sweep, angled, shadowed",
+        "};",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "layout(std140) uniform LightData",
+        "{",
+        "    vec4    info;",
+        "    light_t lights[64];",
+        "};",
+        "uniform sampler2D tex;",
+        "uniform sampler2D shadow_map;",
+        "smooth in vec2 fs_texc;",
+        "out vec4 out_color;",
+        "const float KERNEL[5] = float[5](0.06, 0.24, 0.4, 0.24, 0.06);",
+        "float shadow(int row, vec2 dir, float t)",
+        "{",
+        "    float res  = float(textureSize(shadow_map, 0).x);",
+        "    float x    = mod(atan(dir.y, dir.x), 6.2831853) / 6.2831853 * res;",
+        "    float blur = 1.0 + t * 3.0;",
+        "    float lit  = 0.0;",
+        "    for(int k = 0; k < 5; ++k)",
+        "    {",
+        "        int s = int(mod(floor(x + float(k - 2) * blur), res));",
+        "        lit += step(t, texelFetch(shadow_map, ivec2(s, row), 0).r)",
+        "             * KERNEL[k];",
+        "    }",
+        "    return lit;",
+        "}",
+        "void main()",
+        "{",
+        "    vec2 pixel = vec2(gl_FragCoord.x, info.y - gl_FragCoord.y);",
+        "    vec3 total = vec3(0.0);",
+        "    int  count = int(info.x);",
+        "    for(int i = 0; i < count; ++i)",
+        "    {",
+        "        light_t L = lights[i];",
+        "        if(L.pos.z == 0.0)",
+        "        {",
+        "            total += L.color.rgb * L.pos.w;",
+        "            continue;",
+        "        }",
+        "        vec2  to_pixel = pixel - (L.pos.xy + camera);",
+        "        float d = length(to_pixel);",
+        "        if(L.att.w >= 0.0 && d > L.att.w) continue;",
+        "        if(L.cone.z > 0.0)",
+        "        {",
+        "            float a = mod(atan(to_pixel.y, to_pixel.x) - L.cone.x,",
+        "                          6.2831853);",
+        "            if(a > L.cone.y) continue;",
+        "        }",
+        "        float att = L.att.x + L.att.y * d + L.att.z * d * d;",
+        "        float lit = 1.0;",
+        "        if(L.cone.w > 0.0)",
+        "        {",
+        "            float reach = L.att.w >= 0.0 ? L.att.w : length(info.zy);",
+        "            lit = shadow(i, to_pixel, d / reach);",
+        "        }",
+        "        total += L.color.rgb * L.pos.w * lit / att;",
+        "    }",
+        "    vec4 texel = texture(tex, fs_texc);",
+        "    out_color  = vec4(texel.rgb * total, texel.a);",
+        "}",
+        NULL
+    };
+}
+
+CLightBuffer::CLightBuffer() : m_count(0)
+{
+    memset(&m_Block, 0, sizeof(m_Block));
+}
+
+CLightBuffer::~CLightBuffer() {}
+
+bool CLightBuffer::Init()
+{
+    if(!glUniformBlockBinding)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Uniform buffers are not supported.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    if(!m_Shader.LoadFromSource(s_LightVS, s_LightFS) ||
+       !m_Shader.HasFrameData()) return false;
+
+    m_Shader.Bind();
+    glUniform1i(m_Shader.GetUniformLocation("tex"), 0);
+    glUniform1i(m_Shader.GetUniformLocation("shadow_map"), 1);
+    m_Shader.Unbind();
+
+    return m_UBO.Init(sizeof(light_block_t), gfx::IC_LIGHT_DATA_BINDING);
+}
+
+void CLightBuffer::Clear(const uint16_t w, const uint16_t h)
+{
+    m_count         = 0;
+    m_Block.info[0] = 0.f;
+    m_Block.info[1] = h;
+    m_Block.info[2] = w;
+}
+
+bool CLightBuffer::Add(const gfx::CLight* pLight, const bool shadowed)
+{
+    if(pLight == NULL || pLight->GetType() == IC_NO_LIGHT) return true;
+    if(m_count >= MAX_LIGHTS) return false;
+
+    gfx::light_data_t& Light = m_Block.lights[m_count++];
+
+    Light.pos[0]    = pLight->GetPosition().x;
+    Light.pos[1]    = pLight->GetPosition().y;
+    Light.type      = (float)pLight->GetType();
+    Light.brt       = pLight->GetBrightness();
+
+    Light.color[0]  = pLight->GetColor().r;
+    Light.color[1]  = pLight->GetColor().g;
+    Light.color[2]  = pLight->GetColor().b;
+    Light.color[3]  = 1.f;
+
+    Light.att[0]    = pLight->GetAttenuation().x;
+    Light.att[1]    = pLight->GetAttenuation().y;
+    Light.att[2]    = pLight->GetAttenuation().z;
+    Light.att[3]    = pLight->GetRadius();
+
+    // Same cone as CLight::GetInfluence(), counter-clockwise from the
+    // minimum angle to the maximum one.
+    float a0 = pLight->GetMinimumAngle(), a1 = pLight->GetMaximumAngle();
+    while(a1 < a0) a1 += 360.f;
+
+    bool angled = pLight->GetType() == IC_DIRECTIONAL_LIGHT &&
+                  pLight->IsAngled() && (a1 - a0 < 360.f);
+
+    Light.cone[0]   = math::rad(a0);
+    Light.cone[1]   = math::rad(a1 - a0);
+    Light.cone[2]   = angled ? 1.f : 0.f;
+    Light.cone[3]   = (shadowed && pLight->GetType() == IC_POINT_LIGHT) ?
+                      1.f : 0.f;
+
+    m_Block.info[0] = (float)m_count;
+    return true;
+}
+
+void CLightBuffer::Update()
+{
+    // Only the lights in use need to go up.
+    m_UBO.Update(&m_Block, sizeof(m_Block.info) +
+                           sizeof(gfx::light_data_t) * m_count);
+}
+
+void CLightBuffer::Enable()
+{
+    m_Shader.Bind();
+}
+
+void CLightBuffer::Disable()
+{
+    m_Shader.Unbind();
+}
@@ -1,27 +1,184 @@
 #include "IronClad/Graphics/MeshInstance.hpp"
+#include "IronClad/Graphics/Visibility.hpp"
+#include "IronClad/Graphics/StaticGeometry.hpp"
 
 using namespace ic;
 using gfx::CMeshInstance;
 
-CMeshInstance::CMeshInstance() : mp_ActiveMesh(NULL),
+CMeshInstance::CMeshInstance() : mp_ActiveMesh(NULL), m_Scale(1.f, 1.f),
     m_RotationZ(1.f, 0.f), m_RotationX(1.f, 0.f), m_RotationY(1.f, 0.f),
-    m_hflip(false), m_vflip(false), mp_scene_ptr(NULL)
+    m_hflip(false), m_vflip(false), m_dirty(true), mp_scene_ptr(NULL),
+    mp_Grid(NULL), m_proxy(-1), mp_Static(NULL), m_static_id(-1)
 {
     memset(m_degrees, 0, sizeof(m_degrees));
 }
 
+CMeshInstance::CMeshInstance(const CMeshInstance& Copy) :
+    mp_ActiveMesh(Copy.mp_ActiveMesh), m_Position(Copy.m_Position),
+    m_Dimensions(Copy.m_Dimensions), m_Scale(Copy.m_Scale),
+    m_RotationX(Copy.m_RotationX), m_RotationY(Copy.m_RotationY),
+    m_RotationZ(Copy.m_RotationZ), m_vflip(Copy.m_vflip),
+    m_hflip(Copy.m_hflip), m_dirty(true), mp_scene_ptr(Copy.mp_scene_ptr),
+    mp_Grid(NULL), m_proxy(-1), mp_Static(NULL), m_static_id(-1)
+{
+    memcpy(m_degrees, Copy.m_degrees, sizeof(m_degrees));
+}
+
+CMeshInstance::~CMeshInstance()
+{
+    if(mp_Grid)     mp_Grid->Detach(m_proxy);
+    if(mp_Static)   mp_Static->Detach(m_static_id);
+}
+
 CMeshInstance& CMeshInstance::operator=(const CMeshInstance& Copy)
 {
+    if(this == &Copy) return (*this);
+
+    // Grid and chunk bindings stay with this instance, but they need
+    // to hear about the new bounds.
+    mp_ActiveMesh   = Copy.mp_ActiveMesh;
     m_Position      = Copy.m_Position;
     m_Dimensions    = Copy.m_Dimensions;
-    mp_ActiveMesh   = Copy.mp_ActiveMesh;
+    m_Scale         = Copy.m_Scale;
+    m_RotationX     = Copy.m_RotationX;
+    m_RotationY     = Copy.m_RotationY;
+    m_RotationZ     = Copy.m_RotationZ;
+    m_vflip         = Copy.m_vflip;
+    m_hflip         = Copy.m_hflip;
+    memcpy(m_degrees, Copy.m_degrees, sizeof(m_degrees));
 
+    this->Invalidate();
     return (*this);
 }
 
+void CMeshInstance::Move(const math::vector2_t& Pos)
+{
+    m_Position.x = Pos.x;
+    m_Position.y = Pos.y;
+
+    this->Invalidate();
+}
+
+void CMeshInstance::RotateX(const float degrees)
+{
+    this->Rotate(0, degrees);
+}
+
+void CMeshInstance::RotateY(const float degrees)
+{
+    this->Rotate(1, degrees);
+}
+
+void CMeshInstance::RotateZ(const float degrees)
+{
+    this->Rotate(2, degrees);
+}
+
+void CMeshInstance::Rotate(const uint8_t axis, float degrees)
+{
+    while(degrees > 360.f)  degrees -= 360.f;
+    while(degrees < 0.f)    degrees += 360.f;
+
+    math::vector2_t* pRotations[] = {
+        &m_RotationX, &m_RotationY, &m_RotationZ
+    };
+
+    m_degrees[axis]     = degrees;
+    pRotations[axis]->x = cos(math::rad(degrees));
+    pRotations[axis]->y = sin(math::rad(degrees));
+
+    this->Invalidate();
+}
+
+bool CMeshInstance::VFlip()
+{
+    m_vflip = !m_vflip;
+    this->Invalidate();
+    return m_vflip;
+}
+
+bool CMeshInstance::HFlip()
+{
+    m_hflip = !m_hflip;
+    this->Invalidate();
+    return m_hflip;
+}
+
+void CMeshInstance::Scale(const math::vector2_t& Factor)
+{
+    m_Scale = Factor;
+    this->Invalidate();
+}
+
+void CMeshInstance::Invalidate()
+{
+    m_dirty = true;
+    if(mp_Grid)     mp_Grid->Update(m_proxy);
+    if(mp_Static)   mp_Static->Update(m_static_id);
+}
+
+void CMeshInstance::UpdateWorldTransform() const
+{
+    // The upper-left of Rz * Ry * Rx, since there's no depth to keep.
+    const float cx = m_RotationX.x, sx = m_RotationX.y;
+    const float cy = m_RotationY.x, sy = m_RotationY.y;
+    const float cz = m_RotationZ.x, sz = m_RotationZ.y;
+
+    // Flipping and scaling happen first, in the mesh's own space.
+    const float fx = m_hflip ? -m_Scale.x : m_Scale.x;
+    const float fy = m_vflip ? -m_Scale.y : m_Scale.y;
+
+    m_World.m[0] = cz * cy * fx;
+    m_World.m[1] = sz * cy * fx;
+    m_World.m[2] = (cz * sy * sx - sz * cx) * fy;
+    m_World.m[3] = (sz * sy * sx + cz * cx) * fy;
+    m_World.m[4] = m_Position.x;
+    m_World.m[5] = m_Position.y;
+
+    m_dirty = false;
+}
+
+void CMeshInstance::GetWorldBounds(math::vector2_t& Min,
+                                   math::vector2_t& Max) const
+{
+    if(mp_ActiveMesh == NULL)
+    {
+        Min = Max = m_Position;
+        return;
+    }
+
+    // Bound the transformed corners of the mesh's own bounds.
+    const math::affine2x3_t& World = this->GetWorldTransform();
+    const math::vector2_t& LMin = mp_ActiveMesh->GetMin();
+    const math::vector2_t& LMax = mp_ActiveMesh->GetMax();
+
+    const math::vector2_t Corners[4] = {
+        World * LMin,
+        World * math::vector2_t(LMax.x, LMin.y),
+        World * LMax,
+        World * math::vector2_t(LMin.x, LMax.y)
+    };
+
+    Min = Max = Corners[0];
+    for(uint8_t i = 1; i < 4; ++i)
+    {
+        Min.x = math::min<float>(Min.x, Corners[i].x);
+        Min.y = math::min<float>(Min.y, Corners[i].y);
+        Max.x = math::max<float>(Max.x, Corners[i].x);
+        Max.y = math::max<float>(Max.y, Corners[i].y);
+    }
+}
+
 bool CMeshInstance::LoadMesh(asset::CMesh* pMesh)
 {
-    if(pMesh) mp_ActiveMesh = pMesh;
+    if(pMesh)
+    {
+        mp_ActiveMesh  = pMesh;
+        m_Dimensions.x = pMesh->GetMeshWidth();
+        m_Dimensions.y = pMesh->GetMeshHeight();
+    }
+
+    this->Invalidate();
     return (pMesh != NULL);
 }
 
@@ -29,6 +186,7 @@ bool CMeshInstance::LoadMesh(const std::string& filename)
 {
     mp_ActiveMesh = asset::CAssetManager::Create
                                   <asset::CMesh>(filename, mp_scene_ptr);
+    this->Invalidate();
     return (mp_ActiveMesh != NULL);
 }
 
@@ -50,5 +208,8 @@ bool CMeshInstance::LoadMesh(const vertex2_t* verts, const uint16_t vsize,
 
     mp_ActiveMesh = asset::CAssetManager::Create<asset::CMesh>();
     mp_ActiveMesh->SetFilename("Raw mesh");
-    return mp_ActiveMesh->LoadFromRaw(verts, vsize, inds, isize);
+
+    bool loaded = mp_ActiveMesh->LoadFromRaw(verts, vsize, inds, isize);
+    this->Invalidate();
+    return loaded;
 }
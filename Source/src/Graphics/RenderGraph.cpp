@@ -0,0 +1,191 @@
+#include "IronClad/Graphics/RenderGraph.hpp"
+#include "IronClad/Graphics/GLState.hpp"
+
+using namespace ic;
+using gfx::CRenderGraph;
+using util::g_Log;
+
+CRenderGraph::CRenderGraph() : mp_Pool(NULL), m_w(0), m_h(0),
+                               m_current(0), m_culled(0) {}
+
+CRenderGraph::~CRenderGraph()
+{
+    this->Release();
+}
+
+void CRenderGraph::Reset(gfx::CRenderTargetPool& Pool,
+                         const uint16_t w, const uint16_t h)
+{
+    this->Release();
+
+    mp_Pool = &Pool;
+    m_w = w; m_h = h;
+    m_current = 0;
+    m_culled = 0;
+
+    m_Passes.clear();
+    m_Resources.clear();
+
+    // The screen always exists and is always needed.
+    this->AddTarget();
+}
+
+uint8_t CRenderGraph::AddTarget(const bool depth)
+{
+    resource_t Resource = { NULL, -1, -1, depth, false };
+    m_Resources.push_back(Resource);
+    return m_Resources.size() - 1;
+}
+
+uint8_t CRenderGraph::AddPass(const uint32_t id, const uint8_t output,
+                              const color4f_t* pClear)
+{
+    pass_t Pass;
+    Pass.id     = id;
+    Pass.output = output;
+    Pass.count  = 0;
+    Pass.clear  = (pClear != NULL);
+    Pass.live   = false;
+    if(pClear != NULL) Pass.Clear = *pClear;
+
+    m_Passes.push_back(Pass);
+    return m_Passes.size() - 1;
+}
+
+void CRenderGraph::Read(const uint8_t pass, const uint8_t resource)
+{
+    pass_t& Pass = m_Passes[pass];
+    if(Pass.count < MAX_INPUTS) Pass.inputs[Pass.count++] = resource;
+}
+
+void CRenderGraph::Compile()
+{
+    for(size_t i = 0; i < m_Resources.size(); ++i)
+    {
+        m_Resources[i].needed = false;
+        m_Resources[i].first = m_Resources[i].last = -1;
+    }
+
+    m_Resources[SCREEN].needed = true;
+
+    // Walk back from the screen, keeping only the passes whose output
+    // is still going to be read.
+    for(size_t i = m_Passes.size(); i-- > 0; )
+    {
+        pass_t& Pass = m_Passes[i];
+        resource_t& Output = m_Resources[Pass.output];
+
+        Pass.live = Output.needed;
+        if(!Pass.live)
+        {
+            ++m_culled;
+            continue;
+        }
+
+        // A cleared target doesn't care what was in it before.
+        if(Pass.clear && Pass.output != SCREEN) Output.needed = false;
+
+        for(uint8_t j = 0; j < Pass.count; ++j)
+            m_Resources[Pass.inputs[j]].needed = true;
+    }
+
+    // Every target lives from its first live use to its last one.
+    for(size_t i = 0; i < m_Passes.size(); ++i)
+    {
+        const pass_t& Pass = m_Passes[i];
+        if(!Pass.live) continue;
+
+        for(uint8_t j = 0; j <= Pass.count; ++j)
+        {
+            resource_t& Resource = m_Resources[(j == Pass.count) ?
+                Pass.output : Pass.inputs[j]];
+
+            if(Resource.first < 0) Resource.first = i;
+            Resource.last = i;
+        }
+    }
+}
+
+bool CRenderGraph::Begin(uint32_t& id)
+{
+    for( ; m_current < m_Passes.size(); ++m_current)
+    {
+        pass_t& Pass = m_Passes[m_current];
+        if(!Pass.live) continue;
+
+        resource_t& Output = m_Resources[Pass.output];
+        if(Pass.output != SCREEN && Output.pTarget == NULL)
+        {
+            Output.pTarget = mp_Pool->Acquire(m_w, m_h, Output.depth);
+
+            // The pool already complained.
+            if(Output.pTarget == NULL) continue;
+        }
+
+        this->Enable();
+        if(Pass.clear)
+        {
+            glClearColor(Pass.Clear.r, Pass.Clear.g,
+                         Pass.Clear.b, Pass.Clear.a);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        }
+
+        id = Pass.id;
+        return true;
+    }
+
+    return false;
+}
+
+void CRenderGraph::Enable()
+{
+    const pass_t& Pass = m_Passes[m_current];
+    gfx::CFrameBuffer* pTarget = m_Resources[Pass.output].pTarget;
+
+    if(pTarget != NULL)
+    {
+        pTarget->Enable();
+    }
+    else
+    {
+        gfx::CGLState::BindFramebuffer(gfx::CWindow::GetScreenBuffer());
+        gfx::CGLState::Viewport(0, 0, m_w, m_h);
+    }
+}
+
+void CRenderGraph::End()
+{
+    const pass_t& Pass = m_Passes[m_current];
+
+    for(uint8_t j = 0; j <= Pass.count; ++j)
+    {
+        resource_t& Resource = m_Resources[(j == Pass.count) ?
+            Pass.output : Pass.inputs[j]];
+
+        if(Resource.last != (int)m_current || Resource.pTarget == NULL)
+            continue;
+
+        mp_Pool->Release(Resource.pTarget);
+        Resource.pTarget = NULL;
+    }
+
+    ++m_current;
+}
+
+uint32_t CRenderGraph::GetTexture(const uint8_t resource) const
+{
+    const gfx::CFrameBuffer* pTarget = m_Resources[resource].pTarget;
+    return pTarget ? pTarget->GetTexture() : 0;
+}
+
+void CRenderGraph::Release()
+{
+    // Only left over if a frame never finished.
+    for(size_t i = 0; i < m_Resources.size(); ++i)
+    {
+        if(m_Resources[i].pTarget == NULL) continue;
+
+        mp_Pool->Release(m_Resources[i].pTarget);
+        m_Resources[i].pTarget = NULL;
+    }
+}
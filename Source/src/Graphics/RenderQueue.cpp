@@ -0,0 +1,232 @@
+#include <algorithm>
+
+#include "IronClad/Graphics/RenderQueue.hpp"
+
+using namespace ic;
+using gfx::CRenderQueue;
+using gfx::render_item_t;
+
+namespace
+{
+    bool ByState(const render_item_t& A, const render_item_t& B)
+    {
+        if(A.program != B.program) return A.program < B.program;
+        if(A.texture != B.texture) return A.texture < B.texture;
+        return A.pSurface < B.pSurface;
+    }
+}
+
+CRenderQueue::CRenderQueue() : m_unsorted_changes(0), m_sorted_changes(0),
+                               m_depth_tested(false) {}
+CRenderQueue::~CRenderQueue() {}
+
+void CRenderQueue::Clear()
+{
+    m_Items.clear();
+    m_unsorted_changes = m_sorted_changes = 0;
+}
+
+uint64_t CRenderQueue::MakeKey(const uint8_t layer, const uint16_t z,
+                               const uint32_t order)
+{
+    // Whatever is drawn last ends up on top, so anything that might
+    // overlap has to keep its order.
+    uint64_t key = 0;
+    key |= (uint64_t)layer << 56;
+    key |= (uint64_t)z     << 40;
+    key |= (uint64_t)order;
+    return key;
+}
+
+uint64_t CRenderQueue::MakeDepthKey(const uint32_t rank,
+                                    const bool translucent,
+                                    const uint32_t program,
+                                    const uint32_t texture)
+{
+    // Back to front, exactly as without depth testing.
+    if(translucent) return ((uint64_t)1 << 63) | rank;
+
+    // Grouped by state, then front to back so the depth test rejects
+    // whatever is covered before it's shaded.
+    uint64_t key = 0;
+    key |= (uint64_t)(program & 0xFFFF) << 47;
+    key |= (uint64_t)(texture & 0xFFFF) << 31;
+    key |= (uint64_t)(~rank & 0x7FFFFFFF);
+    return key;
+}
+
+void CRenderQueue::Push(obj::CEntity* pEntity, gfx::surface_t* pSurface,
+                        const uint32_t program, const uint32_t texture,
+                        const bool translucent, const uint32_t order)
+{
+    this->Push(pEntity->GetLayer(), pEntity->GetDepth(), pSurface,
+               program, texture, translucent);
+
+    m_Items.back().pEntity  = pEntity;
+    m_Items.back().key     |= order;
+}
+
+void CRenderQueue::Push(const uint8_t layer, const float z,
+                        gfx::surface_t* pSurface,
+                        const uint32_t program, const uint32_t texture,
+                        const bool translucent)
+{
+    const uint16_t depth = (uint16_t)(math::clamp<float>(z, 0.f, 1.f) *
+                                      0xFFFF);
+
+    render_item_t Item;
+    Item.pEntity     = NULL;
+    Item.pSurface    = pSurface;
+    Item.program     = program;
+    Item.texture     = texture;
+    Item.depth       = 0.f;
+    Item.translucent = translucent;
+    Item.key         = CRenderQueue::MakeKey(layer, depth, 0);
+
+    m_Items.push_back(Item);
+}
+
+bool CRenderQueue::StartsGroup(const size_t i) const
+{
+    if(i == 0) return true;
+
+    const render_item_t& Item = m_Items[i];
+    const render_item_t& Prev = m_Items[i - 1];
+
+    // The depth test puts opaque surfaces in order, and they all come
+    // before the first translucent one.
+    if(m_depth_tested)
+    {
+        if(!Item.translucent) return false;
+        if(!Prev.translucent) return true;
+    }
+
+    // A batch draws its instances in order, so it may only grow by
+    // the same sprite as the last one.
+    return Item.texture  != Prev.texture ||
+           Item.pSurface != Prev.pSurface;
+}
+
+void CRenderQueue::Sort()
+{
+    m_unsorted_changes = CRenderQueue::CountChanges(m_Items);
+
+    // Draw order first.
+    this->RadixSort();
+
+    // Give every surface its own depth from its place in that order,
+    // so the depth test settles overlaps exactly like drawing in order
+    // would, then regroup the opaque ones by state.
+    if(m_depth_tested)
+    {
+        const float step = 1.f / (m_Items.size() + 1);
+        for(size_t i = 0; i < m_Items.size(); ++i)
+        {
+            render_item_t& Item = m_Items[i];
+            Item.depth = (i + 1) * step;
+            Item.key   = CRenderQueue::MakeDepthKey(i, Item.translucent,
+                                                    Item.program,
+                                                    Item.texture);
+        }
+
+        this->RadixSort();
+    }
+    else
+    {
+        this->SortRuns();
+    }
+
+    m_sorted_changes = CRenderQueue::CountChanges(m_Items);
+}
+
+void CRenderQueue::RadixSort()
+{
+    if(m_Items.size() < 2) return;
+
+    m_Swap.resize(m_Items.size());
+
+    // LSD radix sort, a byte at a time.
+    for(uint32_t shift = 0; shift < 64; shift += 8)
+    {
+        uint32_t counts[256] = { 0 };
+        for(size_t i = 0; i < m_Items.size(); ++i)
+            ++counts[(m_Items[i].key >> shift) & 0xFF];
+
+        // Every key has the same byte here, nothing to do.
+        if(counts[(m_Items[0].key >> shift) & 0xFF] == m_Items.size())
+            continue;
+
+        // Turn the counts into starting offsets.
+        uint32_t total = 0;
+        for(size_t i = 0; i < 256; ++i)
+        {
+            uint32_t count = counts[i];
+            counts[i] = total;
+            total += count;
+        }
+
+        for(size_t i = 0; i < m_Items.size(); ++i)
+            m_Swap[counts[(m_Items[i].key >> shift) & 0xFF]++] = m_Items[i];
+
+        m_Items.swap(m_Swap);
+    }
+}
+
+void CRenderQueue::SortRuns()
+{
+    const size_t count = m_Items.size();
+    if(count < 2) return;
+
+    m_Bounds.resize(count);
+    for(size_t i = 0; i < count; ++i)
+    {
+        bounds_t& Bounds = m_Bounds[i];
+        Bounds.valid = (m_Items[i].pEntity != NULL);
+        if(Bounds.valid)
+            m_Items[i].pEntity->GetMesh().GetWorldBounds(Bounds.Min,
+                                                         Bounds.Max);
+    }
+
+    // Grow each run until the next surface might cover one already in
+    // it, then sort the run by state. Runs are capped so the overlap
+    // test stays linear in the size of the queue.
+    size_t start = 0;
+    for(size_t i = 1; i <= count; ++i)
+    {
+        bool ends = (i == count) || (i - start >= MAX_RUN) ||
+                    !m_Bounds[i].valid || !m_Bounds[start].valid;
+
+        for(size_t j = start; !ends && j < i; ++j)
+        {
+            const bounds_t& A = m_Bounds[i];
+            const bounds_t& B = m_Bounds[j];
+            ends = A.Min.x < B.Max.x && B.Min.x < A.Max.x &&
+                   A.Min.y < B.Max.y && B.Min.y < A.Max.y;
+        }
+
+        if(!ends) continue;
+
+        if(i - start > 1)
+        {
+            std::stable_sort(m_Items.begin() + start, m_Items.begin() + i,
+                             ByState);
+        }
+
+        start = i;
+    }
+}
+
+uint32_t CRenderQueue::CountChanges(const std::vector<render_item_t>& Items)
+{
+    if(Items.empty()) return 0;
+
+    // The first item always has to bind both.
+    uint32_t changes = 2;
+    for(size_t i = 1; i < Items.size(); ++i)
+    {
+        if(Items[i].program != Items[i - 1].program) ++changes;
+        if(Items[i].texture != Items[i - 1].texture) ++changes;
+    }
+
+    return changes;
+}
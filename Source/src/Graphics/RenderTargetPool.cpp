@@ -0,0 +1,67 @@
+#include "IronClad/Graphics/RenderTargetPool.hpp"
+
+using namespace ic;
+using gfx::CRenderTargetPool;
+using util::g_Log;
+
+CRenderTargetPool::~CRenderTargetPool()
+{
+    this->Clear();
+}
+
+gfx::CFrameBuffer* CRenderTargetPool::Acquire(const uint16_t w,
+                                              const uint16_t h,
+                                              const bool depth)
+{
+    for(size_t i = 0; i < m_Targets.size(); ++i)
+    {
+        target_t& Target = m_Targets[i];
+        if(Target.used || Target.w != w || Target.h != h ||
+           Target.depth != depth) continue;
+
+        Target.used = true;
+        return Target.pTarget;
+    }
+
+    target_t Target = { new gfx::CFrameBuffer, w, h, depth, true };
+    if(!Target.pTarget->Init(w, h, depth))
+    {
+        delete Target.pTarget;
+
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to create " << w << "x" << h;
+        g_Log << " render target.\n";
+        g_Log.PrintLastLog();
+        return NULL;
+    }
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] GFX: Created " << w << "x" << h << " render target (";
+    g_Log << m_Targets.size() + 1 << " pooled).\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    m_Targets.push_back(Target);
+    return Target.pTarget;
+}
+
+void CRenderTargetPool::Release(const gfx::CFrameBuffer* pTarget)
+{
+    for(size_t i = 0; i < m_Targets.size(); ++i)
+    {
+        if(m_Targets[i].pTarget == pTarget)
+        {
+            m_Targets[i].used = false;
+            return;
+        }
+    }
+}
+
+void CRenderTargetPool::Clear()
+{
+    for(size_t i = 0; i < m_Targets.size(); ++i)
+        delete m_Targets[i].pTarget;
+
+    m_Targets.clear();
+}
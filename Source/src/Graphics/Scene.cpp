@@ -1,4 +1,7 @@
 #include "IronClad/Graphics/Scene.hpp"
+#include "IronClad/Utils/Profiler.hpp"
+#include "IronClad/Utils/Timer.hpp"
+#include "IronClad/Graphics/GLError.hpp"
 
 using namespace ic;
 using gfx::CScene;
@@ -8,10 +11,14 @@ using gfx::Globals;
 gfx::material_t CScene::m_ShadowShader;
 
 CScene::CScene(gfx::CWindow& Window, const gfx::SceneType scene) : 
+    mp_Window(&Window), m_shadow_frame(0),
     m_WindowDim(Window.GetW(), Window.GetH()),
     m_WindowProj(Window.GetProjectionMatrixC()),
-    mp_Window(&Window), m_postfx(true), m_lighting(true),
-    m_geo_type(GL_TRIANGLES)
+    m_geo_type(GL_TRIANGLES), m_lighting(true), m_postfx(true),
+    m_batching(true), m_culling(true), m_baking(true), m_bake_all(false),
+    m_depth(true), m_light_buffer(false), m_light_buffer_ok(false),
+    m_shadows(false), m_shadows_ok(false),
+    m_profiling(false), m_profiling_ok(false)
 {
     switch(scene)
     {
@@ -22,17 +29,20 @@ CScene::CScene(gfx::CWindow& Window, const gfx::SceneType scene) :
 
     case IC_STATIC_SCENE:
         m_GeometryVBO.SetType(GL_STATIC_DRAW);
+        m_bake_all = true;
         break;
     }
-
-    m_ShadowVBO.SetType(GL_DYNAMIC_DRAW);
 }
 
 CScene::CScene(const uint16_t w, const uint16_t h,
                const math::matrix4x4_t& proj,
                const gfx::SceneType scene_type) : 
-    m_WindowDim(w, h), m_WindowProj(proj), mp_Window(NULL), 
-    m_postfx(true),    m_lighting(true),   m_geo_type(GL_TRIANGLES)
+    mp_Window(NULL), m_shadow_frame(0), m_WindowDim(w, h), m_WindowProj(proj),
+    m_geo_type(GL_TRIANGLES), m_lighting(true), m_postfx(true),
+    m_batching(true), m_culling(true), m_baking(true), m_bake_all(false),
+    m_depth(true), m_light_buffer(false), m_light_buffer_ok(false),
+    m_shadows(false), m_shadows_ok(false),
+    m_profiling(false), m_profiling_ok(false)
 {
     switch(scene_type)
     {
@@ -43,21 +53,46 @@ CScene::CScene(const uint16_t w, const uint16_t h,
 
     case IC_STATIC_SCENE:
         m_GeometryVBO.SetType(GL_STATIC_DRAW);
+        m_bake_all = true;
         break;
     }
-
-    m_ShadowVBO.SetType(GL_DYNAMIC_DRAW);
 }
 
-CScene::~CScene(){}
+CScene::~CScene()
+{
+    this->StopStatsLog();
+}
 
 bool CScene::Init()
 {
-    // Initialize frame-buffer.
-    return (m_GeometryVBO.Init()                            &&
-            m_ShadowVBO.Init()                              &&
-            m_FBO.Init(m_WindowDim.x, m_WindowDim.y)        &&
-            m_FBOSwap.Init(m_WindowDim.x, m_WindowDim.y));
+    // Batching is optional, fall back to per-entity rendering.
+    // The batch shader reads the per-frame block, so it needs both.
+    if(!m_FrameUBO.Init(sizeof(gfx::frame_data_t), gfx::IC_FRAME_DATA_BINDING) ||
+       !m_Batch.Init()) m_batching = false;
+
+    // Same for single-pass lighting, which falls back to a pass per light.
+    m_light_buffer_ok = (m_FrameUBO.GetBuffer() != 0) && m_LightBuffer.Init();
+    m_shadows_ok      = m_light_buffer_ok &&
+                        m_ShadowMap.Init(m_WindowDim.x, m_WindowDim.y);
+
+    // Profiling is optional too, it just reports no GPU times.
+    m_profiling_ok    = m_GPUTimer.Init();
+
+    // Shadows are rebuilt whenever something moves.
+    m_ShadowVBO.SetType(GL_DYNAMIC_DRAW);
+
+    // Off-screen targets are created as passes need them, but make
+    // sure the first one works, and keep it around for the first frame.
+    gfx::CFrameBuffer* pTarget = m_TargetPool.Acquire(m_WindowDim.x,
+                                                      m_WindowDim.y, true);
+    m_TargetPool.Release(pTarget);
+
+    // Baked chunks live alongside the meshes they came from.
+    m_Static.Init(m_GeometryVBO);
+
+    return (m_GeometryVBO.Init()    &&
+            m_ShadowVBO.Init()      &&
+            pTarget != NULL);
 }
 
 obj::CEntity* CScene::AddMesh(
@@ -79,7 +114,7 @@ obj::CEntity* CScene::AddMesh(
     }
 
     pFinal->Move(Pos);
-    mp_sceneObjects.push_back(pFinal);
+    this->AddMesh(pFinal);
     return pFinal;
 }
 
@@ -93,143 +128,435 @@ obj::CEntity* CScene::AddMesh(asset::CMesh* pMesh, const math::vector2_t& Pos)
     }
 
     pFinal->Move(Pos);
-    mp_sceneObjects.push_back(pFinal);
+    this->AddMesh(pFinal);
     return pFinal;
 }
 
-/**
- * @todo    Shadow generation.
- **/
+bool CScene::AddMesh(obj::CEntity* pEntity)
+{
+    if(pEntity == NULL)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Cannot add a NULL entity to a scene.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    // Leave room after the last entity for insertions.
+    if(!m_Order.empty() && m_Order.rbegin()->first > 0xFFFFFFFF - ORDER_STEP)
+        this->Renumber();
+
+    uint32_t order = m_Order.empty() ? ORDER_STEP :
+                     m_Order.rbegin()->first + ORDER_STEP;
+
+    // The grid is what ties an entity to its scene.
+    if(!m_Visibility.Insert(pEntity, order))
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Entity is already in a scene, not adding it.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    m_Order.insert(m_Order.end(), std::make_pair(order, pEntity));
+    mp_sceneObjects.push_back(pEntity);
+    if(m_bake_all || pEntity->IsStatic()) m_Static.Add(pEntity);
+    return true;
+}
+
 void CScene::Render()
 {
-    // Model-view matrix.
-    math::matrix4x4_t MVMatrix = math::IDENTITY;
+    IC_PROFILE_FUNCTION();
 
-    m_ShadowVBO.Clear();
     m_GeometryVBO.FinalizeBuffer();
 
-    // Clear swap frame-buffer.
-    m_FBOSwap.Enable();
-    m_FBOSwap.Clear();
-    m_FBOSwap.Disable();
+    // Meshes have to be on the GPU before they can be baked.
+    if(m_baking) m_Static.Rebake();
 
-    // Enable render-to-texture.
-    m_FBO.Enable();
-    m_FBO.Clear();
+    bool wire = (m_geo_type == GL_LINE_STRIP ||
+                 m_geo_type == GL_LINE_LOOP  ||
+                 m_geo_type == GL_LINES);
 
-    // Clear frame-buffer settings.
-    glClearColor(0.1f, 0.1f, 0.1f, 1.f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_Stats = gfx::scene_stats_t();
+    gfx::Counters::Reset();
 
-    // Blending is essential.
-    glEnable(GL_BLEND);
-    glDisable(GL_DEPTH_TEST);
+    bool profile = m_profiling && m_profiling_ok;
+    if(profile) m_GPUTimer.BeginFrame();
 
-    // Normal transparency blending function.
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    // Upload the per-frame uniforms once, every shader shares them.
+    this->UpdateFrameData();
 
-    // Bind geometry VBO.
-    m_GeometryVBO.Bind();
+    // Only look at what the camera can see.
+    if(m_culling)
+    {
+        m_Visibility.Query(math::rect_t(-m_Camera.x, -m_Camera.y,
+            m_WindowDim.x, m_WindowDim.y), mp_visibleObjects);
 
-    // Render all of the meshes.
-    for(size_t i = 0; i < mp_sceneObjects.size(); ++i)
+        m_Stats.culled_entities = mp_sceneObjects.size() - 
+                                  mp_visibleObjects.size();
+    }
+
+    const std::vector<obj::CEntity*>& Objects = 
+        m_culling ? mp_visibleObjects : mp_sceneObjects;
+
+    // Queue up every visible surface. Depth is pointless if the
+    // projection throws it away.
+    m_Queue.Clear();
+    m_Queue.SetDepthTested(m_depth && m_WindowProj[2][2] != 0.f);
+
+    // Baked geometry goes underneath anything else at its layer and
+    // depth.
+    if(m_baking)
     {
-        if(!mp_sceneObjects[i]->IsRenderable()) continue;
+        math::rect_t View(-m_Camera.x, -m_Camera.y,
+                          m_WindowDim.x, m_WindowDim.y);
 
-        // Load the model-view matrix.
-        mp_sceneObjects[i]->GetMesh().LoadPositionMatrix(MVMatrix);
+        m_Stats.static_draws = m_Static.Submit(m_culling ? &View : NULL,
+                                               m_Queue);
+    }
 
-        // Adjust for the camera.
-        MVMatrix[0][3] += m_Camera.x;
-        MVMatrix[1][3] += m_Camera.y;
-        
-        // Get mesh surfaces.
-        const std::vector<gfx::surface_t*>& meshSurfaces = 
-            mp_sceneObjects[i]->GetMesh().GetSurfaces();
+    for(size_t i = 0; i < Objects.size(); ++i)
+    {
+        obj::CEntity* pEntity = Objects[i];
+        if(!pEntity->IsRenderable()) continue;
 
-        // Quads get one single texture, this accounts for animation.
-        if(meshSurfaces.size() == 1)
-        {
-            this->StandardRender(mp_sceneObjects[i], MVMatrix);
-        }
-        else
+        // Drawn as part of a chunk instead.
+        if(m_baking && pEntity->GetMesh().IsBaked()) continue;
+
+        std::vector<gfx::surface_t*>& Surfaces = 
+            pEntity->GetMesh().GetSurfaces();
+
+        for(size_t j = 0; j < Surfaces.size(); ++j)
         {
-            // Render each surface.
-            for(size_t j = 0; j < meshSurfaces.size(); ++j)
-            {
-                this->StandardRender(meshSurfaces[j], MVMatrix);
-            }
+            gfx::material_t* pMaterial = Surfaces[j]->pMaterial;
+            if(pMaterial == NULL) continue;
+
+            // Quads get one single texture, this accounts for animation.
+            asset::CTexture* pTexture = (Surfaces.size() == 1) ?
+                pEntity->GetTexture() : pMaterial->pTexture;
+
+            if(wire || pTexture == NULL) pTexture = Globals::g_WhiteTexture;
+
+            uint32_t program = pMaterial->pShader ? 
+                pMaterial->pShader->GetProgram() : 0;
+
+            // Custom shaders can do anything with alpha, so never
+            // consider them opaque.
+            bool translucent = (pMaterial->pShader != NULL) ||
+                               !pTexture->IsOpaque();
+
+            m_Queue.Push(pEntity, Surfaces[j], program,
+                         pTexture->GetTextureID(), translucent,
+                         m_Visibility.GetOrder(pEntity));
         }
     }
 
-    uint32_t final_texture = m_FBO.GetTexture();
+    m_Queue.Sort();
+
+    // Lay out the frame. Without lighting or post-processing, there's
+    // nothing to do off-screen and the scene is drawn straight to the
+    // screen. Without lighting, the lighting pass is culled.
+    static const color4f_t Background(0.1f, 0.1f, 0.1f, 1.f);
+    static const color4f_t Black(0.f, 0.f, 0.f, 1.f);
+
+    bool post = m_postfx && !mp_sceneEffects.empty();
+
+    m_Graph.Reset(m_TargetPool, m_WindowDim.x, m_WindowDim.y);
+    uint8_t scene = (m_lighting || post) ?
+        m_Graph.AddTarget(true) : gfx::CRenderGraph::SCREEN;
+    uint8_t lit = m_Graph.AddTarget(m_shadows);
 
-    if(m_lighting)
+    m_Graph.AddPass(IC_GEOMETRY_PASS, scene, &Background);
+    m_Graph.Read(m_Graph.AddPass(IC_LIGHTING_PASS, lit, &Black), scene);
+
+    if(scene != gfx::CRenderGraph::SCREEN)
     {
-        Globals::g_FullscreenVBO.Bind();
+        m_Graph.Read(m_Graph.AddPass(IC_PRESENT_PASS,
+            gfx::CRenderGraph::SCREEN), m_lighting ? lit : scene);
+    }
 
-        // Render effects on the scene.
-        m_FBOSwap.Enable();
-        glBindTexture(GL_TEXTURE_2D, m_FBO.GetTexture());
+    m_Graph.Compile();
 
-        // Additive blending for lighting.
-        glBlendFunc(GL_ONE, GL_ONE);
-        
-        // Render all lights onto the frame-buffer.
-        for(size_t i = 0; i < mp_sceneLights.size(); ++i)
+    uint32_t pass;
+    while(m_Graph.Begin(pass))
+    {
+        switch(pass)
         {
-            this->LightRender(mp_sceneLights[i]);
+        case IC_GEOMETRY_PASS:
+            if(profile) m_GPUTimer.Begin(IC_GEOMETRY_TIMER);
+            this->GeometryRender(wire);
+            if(profile) m_GPUTimer.End(IC_GEOMETRY_TIMER);
+            break;
+
+        case IC_LIGHTING_PASS:
+            if(profile) m_GPUTimer.Begin(IC_LIGHTING_TIMER);
+            this->LightingRender(m_Graph.GetTexture(scene));
+            if(profile) m_GPUTimer.End(IC_LIGHTING_TIMER);
+            break;
+
+        case IC_PRESENT_PASS:
+            this->PresentRender(m_Graph.GetTexture(m_lighting ? lit : scene));
+            break;
         }
 
-        // Final FBO texture to render onto the screen.
-        // This texture has all of the lighting on it.
-        final_texture = m_FBOSwap.GetTexture();
+        m_Graph.End();
+    }
+
+    // This is so the FBO blends with the data in the default frame-buffer.
+    gfx::CGLState::EnableBlending(false);
+    gfx::CGLState::BlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+
+    m_Stats.culled_passes   = m_Graph.GetCulledCount();
+    m_Stats.render_targets  = m_TargetPool.GetSize();
+    m_Stats.program_binds   = gfx::Counters::program_binds;
+    m_Stats.texture_binds   = gfx::Counters::texture_binds;
+    m_Stats.triangles       = gfx::Counters::triangles;
+    m_Stats.bytes_uploaded  = gfx::Counters::bytes_uploaded;
+    m_Stats.redundant_calls = gfx::Counters::redundant_calls;
+
+    // These lag a few frames behind, see CGPUTimer.
+    for(uint8_t i = 0; profile && i < IC_TIMER_COUNT; ++i)
+        m_Stats.gpu_time[i] = m_GPUTimer.GetTime(i);
+
+    if(m_StatsLog.is_open()) this->LogStats();
+}
+
+bool CScene::StartStatsLog(const char* pfilename)
+{
+    this->StopStatsLog();
+
+    m_StatsLog.open(pfilename, std::ios::out | std::ios::trunc);
+    if(!m_StatsLog.is_open())
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to open scene stats log: " << pfilename;
+        g_Log << "\n";
+        g_Log.PrintLastLog();
+        return false;
     }
 
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    m_StatsLog << "frame,draw_calls,program_binds,texture_binds,triangles,"
+               << "bytes_uploaded,redundant_calls,queued_surfaces,"
+               << "culled_entities,culled_lights,gpu_geometry_ms,"
+               << "gpu_shadow_ms,gpu_lighting_ms,gpu_postfx_ms,"
+               << "gpu_present_ms\n";
 
-    if(m_postfx)
+    m_log_frame = 0;
+    return true;
+}
+
+void CScene::StopStatsLog()
+{
+    if(m_StatsLog.is_open()) m_StatsLog.close();
+}
+
+void CScene::LogStats()
+{
+    m_StatsLog  << m_log_frame++             << ','
+                << m_Stats.draw_calls        << ','
+                << m_Stats.program_binds     << ','
+                << m_Stats.texture_binds     << ','
+                << m_Stats.triangles         << ','
+                << m_Stats.bytes_uploaded    << ','
+                << m_Stats.redundant_calls   << ','
+                << m_Stats.queued_surfaces   << ','
+                << m_Stats.culled_entities   << ','
+                << m_Stats.culled_lights;
+
+    for(uint8_t i = 0; i < IC_TIMER_COUNT; ++i)
+        m_StatsLog << ',' << m_Stats.gpu_time[i];
+
+    m_StatsLog << '\n';
+}
+
+void CScene::GeometryRender(const bool wire)
+{
+    IC_PROFILE_FUNCTION();
+
+    // Model-view matrix.
+    math::matrix4x4_t MVMatrix = math::IDENTITY;
+
+    // Opaque surfaces come first with depth testing, and need neither
+    // blending nor to be drawn in order, since the depth test takes
+    // care of what ends up on top.
+    const bool depth = m_Queue.IsDepthTested();
+
+    gfx::CGLState::EnableBlending(!depth);
+    gfx::CGLState::EnableDepthTest(depth);
+    gfx::CGLState::DepthMask(true);
+    if(depth) glDepthFunc(GL_LEQUAL);
+
+    // Normal transparency blending function.
+    gfx::CGLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Bind geometry VBO.
+    m_GeometryVBO.Bind();
+
+    // Render all of the meshes.
+    for(size_t i = 0; i < m_Queue.Size(); ++i)
     {
-        // If there is lighting, the post-processing should start on the
-        // swap frame buffer texture.
-        gfx::CFrameBuffer& First    = m_lighting ? m_FBOSwap : m_FBO;
-        gfx::CFrameBuffer& Second   = m_lighting ? m_FBO     : m_FBOSwap;
+        const gfx::render_item_t& Item = m_Queue[i];
+        bool single = Item.pEntity &&
+                      (Item.pEntity->GetMesh().GetSurfaces().size() == 1);
+        bool ordered = !depth || Item.translucent;
 
-        // Render each effect onto the scene.
-        // The FBOs are swapped every time,
-        // adding effects on top of one another.
-        for(size_t i = 0; i < mp_sceneEffects.size(); ++i)
+        // Batches never span anything that must be drawn in order.
+        if(m_Queue.StartsGroup(i))
         {
-            final_texture = this->PostProcessingRender(
-                mp_sceneEffects[i],
-                i % 2 == 0 ? Second : First, 
-                i % 2 == 0 ? First.GetTexture() : Second.GetTexture());
+            m_Stats.draw_calls += m_Batch.Flush(m_GeometryVBO, m_geo_type);
+
+            // Translucent surfaces are tested against the opaque ones,
+            // but must not hide each other.
+            if(depth && ordered)
+            {
+                gfx::CGLState::EnableBlending(true);
+                gfx::CGLState::DepthMask(false);
+            }
         }
+
+        float z = depth ? this->GetDepthOffset(Item.depth) : 0.f;
+
+        // Sprites go into the instanced batch.
+        if(m_batching && single && m_Batch.Add(Item.pEntity, wire, z))
+            continue;
+
+        // Anything else is drawn immediately, so draw whatever has been
+        // batched so far to keep it underneath, unless depth does that.
+        if(ordered)
+            m_Stats.draw_calls += m_Batch.Flush(m_GeometryVBO, m_geo_type);
+
+        // Load the model-view matrix, baked geometry is already in
+        // world space.
+        if(Item.pEntity)    Item.pEntity->GetMesh().LoadPositionMatrix(MVMatrix);
+        else                MVMatrix.LoadAffine(math::affine2x3_t());
+
+        // Adjust for the camera.
+        MVMatrix[0][3] += m_Camera.x;
+        MVMatrix[1][3] += m_Camera.y;
+        MVMatrix[2][3]  = z;
+
+        // Baked geometry is already mapped into its atlas page.
+        if(single)  this->StandardRender(Item.pEntity, MVMatrix);
+        else        this->StandardRender(Item.pSurface, MVMatrix,
+                                         Item.pEntity ? 0 : Item.texture);
+
+        ++m_Stats.draw_calls;
     }
 
-    // This is so the FBO blends with the data in the default frame-buffer.
-    glDisable(GL_BLEND);
-    glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE);
+    m_Stats.draw_calls += m_Batch.Flush(m_GeometryVBO, m_geo_type);
+
+    // The other passes are 2D, and clears need depth writes.
+    gfx::CGLState::EnableBlending(true);
+    gfx::CGLState::EnableDepthTest(false);
+    gfx::CGLState::DepthMask(true);
+
+    m_Stats.queued_surfaces     = m_Queue.Size();
+    m_Stats.state_changes       = m_Queue.GetSortedChanges();
+    m_Stats.state_changes_saved = m_Queue.GetUnsortedChanges() -
+                                  m_Queue.GetSortedChanges();
+
+    IC_GL_CHECK();
+}
+
+float CScene::GetDepthOffset(const float depth)
+{
+    // Nearest ends up at -0.9 in clip space, the furthest at 0.9, well
+    // inside what the projection keeps.
+    return (0.9f * (1.f - 2.f * depth) - m_WindowProj[2][3]) /
+            m_WindowProj[2][2];
+}
+
+void CScene::LightingRender(const uint32_t source)
+{
+    IC_PROFILE_FUNCTION();
 
-    // Render to the screen now.
-    m_FBOSwap.Disable();
     Globals::g_FullscreenVBO.Bind();
+
+    // Shade with as many lights as fit in the buffer at once, any
+    // that don't fit are drawn one at a time as usual.
+    bool single = m_light_buffer && m_light_buffer_ok;
+    size_t i = single ? this->PackLights() : 0;
+
+    // Only casters that moved since last frame need new shadows.
+    ++m_shadow_frame;
+    m_Visibility.ConsumeMoved(mp_movedObjects);
+
+    // The shadow map is built from the packed lights, in its own
+    // frame-buffers, so come back to ours afterwards.
+    if(single && m_shadows && m_shadows_ok)
+    {
+        bool profile = m_profiling && m_profiling_ok;
+
+        if(profile) m_GPUTimer.Begin(IC_SHADOW_TIMER);
+        this->ShadowMapRender();
+        if(profile) m_GPUTimer.End(IC_SHADOW_TIMER);
+
+        m_Graph.Enable();
+    }
+
+    gfx::CGLState::BindTexture(source);
+
+    // Additive blending for lighting.
+    gfx::CGLState::BlendFunc(GL_ONE, GL_ONE);
+
+    if(single) this->LightBufferRender();
     
+    // Render all lights onto the frame-buffer.
+    for( ; i < mp_sceneLights.size(); ++i)
+    {
+        this->LightRender(mp_sceneLights[i]);
+    }
+
+    gfx::CGLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    IC_GL_CHECK();
+}
+
+void CScene::PresentRender(uint32_t source)
+{
+    IC_PROFILE_FUNCTION();
+
+    Globals::g_FullscreenVBO.Bind();
+
+    // Every effect reads the last one's output and completely replaces
+    // its own target, and so does the final copy to the screen, so
+    // there's nothing to blend with.
+    gfx::CGLState::EnableBlending(false);
+
+    bool profile = m_profiling && m_profiling_ok;
+
+    if(m_postfx && !mp_sceneEffects.empty())
+    {
+        // Per-pixel effects at the end of the chain are held back and
+        // applied while drawing to the screen below.
+        if(profile) m_GPUTimer.Begin(IC_POSTFX_TIMER);
+        source = m_EffectChain.Render(mp_sceneEffects, source, m_TargetPool,
+                                      m_WindowDim.x, m_WindowDim.y);
+        if(profile) m_GPUTimer.End(IC_POSTFX_TIMER);
+
+        // The effects rendered to their own targets.
+        m_Graph.Enable();
+    }
+
     // Draw off-screen texture to screen.
-    Globals::g_DefaultEffect.Enable();
-    Globals::g_DefaultEffect.SetMatrix("mv", math::IDENTITY);
-    
-    glBindTexture(GL_TEXTURE_2D, final_texture);
-    Globals::g_FullscreenVBO.Draw();
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if(profile) m_GPUTimer.Begin(IC_PRESENT_TIMER);
+    m_EffectChain.Present(source);
+    if(profile) m_GPUTimer.End(IC_PRESENT_TIMER);
 
-    Globals::g_DefaultEffect.Disable();
     Globals::g_FullscreenVBO.Unbind();
+
+    m_EffectChain.Finish();
+
+    IC_GL_CHECK();
 }
 
 void CScene::Clear()
 {
+    m_Static.Clear();
     m_GeometryVBO.Clear();
+    m_Visibility.Clear();
+    this->ForgetShadows(NULL, NULL);
+    m_Order.clear();
     mp_sceneObjects.clear();
     mp_sceneLights.clear();
     mp_sceneEffects.clear();
@@ -252,6 +579,19 @@ bool CScene::AddMaterialOverlay(gfx::CEffect* pEffect)
     return true;
 }
 
+void CScene::UpdateFrameData()
+{
+    gfx::frame_data_t Frame;
+
+    memcpy(Frame.proj, m_WindowProj.GetMatrixPointer(), sizeof(Frame.proj));
+    Frame.camera[0] = m_Camera.x;
+    Frame.camera[1] = m_Camera.y;
+    Frame.time      = (float)util::CTimer::GetTimeElapsed();
+    Frame.padding   = 0.f;
+
+    m_FrameUBO.Update(&Frame, sizeof(Frame));
+}
+
 void CScene::StandardRender(obj::CEntity* pEntity,
                             const math::matrix4x4_t& ModelView)
 {
@@ -263,6 +603,21 @@ void CScene::StandardRender(obj::CEntity* pEntity,
     // Nothing to render if there's no texture/shader.
     if(pMaterial == NULL) return;
 
+    bool wire = (m_geo_type == GL_LINE_STRIP ||
+                 m_geo_type == GL_LINE_LOOP  ||
+                 m_geo_type == GL_LINES);
+
+    // Only the batch shader knows which frame of a sprite sheet to
+    // show, so draw those as a batch of one if batching is off.
+    float frame[4];
+    asset::CTexture* pTexture = pEntity->GetTexture();
+    if(!wire && pTexture != NULL && pEntity->LoadSpriteFrame(frame) &&
+       m_Batch.Add(pEntity, wire, ModelView[2][3]))
+    {
+        m_Batch.Flush(m_GeometryVBO, m_geo_type);
+        return;
+    }
+
     // Bind texture and shader, returns false if no shader,
     // so bind the default.
     if(!pMaterial->pShader)
@@ -273,16 +628,19 @@ void CScene::StandardRender(obj::CEntity* pEntity,
     else
     {
         pMaterial->pShader->Bind();
-        int mvloc = pMaterial->pShader->GetUniformLocation("mv");
-        int pjloc = pMaterial->pShader->GetUniformLocation("proj");
+        // Locations are cached at link time. Shaders reading the
+        // projection from the "FrameData" block won't have "proj".
+        int mvloc = pMaterial->pShader->GetMVLocation();
+        int pjloc = pMaterial->pShader->GetProjLocation();
 
-        if(mvloc == -1 || pjloc == -1) return;
+        if(mvloc == -1) return;
 
         glUniformMatrix4fv(mvloc, 1, GL_TRUE,
             ModelView.GetMatrixPointer());
 
-        glUniformMatrix4fv(pjloc, 1, GL_TRUE,
-            m_WindowProj.GetMatrixPointer());
+        if(pjloc != -1)
+            glUniformMatrix4fv(pjloc, 1, GL_TRUE,
+                m_WindowProj.GetMatrixPointer());
     }
 
     if(m_geo_type == GL_LINE_STRIP ||
@@ -293,16 +651,19 @@ void CScene::StandardRender(obj::CEntity* pEntity,
     else                                pEntity->GetTexture()->Bind();
 
     // Do rendering.
-    glDrawElements(m_geo_type, pSurface->icount, GL_UNSIGNED_SHORT,
-                   (void*)(sizeof(uint16_t)*(pSurface->start)));
-
-    // Unbind shader / texture.
-    glBindTexture(GL_TEXTURE_2D, 0);
-    Globals::g_DefaultEffect.Disable();
+    gfx::Counters::triangles += pSurface->icount / 3;
+    glDrawElementsBaseVertex(m_geo_type, pSurface->icount,
+        m_GeometryVBO.GetIndexType(),
+        (void*)(size_t)(m_GeometryVBO.GetIndexSize() * pSurface->start),
+        pSurface->base);
+
+    // The shader and texture are left bound, the next surface most
+    // likely uses them too (see CGLState).
 }
 
 void CScene::StandardRender(gfx::surface_t* pSurface,
-                            const math::matrix4x4_t& ModelView)
+                            const math::matrix4x4_t& ModelView,
+                            const uint32_t texture)
 {
     gfx::material_t* pMaterial = pSurface->pMaterial;
 
@@ -318,16 +679,19 @@ void CScene::StandardRender(gfx::surface_t* pSurface,
     }
     else
     {
-        int mvloc = pMaterial->pShader->GetUniformLocation("mv");
-        int pjloc = pMaterial->pShader->GetUniformLocation("proj");
+        // Locations are cached at link time. Shaders reading the
+        // projection from the "FrameData" block won't have "proj".
+        int mvloc = pMaterial->pShader->GetMVLocation();
+        int pjloc = pMaterial->pShader->GetProjLocation();
 
-        if(mvloc == -1 || pjloc == -1) return;
+        if(mvloc == -1) return;
 
         glUniformMatrix4fv(mvloc, 1, GL_TRUE,
             ModelView.GetMatrixPointer());
 
-        glUniformMatrix4fv(pjloc, 1, GL_TRUE,
-            m_WindowProj.GetMatrixPointer());
+        if(pjloc != -1)
+            glUniformMatrix4fv(pjloc, 1, GL_TRUE,
+                m_WindowProj.GetMatrixPointer());
     }
 
     if(m_geo_type == GL_LINE_STRIP ||
@@ -335,17 +699,20 @@ void CScene::StandardRender(gfx::surface_t* pSurface,
        m_geo_type == GL_LINES      ||
        pMaterial->pTexture == NULL)   Globals::g_WhiteTexture->Bind();
 
+    else if(texture != 0)             gfx::CGLState::BindTexture(texture);
     else                              pMaterial->pTexture->Bind();
 
     // Do rendering.
-    glDrawElements(
+    gfx::Counters::triangles += pSurface->icount / 3;
+    glDrawElementsBaseVertex(
         m_geo_type,                                     // Tris, lines, ...
         pSurface->icount,                               // Index count
-        GL_UNSIGNED_SHORT,                              // uint16_t indices
-        (void*)(sizeof(uint16_t)*(pSurface->start)));   // Buffer offset
+        m_GeometryVBO.GetIndexType(),                   // 16/32-bit indices
+        (void*)(size_t)(m_GeometryVBO.GetIndexSize() *  // Buffer offset
+                        pSurface->start),
+        pSurface->base);                                // Base vertex
 
-    // Unbind shader / texture.
-    if(!pMaterial->Unbind()) Globals::g_DefaultEffect.Disable();
+    // Left bound, as above.
 }
 
 void CScene::LightRender(gfx::CLight* pLight)
@@ -353,6 +720,25 @@ void CScene::LightRender(gfx::CLight* pLight)
     // Nothing to render if there's no texture/shader.
     if(pLight == NULL) return;
 
+    // Only shade the pixels the light can actually reach.
+    math::rect_t Box;
+    bool scissor = false;
+    if(!this->ClipLight(pLight, Box, scissor))
+    {
+        ++m_Stats.culled_lights;
+        return;
+    }
+
+    if(scissor)
+    {
+        // Light positions are top-down, the scissor box is bottom-up.
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(Box.x, m_WindowDim.y - Box.y - Box.h, Box.w, Box.h);
+    }
+
+    bool shadowed = m_shadows && pLight->GetType() == IC_POINT_LIGHT &&
+                    this->ShadowRender(pLight);
+
     // Bind light shader.
     pLight->Enable();
     if(pLight->GetType() != IC_AMBIENT_LIGHT)
@@ -365,22 +751,163 @@ void CScene::LightRender(gfx::CLight* pLight)
     if(pLight->GetType() != IC_AMBIENT_LIGHT)
         pLight->SetPosition(pLight->GetPosition() - m_Camera);
     pLight->Disable();
+
+    if(shadowed)
+    {
+        gfx::CGLState::EnableDepthTest(false);
+        gfx::CGLState::DepthMask(true);
+    }
+
+    if(scissor) glDisable(GL_SCISSOR_TEST);
 }
 
-uint32_t CScene::PostProcessingRender(gfx::CEffect* pEffect,
-    gfx::CFrameBuffer& Target, uint32_t source)
+size_t CScene::PackLights()
 {
-    if(pEffect == NULL) return 0;
+    m_LightBuffer.Clear(m_WindowDim.x, m_WindowDim.y);
+    bool shadows = m_shadows && m_shadows_ok;
+
+    // Casters can shadow a packed light anywhere in its reach, even
+    // off-screen, so keep the world-space box around all of them. It
+    // never needs to grow past the occlusion map.
+    float pad = (float)m_ShadowMap.GetPadding();
+    float sx0 = -m_Camera.x - pad, sx1 = -m_Camera.x + m_WindowDim.x + pad;
+    float sy0 = -m_Camera.y - pad, sy1 = -m_Camera.y + m_WindowDim.y + pad;
+    float x0 = sx1, y0 = sy1, x1 = sx0, y1 = sy0;
+
+    size_t i = 0;
+    for( ; i < mp_sceneLights.size(); ++i)
+    {
+        gfx::CLight* pLight = mp_sceneLights[i];
+        if(pLight == NULL) continue;
 
-    pEffect->Enable();
-    Target.Enable();
-    glBindTexture(GL_TEXTURE_2D, source);
+        // Lights that can't reach the screen don't need a slot.
+        math::rect_t Box;
+        bool scissor = false;
+        if(!this->ClipLight(pLight, Box, scissor))
+        {
+            ++m_Stats.culled_lights;
+            continue;
+        }
+
+        if(!m_LightBuffer.Add(pLight, shadows)) break;
+
+        math::rect_t Bounds;
+        if(!pLight->GetInfluence(Bounds))
+        {
+            Bounds = math::rect_t(sx0, sy0, (int)(sx1 - sx0) + 1,
+                                  (int)(sy1 - sy0) + 1);
+        }
+
+        x0 = math::min<float>(x0, Bounds.x);
+        y0 = math::min<float>(y0, Bounds.y);
+        x1 = math::max<float>(x1, Bounds.x + Bounds.w);
+        y1 = math::max<float>(y1, Bounds.y + Bounds.h);
+    }
+
+    x0 = math::max<float>(x0, sx0); x1 = math::min<float>(x1, sx1);
+    y0 = math::max<float>(y0, sy0); y1 = math::min<float>(y1, sy1);
+
+    m_ShadowArea = (x0 < x1 && y0 < y1) ?
+        math::rect_t(x0, y0, (int)ceil(x1 - x0), (int)ceil(y1 - y0)) :
+        math::rect_t();
+
+    if(m_LightBuffer.GetCount() > 0) m_LightBuffer.Update();
+    return i;
+}
+
+void CScene::LightBufferRender()
+{
+    if(m_LightBuffer.GetCount() == 0) return;
+
+    if(m_shadows && m_shadows_ok) m_ShadowMap.Bind(1);
+
+    m_LightBuffer.Enable();
     Globals::g_FullscreenVBO.Draw();
-    glBindTexture(GL_TEXTURE_2D, 0);
-    Target.Disable();
-    pEffect->Disable();
+    m_LightBuffer.Disable();
+}
+
+void CScene::ShadowMapRender()
+{
+    if(m_LightBuffer.GetCount() == 0) return;
+
+    // Culling only keeps what's on-screen, but casters just out of
+    // view still block lights that reach them.
+    std::vector<obj::CEntity*>& Objects = mp_shadowCasters;
+    Objects.clear();
+    if(m_ShadowArea.w > 0 && m_ShadowArea.h > 0)
+        m_Visibility.Query(m_ShadowArea, Objects);
+
+    math::matrix4x4_t MVMatrix = math::IDENTITY;
+
+    // Draw every caster into the occlusion map.
+    m_ShadowMap.BeginOccluders();
+    m_GeometryVBO.Bind();
+
+    for(size_t i = 0; i < Objects.size(); ++i)
+    {
+        obj::CEntity* pEntity = Objects[i];
+        if(!pEntity->IsRenderable() || !pEntity->CastsShadow()) continue;
+
+        pEntity->GetMesh().LoadPositionMatrix(MVMatrix);
+        m_ShadowMap.SetModelView(MVMatrix);
+
+        std::vector<gfx::surface_t*>& Surfaces = 
+            pEntity->GetMesh().GetSurfaces();
+
+        for(size_t j = 0; j < Surfaces.size(); ++j)
+        {
+            const gfx::surface_t* pSurface = Surfaces[j];
+            asset::CTexture* pTexture = (Surfaces.size() == 1) ?
+                pEntity->GetTexture() : pSurface->pMaterial ?
+                pSurface->pMaterial->pTexture : NULL;
+
+            if(pTexture == NULL) pTexture = Globals::g_WhiteTexture;
+            gfx::CGLState::BindTexture(pTexture->GetTextureID());
+            m_ShadowMap.SetRegion(pTexture->GetRegion());
+
+            gfx::Counters::triangles += pSurface->icount / 3;
+            glDrawElementsBaseVertex(GL_TRIANGLES, pSurface->icount,
+                m_GeometryVBO.GetIndexType(),
+                (void*)(size_t)(m_GeometryVBO.GetIndexSize() *
+                                pSurface->start),
+                pSurface->base);
+
+            ++m_Stats.draw_calls;
+        }
+    }
+
+    m_GeometryVBO.Unbind();
+    m_ShadowMap.EndOccluders();
+
+    // Then march out from every light, all in one pass.
+    Globals::g_FullscreenVBO.Bind();
+    m_ShadowMap.Build(m_LightBuffer.GetCount());
+}
+
+bool CScene::ClipLight(const gfx::CLight* pLight, math::rect_t& Box,
+                       bool& bounded) const
+{
+    math::rect_t Bounds;
+    bounded = pLight->GetInfluence(Bounds);
+    if(!bounded)
+    {
+        Box = math::rect_t(0.f, 0.f, m_WindowDim.x, m_WindowDim.y);
+        return true;
+    }
 
-    return Target.GetTexture();
+    Bounds.x += m_Camera.x;
+    Bounds.y += m_Camera.y;
+
+    // Clip to the screen, skipping the light if nothing is left.
+    int x0 = math::max<int>(0, (int)floor(Bounds.x));
+    int y0 = math::max<int>(0, (int)floor(Bounds.y));
+    int x1 = math::min<int>(m_WindowDim.x, (int)ceil(Bounds.x + Bounds.w));
+    int y1 = math::min<int>(m_WindowDim.y, (int)ceil(Bounds.y + Bounds.h));
+
+    if(x0 >= x1 || y0 >= y1) return false;
+
+    Box = math::rect_t((float)x0, (float)y0, x1 - x0, y1 - y0);
+    return true;
 }
 
 /**
@@ -402,182 +929,188 @@ uint16_t CScene::AddLight(gfx::CLight* pLight)
     return -1;
 }
 
-void CScene::ShadowRender()
+bool CScene::ShadowRender(const gfx::CLight* pLight)
 {
-    m_ShadowVBO.Draw();
-}
+    // Shadows need depth to sit in front of the light.
+    if(m_WindowProj[2][2] == 0.f) return false;
 
-void CScene::UpdateShadows(const math::vector2_t& LightPosition)
-{
-    // Retrieve buffers from the GPU.
-    vertex2_t* vertices = (vertex2_t*)m_GeometryVBO.GetTemporaryBuffer(
-        GL_ARRAY_BUFFER);
+    this->UpdateShadows(pLight);
 
-    uint16_t* indices = (uint16_t*)m_GeometryVBO.GetTemporaryBuffer(
-        GL_ELEMENT_ARRAY_BUFFER);
+    // Entries are sorted by light, so this light's casters are together.
+    ShadowMap_t::const_iterator i = m_Shadows.lower_bound(
+        ShadowKey_t(pLight, (const obj::CEntity*)NULL));
 
-    if(!vertices || !indices)
-    {
-        g_Log.Flush();
-        g_Log << "[ERROR] Failed to map vertex buffer.\n";
-        g_Log << "[ERROR] Most likely caused by an improper bind.\n";
-        g_Log << "[ERROR] OpenGL error: " << glGetString(glGetError());
-        g_Log << "\n";
-        g_Log.PrintLastLog();
+    if(i == m_Shadows.end() || i->first.first != pLight) return false;
+    if(!m_ShadowVBO.Bind()) return false;
 
-        handle_error(g_Log.GetLastLog());
-    }
+    // The shadows only go into the depth buffer, at the very front. The
+    // depth is cleared first, which is limited to the light's scissor
+    // box, so no shadows from the last light are left behind.
+    gfx::CGLState::EnableDepthTest(true);
+    gfx::CGLState::DepthMask(true);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    glDepthFunc(GL_ALWAYS);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
-    // Determine buffer sizes.
-    uint32_t vsize = m_GeometryVBO.GetVCount();
-    uint32_t isize = m_GeometryVBO.GetICount();
+    math::matrix4x4_t MVMatrix = math::IDENTITY;
+    MVMatrix[0][3] = m_Camera.x;
+    MVMatrix[1][3] = m_Camera.y;
+    MVMatrix[2][3] = this->GetDepthOffset(1.f);
 
-    if(!vsize || !isize)
+    Globals::g_DefaultEffect.Enable();
+    Globals::g_DefaultEffect.SetMatrix("mv", MVMatrix);
+
+    for( ; i != m_Shadows.end() && i->first.first == pLight; ++i)
     {
-        g_Log.Flush();
-        g_Log << "[ERROR] Empty buffers.\n";
-        g_Log << "[ERROR] OpenGL error code: " << glGetError() << "\n";
-        g_Log.PrintLastLog();
-        return;
+        const obj::CEntity* pCaster = i->first.second;
+        if(!pCaster->CastsShadow() || !pCaster->IsRenderable()) continue;
+
+        const gfx::geometry_range_t& Range = i->second.Range;
+        gfx::Counters::triangles += Range.icount / 3;
+        glDrawElementsBaseVertex(GL_TRIANGLES, Range.icount,
+            GL_UNSIGNED_SHORT, (void*)(sizeof(uint16_t) * Range.istart),
+            Range.vstart);
+
+        ++m_Stats.draw_calls;
     }
 
-    for(size_t j = 0; j < mp_sceneObjects.size(); ++j)
-    {
-        //if(!mp_sceneObjects[j]->CastsShadow()) continue;
+    m_ShadowVBO.Unbind();
+    Globals::g_DefaultEffect.Disable();
 
-        // Find the lowest and highest indices to get the clock-wise ordered
-        // vertices from the buffer.
-        std::vector<gfx::surface_t*>& Surfaces = 
-            mp_sceneObjects[j]->GetMesh().GetSurfaces();
+    // The light's quad is behind every shadow, so it only passes the
+    // depth test where there is none.
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthFunc(GL_LESS);
+    gfx::CGLState::DepthMask(false);
 
-        uint16_t mindex = indices[Surfaces.front()->start];
-        uint16_t maxdex = indices[Surfaces.front()->start];
+    Globals::g_FullscreenVBO.Bind();
+    return true;
+}
 
-        for(size_t k = Surfaces.front()->start;
-            k < Surfaces.back()->start + Surfaces.back()->icount;
-            ++k)
-        {
-            if(indices[k] < mindex) mindex = indices[k];
-            if(indices[k] > maxdex) maxdex = indices[k];
-        }
+void CScene::UpdateShadows(const gfx::CLight* pLight)
+{
+    if(pLight == NULL) return;
 
-        // We need to track which vertex is closest to the light source
-        // in order to make the shadows render in a clock-wise order.
-        uint16_t closest_vertex = 0;
+    // Casters may have moved while the light wasn't drawn, and all of
+    // them have to be redone if the light moved.
+    ShadowLightMap_t::iterator Record = m_ShadowLights.find(pLight);
+    bool all = Record == m_ShadowLights.end()                       ||
+               !(Record->second.Position == pLight->GetPosition())  ||
+               Record->second.frame + 1 != m_shadow_frame;
 
-        math::vector2_t Position = vertices[mindex].Position + m_Camera + 
-            mp_sceneObjects[j]->GetMesh().GetPosition();
+    shadow_light_t& Light = m_ShadowLights[pLight];
+    Light.Position  = pLight->GetPosition();
+    Light.frame     = m_shadow_frame;
 
-        float closest_distance  = math::distance(
-            Position.x, Position.y,
-            LightPosition.x, LightPosition.y, false);
+    const std::vector<obj::CEntity*>& Casters =
+        all ? mp_sceneObjects : mp_movedObjects;
 
-        // Ray-trace valid shadow outlines.
-        for(size_t i = mindex; i <= maxdex; ++i)
-        {
-            math::vector2_t Position = vertices[i].Position + m_Camera + 
-                mp_sceneObjects[j]->GetMesh().GetPosition();
+    for(size_t i = 0; i < Casters.size(); ++i)
+    {
+        if(Casters[i]->CastsShadow()) this->BuildShadow(pLight, Casters[i]);
+    }
+}
 
-            // Line from the vertex to the next one.
-            math::vector2_t CasterLine = 
-                vertices[(i == maxdex) ? 0 : i + 1].Position - 
-                vertices[i].Position;
+void CScene::BuildShadow(const gfx::CLight* pLight,
+                         obj::CEntity* pCaster)
+{
+    const math::vector2_t& LightPosition = pLight->GetPosition();
+    const gfx::CMeshInstance& Mesh = pCaster->GetMesh();
+    const std::vector<math::vector2_t>& Outline = Mesh.GetOutline();
+
+    // Shadow indices are 16-bit, so huge outlines can't cast.
+    if(Outline.size() < 2 || Outline.size() > 0x7FFF) return;
+
+    // Nothing moved, so the shadow from last time is still good.
+    ShadowKey_t Key(pLight, pCaster);
+    ShadowMap_t::iterator Cached = m_Shadows.find(Key);
+    if(Cached != m_Shadows.end()                 &&
+       Cached->second.Light  == LightPosition    &&
+       Cached->second.Caster == Mesh.GetPosition()) return;
+
+    // Two vertices and a quad for every edge of the outline. The
+    // outline never changes, so neither does the size of the range.
+    const size_t n = Outline.size();
+    if(Cached == m_Shadows.end())
+    {
+        shadow_t Shadow;
+        if(!m_ShadowVBO.Allocate(2 * n, 6 * n, Shadow.Range)) return;
 
-            // Vector from the light to the vertex.
-            math::vector2_t LightToVertex = Position - LightPosition;
+        Cached = m_Shadows.insert(std::make_pair(Key, Shadow)).first;
+    }
 
-            // Vector normal to the caster line, facing the right.
-            math::vector2_t Normal(CasterLine.y, -CasterLine.x);
+    Cached->second.Light  = LightPosition;
+    Cached->second.Caster = Mesh.GetPosition();
 
-            // A line will cast a shadow if N . L >= 0
-            //if(Normal * LightToVertex >= 0.f)
-            {
-                vertex2_t Final1, Final2;
-
-                Final1.Position = Position;
-                Final2.Position = (Position - LightPosition) * 4096.f;
-
-                m_shadowVertices.reserve(m_shadowVertices.size() + 2);
-                m_shadowVertices.push_back(Final1);
-                m_shadowVertices.push_back(Final2);
-
-                // Check distance from light.
-                float this_distance = 
-                    LightToVertex.x * LightToVertex.x + 
-                    LightToVertex.y * LightToVertex.y;
-
-                if(closest_vertex == -1)
-                {
-                    closest_vertex = m_shadowVertices.size() - 2;
-                    closest_distance = this_distance;
-                }
-                else if(this_distance < closest_distance)
-                {
-                    closest_distance = this_distance;
-                    closest_vertex = m_shadowVertices.size() - 2;
-                }
-            }
-        }
+    // Extrude every outline vertex away from the light, with x and y
+    // in separate arrays so the loop vectorizes, then interleave them
+    // into vertices.
+    m_shadowScratch.resize(4 * n);
+    float* nx = &m_shadowScratch[0];
+    float* ny = nx + n;
+    float* fx = ny + n;
+    float* fy = fx + n;
 
-        // Add indices for the shadow vertices to actually make the shadow.
-        m_shadowIndices.reserve(m_shadowIndices.size() + 
-            (3 * m_shadowVertices.size() + 6) / 2);
+    const float ox = Mesh.GetPosition().x, oy = Mesh.GetPosition().y;
+    const float lx = LightPosition.x,      ly = LightPosition.y;
 
-        // Add indices for the shadows in a clock-wise fashion.
-        uint8_t counter = 0;
-        size_t j = closest_vertex;
+    for(size_t i = 0; i < n; ++i)
+    {
+        nx[i] = Outline[i].x + ox;
+        ny[i] = Outline[i].y + oy;
+    }
 
-        for( ; j < m_shadowVertices.size() - 2; ++j)
-        {
-            if(j % 2 == 0)
-            {
-                m_shadowIndices.push_back(j);
-                m_shadowIndices.push_back(j + 1);
-                m_shadowIndices.push_back(j + 2);
-            }
-            else
-            {
-                m_shadowIndices.push_back(j + 1);
-                m_shadowIndices.push_back(j + 2);
-                m_shadowIndices.push_back(j + 3);
-            }
-        }
+    for(size_t i = 0; i < n; ++i)
+    {
+        fx[i] = nx[i] + (nx[i] - lx) * 4096.f;
+        fy[i] = ny[i] + (ny[i] - ly) * 4096.f;
+    }
 
-        m_shadowIndices.push_back(j);
-        m_shadowIndices.push_back(j + 1);
-        m_shadowIndices.push_back(0);
-        m_shadowIndices.push_back(j + 1);
-        m_shadowIndices.push_back(0);
-        m_shadowIndices.push_back(1);
+    m_shadowVertices.resize(2 * n);
+    m_shadowIndices.resize(6 * n);
 
-        for(size_t i = 0; i + 2 < closest_vertex; ++i)
-        {
-            if(i % 2 == 0)
-            {
-                m_shadowIndices.push_back(i);
-                m_shadowIndices.push_back(i + 1);
-                m_shadowIndices.push_back(i + 2);
-            }
-            else
-            {
-                m_shadowIndices.push_back(i + 1);
-                m_shadowIndices.push_back(i);
-                m_shadowIndices.push_back(i + 2);
-            }
-        }
+    for(size_t i = 0; i < n; ++i)
+    {
+        m_shadowVertices[2 * i    ].Position = math::vector2_t(nx[i], ny[i]);
+        m_shadowVertices[2 * i + 1].Position = math::vector2_t(fx[i], fy[i]);
+    }
+
+    // Quad from each edge's near vertices to its far ones.
+    for(size_t i = 0; i < n; ++i)
+    {
+        uint16_t a = 2 * i, b = 2 * ((i + 1) % n);
+        uint16_t* pIndex = &m_shadowIndices[6 * i];
+
+        pIndex[0] = a;      pIndex[1] = a + 1;  pIndex[2] = b;
+        pIndex[3] = a + 1;  pIndex[4] = b + 1;  pIndex[5] = b;
     }
 
-    // Add shadow data to the VBO.
-    m_ShadowVBO.AddData(&m_shadowVertices[0], m_shadowVertices.size(),
-                        &m_shadowIndices[0],  m_shadowIndices.size());
+    m_ShadowVBO.Upload(Cached->second.Range,
+                       &m_shadowVertices[0], &m_shadowIndices[0]);
+    ++m_Stats.shadow_rebuilds;
+}
 
-    m_shadowIndices.clear();
-    m_shadowVertices.clear();
+void CScene::ForgetShadows(const gfx::CLight* pLight,
+                           const obj::CEntity* pCaster)
+{
+    ShadowMap_t::iterator i = m_Shadows.begin();
+    while(i != m_Shadows.end())
+    {
+        if((pLight  == NULL || i->first.first  == pLight) &&
+           (pCaster == NULL || i->first.second == pCaster))
+        {
+            m_ShadowVBO.Free(i->second.Range);
+            m_Shadows.erase(i++);
+        }
+        else ++i;
+    }
 
-    // Done with buffers.
-    /// @todo Make this a part of the VBO wrapper.
-    glUnmapBuffer(GL_ARRAY_BUFFER);
-    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+    // Without its record, a light checks every caster next time.
+    if(pCaster == NULL)
+    {
+        if(pLight == NULL)  m_ShadowLights.clear();
+        else                m_ShadowLights.erase(pLight);
+    }
 }
 
 bool CScene::RemoveLight(const uint16_t id)
@@ -585,6 +1118,7 @@ bool CScene::RemoveLight(const uint16_t id)
     if(id > mp_sceneLights.size())
         return false;
 
+    this->ForgetShadows(mp_sceneLights[id], NULL);
     mp_sceneLights.erase(mp_sceneLights.begin() + id);
     return true;
 }
@@ -595,6 +1129,7 @@ bool CScene::RemoveLight(const gfx::CLight* pLight)
     {
         if(mp_sceneLights[i] == pLight)
         {
+            this->ForgetShadows(pLight, NULL);
             mp_sceneLights.erase(mp_sceneLights.begin() + i);
             return true;
         }
@@ -605,9 +1140,44 @@ bool CScene::RemoveLight(const gfx::CLight* pLight)
 
 bool gfx::CScene::InsertMesh(const uint16_t position, obj::CEntity* pEntity)
 {
+    if(pEntity == NULL)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Cannot insert a NULL entity into a scene.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
     if(mp_sceneObjects.size() < position) return false;
+    if(mp_sceneObjects.size() == position) return this->AddMesh(pEntity);
+
+    // Go halfway between the entity at that position and whatever is
+    // drawn right before it, making room first if there's none.
+    obj::CEntity* pNext = mp_sceneObjects[position];
+    OrderMap_t::iterator Next = m_Order.find(m_Visibility.GetOrder(pNext));
+    uint32_t lo = (Next == m_Order.begin()) ? 0 : (--Next)->first;
+    uint32_t hi = m_Visibility.GetOrder(pNext);
 
-    mp_sceneObjects.insert(mp_sceneObjects.begin() + position, pEntity);
+    if(hi - lo < 2)
+    {
+        this->Renumber();
+        Next = m_Order.find(m_Visibility.GetOrder(pNext));
+        lo = (Next == m_Order.begin()) ? 0 : (--Next)->first;
+        hi = m_Visibility.GetOrder(pNext);
+    }
+
+    uint32_t order = lo + (hi - lo) / 2;
+    if(!m_Visibility.Insert(pEntity, order))
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Entity is already in a scene, not inserting it.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    m_Order.insert(std::make_pair(order, pEntity));
+    mp_sceneObjects.push_back(pEntity);
+    if(m_bake_all || pEntity->IsStatic()) m_Static.Add(pEntity);
     return true;
 }
 
@@ -633,11 +1203,46 @@ obj::CEntity* gfx::CScene::InsertMesh(const uint16_t position,
 
     pFinal->Move(Position);
 
-    mp_sceneObjects.insert(mp_sceneObjects.begin() + position, pFinal);
+    this->InsertMesh(position, pFinal);
     return pFinal;
 }
 
 
+bool CScene::RemoveMesh(const obj::CEntity* pEntity)
+{
+    int pos = this->GetQueuePosition(pEntity);
+    if(pos == -1) return false;
+
+    obj::CEntity* pRemoved = mp_sceneObjects[pos];
+    m_Order.erase(m_Visibility.GetOrder(pRemoved));
+    m_Visibility.Remove(pRemoved);
+    m_Static.Remove(pRemoved);
+    this->ForgetShadows(NULL, pEntity);
+
+    // Draw order lives in the grid, so the queue needn't keep any.
+    mp_sceneObjects[pos] = mp_sceneObjects.back();
+    mp_sceneObjects.pop_back();
+    return true;
+}
+
+void CScene::Renumber()
+{
+    // Shrink the step if the scene is too big for the usual one.
+    const uint32_t step = (uint32_t)math::min<uint64_t>(ORDER_STEP,
+        0xFFFFFFFFull / (m_Order.size() + 1));
+
+    OrderMap_t Renumbered;
+    uint32_t order = 0;
+    for(OrderMap_t::iterator i = m_Order.begin(); i != m_Order.end(); ++i)
+    {
+        order += step;
+        m_Visibility.SetOrder(i->second, order);
+        Renumbered.insert(Renumbered.end(), std::make_pair(order, i->second));
+    }
+
+    m_Order.swap(Renumbered);
+}
+
 int CScene::GetQueuePosition(const obj::CEntity* pEntity) const
 {
     for(size_t i = 0; i < mp_sceneObjects.size(); ++i)
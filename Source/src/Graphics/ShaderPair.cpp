@@ -1,15 +1,21 @@
 #include "IronClad/Graphics/ShaderPair.hpp"
+#include "IronClad/Graphics/GLState.hpp"
+#include "IronClad/Graphics/UniformBuffer.hpp"
 
 using namespace ic;
 using gfx::CShaderPair;
 
 CShaderPair::CShaderPair() : m_program(0), mp_VShader(NULL),
-    mp_FShader(NULL), m_error_str("No error"), m_error(GL_NO_ERROR) {}
+    mp_FShader(NULL), m_error_str("No error"), m_error(GL_NO_ERROR),
+    m_mv_loc(-1), m_proj_loc(-1), m_frame_data(false) {}
 
 CShaderPair::~CShaderPair()
 {
     if(glDeleteProgram != NULL && !m_program)
+    {
+        gfx::CGLState::ForgetProgram(m_program);
         glDeleteProgram(m_program);
+    }
 }
 
 short CShaderPair::GetAttributeLocation(const char* attr) const
@@ -19,9 +25,88 @@ short CShaderPair::GetAttributeLocation(const char* attr) const
 
 short CShaderPair::GetUniformLocation(const char* uni) const
 {
+    const gfx::uniform_t* pUniform = this->FindUniform(uni);
+    if(pUniform != NULL) return pUniform->location;
+
     return glGetUniformLocation(m_program, uni);
 }
 
+const gfx::uniform_t* CShaderPair::FindUniform(const char* uni) const
+{
+    gfx::uniform_t Finder;
+    Finder.hash = CShaderPair::HashName(uni);
+
+    std::vector<gfx::uniform_t>::const_iterator i = std::lower_bound(
+        m_Uniforms.begin(), m_Uniforms.end(), Finder);
+
+    // Different names can share a hash.
+    for( ; i != m_Uniforms.end() && i->hash == Finder.hash; ++i)
+    {
+        if(i->name == uni) return &(*i);
+    }
+
+    return NULL;
+}
+
+void CShaderPair::Reflect()
+{
+    m_Uniforms.clear();
+
+    int count = 0, max_length = 0;
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(m_program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+    char* name = new char[max_length + 1];
+    m_Uniforms.reserve(count);
+
+    for(int i = 0; i < count; ++i)
+    {
+        int     length  = 0;
+        GLenum  type    = 0;
+        gfx::uniform_t Uniform;
+
+        glGetActiveUniform(m_program, i, max_length + 1, &length,
+                           &Uniform.size, &type, name);
+
+        // Uniforms inside blocks have no location.
+        Uniform.type        = type;
+        Uniform.location    = glGetUniformLocation(m_program, name);
+        if(Uniform.location == -1) continue;
+
+        Uniform.name = std::string(name, length);
+        Uniform.hash = CShaderPair::HashName(Uniform.name.c_str());
+        m_Uniforms.push_back(Uniform);
+
+        // Arrays are reported as "name[0]", so make "name" work too.
+        std::string array_name(name, length);
+        size_t bracket = array_name.find("[0]");
+        if(bracket != std::string::npos)
+        {
+            array_name.erase(bracket);
+            Uniform.name = array_name;
+            Uniform.hash = CShaderPair::HashName(array_name.c_str());
+            m_Uniforms.push_back(Uniform);
+        }
+    }
+
+    delete[] name;
+
+    std::sort(m_Uniforms.begin(), m_Uniforms.end());
+
+    m_mv_loc    = this->GetUniformLocation("mv");
+    m_proj_loc  = this->GetUniformLocation("proj");
+
+    // Attach the shared blocks, if the program uses them.
+    uint32_t block = glGetUniformBlockIndex(m_program, "FrameData");
+    m_frame_data = (block != GL_INVALID_INDEX);
+    if(m_frame_data)
+        glUniformBlockBinding(m_program, block, gfx::IC_FRAME_DATA_BINDING);
+
+    block = glGetUniformBlockIndex(m_program, "LightData");
+    if(block != GL_INVALID_INDEX)
+        glUniformBlockBinding(m_program, block, gfx::IC_LIGHT_DATA_BINDING);
+}
+
 bool CShaderPair::LoadFromFile(const char* pvs_filename,
     const char* pfs_filename)
 {
@@ -31,6 +116,44 @@ bool CShaderPair::LoadFromFile(const char* pvs_filename,
 
     if(!mp_VShader || !mp_FShader) return false;
 
+    return this->Link();
+}
+
+bool CShaderPair::LoadFromFile(const std::string& vs_filename,
+    const std::string& fs_filename)
+{
+    return this->LoadFromFile(vs_filename.c_str(), fs_filename.c_str());
+}
+
+bool CShaderPair::LoadFromSource(const char** pvs_src, const char** pfs_src)
+{
+    if(pvs_src == NULL || pfs_src == NULL) return false;
+
+    std::string vs, fs;
+    for(size_t i = 0; pvs_src[i] != NULL; ++i)
+        vs += std::string(pvs_src[i]) + '\n';
+    for(size_t i = 0; pfs_src[i] != NULL; ++i)
+        fs += std::string(pfs_src[i]) + '\n';
+
+    // Built-in shaders have no filename, so they are owned by us.
+    mp_VShader = asset::CAssetManager::Create<asset::CShader>(this);
+    mp_FShader = asset::CAssetManager::Create<asset::CShader>(this);
+
+    if(!mp_VShader->LoadFromStr(vs.c_str(), GL_VERTEX_SHADER) ||
+       !mp_FShader->LoadFromStr(fs.c_str(), GL_FRAGMENT_SHADER))
+    {
+        util::g_Log.Flush();
+        util::g_Log << "[ERROR] Failed to compile shader source.\n";
+        util::g_Log << "[ERROR] OpenGL error: " << this->GetError() << "\n";
+        util::g_Log.PrintLastLog();
+        return false;
+    }
+
+    return this->Link();
+}
+
+bool CShaderPair::Link()
+{
     util::g_Log.Flush();
     util::g_Log << "[INFO] Linking shader objects.\n";
 
@@ -58,6 +181,7 @@ bool CShaderPair::LoadFromFile(const char* pvs_filename,
         // Get log.
         buf = new char[length];
         glGetProgramInfoLog(m_program, length, &length, buf);
+        gfx::CGLState::ForgetProgram(m_program);
         glDeleteProgram(m_program);
         m_error_str = buf;
         delete[] buf;
@@ -71,23 +195,18 @@ bool CShaderPair::LoadFromFile(const char* pvs_filename,
         return false;
     }
 
+    this->Reflect();
     return true;
 }
 
-bool CShaderPair::LoadFromFile(const std::string& vs_filename,
-    const std::string& fs_filename)
-{
-    return this->LoadFromFile(vs_filename.c_str(), fs_filename.c_str());
-}
-
 void CShaderPair::Bind()
 {
-    glUseProgram(m_program);
+    gfx::CGLState::UseProgram(m_program);
 }
 
 void CShaderPair::Unbind()
 {
-    glUseProgram(0);
+    gfx::CGLState::UseProgram(0);
 }
 
 const std::string& CShaderPair::GetError() const
@@ -105,6 +224,10 @@ const std::string& CShaderPair::GetError() const
 
 CShaderPair& CShaderPair::operator=(const CShaderPair& Copy)
 {
-    m_program = Copy.GetProgram();
+    m_program       = Copy.GetProgram();
+    m_Uniforms      = Copy.m_Uniforms;
+    m_mv_loc        = Copy.m_mv_loc;
+    m_proj_loc      = Copy.m_proj_loc;
+    m_frame_data    = Copy.m_frame_data;
     return (*this);
 }
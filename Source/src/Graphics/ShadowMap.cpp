@@ -0,0 +1,263 @@
+#include "IronClad/Graphics/ShadowMap.hpp"
+#include "IronClad/Graphics/LightBuffer.hpp"
+#include "IronClad/Graphics/Globals.hpp"
+
+using namespace ic;
+using gfx::CShadowMap;
+using util::g_Log;
+using gfx::Globals;
+
+namespace
+{
+    // Casters are drawn as-is, only their alpha matters. The map
+    // reaches past every edge of the screen by the same amount, so
+    // shrinking the screen's clip space about its center fits it in.
+    const char* s_OccluderVS[] = {
+        "#version 330 core",
+        "layout(location = 0) in vec2 in_vert;",
+        "layout(location = 1) in vec2 in_texc;",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "uniform mat4 mv;",
+        "uniform vec4 region;",
+        "uniform vec2 scale;",
+        "smooth out vec2 fs_texc;",
+        "void main()",
+        "{",
+        "    vec4 pos    = mv * vec4(in_vert, 0.0, 1.0);",
+        "    fs_texc     = region.xy + in_texc * region.zw;",
+        "    gl_Position = proj * vec4(pos.xy + camera, 0.0, 1.0);",
+        "    gl_Position.xy *= scale;",
+        "}",
+        NULL
+    };
+
+    const char* s_OccluderFS[] = {
+        "#version 330 core",
+        "uniform sampler2D tex;",
+        "smooth in vec2 fs_texc;",
+        "out vec4 out_color;",
+        "void main()",
+        "{",
+        "    if(texture(tex, fs_texc).a <= 0.5) discard;",
+        "    out_color = vec4(1.0);",
+        "}",
+        NULL
+    };
+
+    // One row per light, one column per angle. Rays are clipped to the
+    // occlusion map first, so lights off of it still find casters.
+    const char* s_PolarVS[] = {
+        "#version 330 core",
+        "layout(location = 0) in vec2 in_vert;",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "void main()",
+        "{",
+        "    gl_Position = proj * vec4(in_vert, 0.0, 1.0);",
+        "}",
+        NULL
+    };
+
+    const char* s_PolarFS[] = {
+        "#version 330 core",
+        "struct light_t",
+        "{",
+        "    vec4 pos;",
+        "    vec4 color;",
+        "    vec4 att;",
+        "    vec4 cone;",
+        "};",
+        "layout(std140, row_major) uniform FrameData",
+        "{",
+        "    mat4  proj;",
+        "    vec2  camera;",
+        "    float time;",
+        "};",
+        "layout(std140) uniform LightData",
+        "{",
+        "    vec4    info;",
+        "    light_t lights[64];",
+        "};",
+        "uniform sampler2D occluders;",
+        "uniform float resolution;",
+        "uniform vec2  padding;",
+        "out vec4 out_color;",
+        "const int STEPS = 256;",
+        "void main()",
+        "{",
+        "    light_t L     = lights[int(gl_FragCoord.y)];",
+        "    float   angle = gl_FragCoord.x / resolution * 6.2831853;",
+        "    vec2    dir   = vec2(cos(angle), sin(angle));",
+        "    vec2    from  = L.pos.xy + camera;",
+        "    float   reach = L.att.w >= 0.0 ? L.att.w : length(info.zy);",
+        "    vec2    lo    = -padding;",
+        "    vec2    size  = info.zy + 2.0 * padding;",
+        "    vec2    ray   = dir * reach;",
+        "    ray = mix(ray, vec2(1e-6), lessThan(abs(ray), vec2(1e-6)));",
+        "    vec2    ta    = (lo - from) / ray;",
+        "    vec2    tb    = (lo + size - from) / ray;",
+        "    vec2    tmin  = min(ta, tb), tmax = max(ta, tb);",
+        "    float   t0    = max(max(tmin.x, tmin.y), 0.0);",
+        "    float   t1    = min(min(tmax.x, tmax.y), 1.0);",
+        "    float   hit   = 1.0;",
+        "    for(int i = 0; i < STEPS && t0 < t1; ++i)",
+        "    {",
+        "        float t = mix(t0, t1, (float(i) + 0.5) / float(STEPS));",
+        "        vec2  p = from + dir * t * reach;",
+        "        vec2 uv = vec2((p.x - lo.x) / size.x,",
+        "                       1.0 - (p.y - lo.y) / size.y);",
+        "        if(texture(occluders, uv).a > 0.0)",
+        "        {",
+        "            hit = t;",
+        "            break;",
+        "        }",
+        "    }",
+        "    out_color = vec4(hit);",
+        "}",
+        NULL
+    };
+}
+
+CShadowMap::CShadowMap() : m_fbo(0), m_texture(0), m_resolution(0),
+    m_padding(0), m_mvloc(-1), m_regionloc(-1) {}
+
+CShadowMap::~CShadowMap()
+{
+    if(glDeleteFramebuffers != NULL && m_fbo != 0)
+    {
+        gfx::CGLState::ForgetFramebuffer(m_fbo);
+        gfx::CGLState::ForgetTexture(m_texture);
+        glDeleteFramebuffers(1, &m_fbo);
+        glDeleteTextures(1, &m_texture);
+    }
+}
+
+bool CShadowMap::Init(const uint16_t w, const uint16_t h,
+                      const uint16_t resolution, const uint16_t padding)
+{
+    if(!m_OccluderShader.LoadFromSource(s_OccluderVS, s_OccluderFS) ||
+       !m_PolarShader.LoadFromSource(s_PolarVS, s_PolarFS)          ||
+       !m_Occluders.Init(w + 2 * padding, h + 2 * padding)) return false;
+
+    m_resolution = resolution;
+    m_padding    = padding;
+    m_mvloc      = m_OccluderShader.GetMVLocation();
+    m_regionloc  = m_OccluderShader.GetUniformLocation("region");
+
+    m_OccluderShader.Bind();
+    glUniform1i(m_OccluderShader.GetUniformLocation("tex"), 0);
+    glUniform2f(m_OccluderShader.GetUniformLocation("scale"),
+                (float)w / (w + 2 * padding),
+                (float)h / (h + 2 * padding));
+    m_OccluderShader.Unbind();
+
+    m_PolarShader.Bind();
+    glUniform1i(m_PolarShader.GetUniformLocation("occluders"), 0);
+    glUniform1f(m_PolarShader.GetUniformLocation("resolution"),
+                (float)m_resolution);
+    glUniform2f(m_PolarShader.GetUniformLocation("padding"),
+                (float)m_padding, (float)m_padding);
+    m_PolarShader.Unbind();
+
+    // Distances are fractions of the light's reach, so they need the
+    // precision of a float. Rows are never blended together.
+    glGenTextures(1, &m_texture);
+    gfx::CGLState::BindTexture(m_texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_resolution,
+                 gfx::CLightBuffer::MAX_LIGHTS, 0, GL_RED, GL_FLOAT, NULL);
+
+    glGenFramebuffers(1, &m_fbo);
+    gfx::CGLState::BindFramebuffer(m_fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                           GL_TEXTURE_2D, m_texture, 0);
+
+    uint32_t status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    gfx::CGLState::BindFramebuffer(0);
+    gfx::CGLState::BindTexture(0);
+
+    if(status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Shadow map frame-buffer is incomplete.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] GFX: Created shadow map (" << m_resolution << " x ";
+    g_Log << (int)gfx::CLightBuffer::MAX_LIGHTS << ").\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    return true;
+}
+
+void CShadowMap::BeginOccluders()
+{
+    m_Occluders.Enable();
+
+    // Empty space must have no alpha at all.
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    m_OccluderShader.Bind();
+}
+
+void CShadowMap::SetModelView(const math::matrix4x4_t& MV)
+{
+    glUniformMatrix4fv(m_mvloc, 1, GL_TRUE, MV.GetMatrixPointer());
+}
+
+void CShadowMap::SetRegion(const float* region)
+{
+    glUniform4fv(m_regionloc, 1, region);
+}
+
+void CShadowMap::EndOccluders()
+{
+    m_OccluderShader.Unbind();
+    m_Occluders.Disable();
+}
+
+void CShadowMap::Build(const uint32_t count)
+{
+    if(count == 0) return;
+
+    GLint view[4];
+    glGetIntegerv(GL_VIEWPORT, view);
+
+    // Each light only fills its own row, so there's nothing to clear.
+    gfx::CGLState::BindFramebuffer(m_fbo);
+    gfx::CGLState::Viewport(0, 0, m_resolution, count);
+    gfx::CGLState::EnableBlending(false);
+
+    m_PolarShader.Bind();
+    gfx::CGLState::BindTexture(m_Occluders.GetTexture());
+    Globals::g_FullscreenVBO.Draw();
+    gfx::CGLState::BindTexture(0);
+    m_PolarShader.Unbind();
+
+    gfx::CGLState::EnableBlending(true);
+    gfx::CGLState::BindFramebuffer(gfx::CWindow::GetScreenBuffer());
+    gfx::CGLState::Viewport(view[0], view[1], view[2], view[3]);
+}
+
+void CShadowMap::Bind(const uint32_t unit)
+{
+    gfx::CGLState::BindTexture(m_texture, unit);
+}
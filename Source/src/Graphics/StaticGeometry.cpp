@@ -0,0 +1,444 @@
+#include <cmath>
+#include <algorithm>
+
+#include "IronClad/Utils/Logging.hpp"
+#include "IronClad/Graphics/StaticGeometry.hpp"
+
+using namespace ic;
+using gfx::CStaticGeometry;
+using util::g_Log;
+
+CStaticGeometry::CStaticGeometry() : mp_VBO(NULL), m_rebuild(false) {}
+
+CStaticGeometry::~CStaticGeometry()
+{
+    this->Clear();
+}
+
+void CStaticGeometry::Init(gfx::CVertexBuffer& VBO)
+{
+    mp_VBO = &VBO;
+}
+
+bool CStaticGeometry::Add(obj::CEntity* pEntity)
+{
+    if(pEntity == NULL || mp_VBO == NULL) return false;
+
+    gfx::CMeshInstance& Mesh = pEntity->GetMesh();
+    if(Mesh.mp_Static != NULL || !this->CanBake(pEntity)) return false;
+
+    member_t Member;
+    Member.pEntity  = pEntity;
+    Member.dirty    = true;
+
+    int32_t id = 0;
+    if(m_freeList.empty())
+    {
+        id = m_Members.size();
+        m_Members.push_back(Member);
+    }
+    else
+    {
+        id = m_freeList.back();
+        m_freeList.pop_back();
+        m_Members[id] = Member;
+    }
+
+    Mesh.mp_Static   = this;
+    Mesh.m_static_id = id;
+
+    // Chunks are picked once it's in place.
+    m_dirty.push_back(id);
+    return true;
+}
+
+bool CStaticGeometry::Remove(obj::CEntity* pEntity)
+{
+    if(pEntity == NULL) return false;
+
+    gfx::CMeshInstance& Mesh = pEntity->GetMesh();
+    if(Mesh.mp_Static != this) return false;
+
+    this->Detach(Mesh.m_static_id);
+    return true;
+}
+
+void CStaticGeometry::Update(const int32_t id)
+{
+    if(id < 0 || id >= (int32_t)m_Members.size()) return;
+
+    member_t& Member = m_Members[id];
+    if(Member.pEntity == NULL || Member.dirty) return;
+
+    Member.dirty = true;
+    m_dirty.push_back(id);
+}
+
+void CStaticGeometry::Detach(const int32_t id)
+{
+    if(id < 0 || id >= (int32_t)m_Members.size()) return;
+
+    member_t& Member = m_Members[id];
+    if(Member.pEntity == NULL) return;
+
+    this->Unlink(id);
+    Member.pEntity->GetMesh().mp_Static   = NULL;
+    Member.pEntity->GetMesh().m_static_id = -1;
+    Member.pEntity  = NULL;
+    Member.dirty    = false;
+
+    m_freeList.push_back(id);
+}
+
+void CStaticGeometry::Rebake()
+{
+    if(m_dirty.empty() && !m_rebuild) return;
+
+    // Drop what detached entities left behind before anything new is
+    // linked, since their surfaces may be gone by now.
+    this->ReleaseSources();
+
+    // Move changed entities into whatever chunks they're in now.
+    for(size_t i = 0; i < m_dirty.size(); ++i)
+    {
+        member_t& Member = m_Members[m_dirty[i]];
+        if(Member.pEntity == NULL || !Member.dirty) continue;
+
+        Member.dirty = false;
+        this->Unlink(m_dirty[i]);
+
+        if(this->CanBake(Member.pEntity)) this->Link(m_dirty[i]);
+        else                              this->Detach(m_dirty[i]);
+    }
+
+    m_dirty.clear();
+    this->ReleaseSources();
+
+    for(ChunkMap_t::iterator i = m_Chunks.begin(); i != m_Chunks.end(); )
+    {
+        chunk_t& Chunk = i->second;
+        if(!Chunk.dirty)
+        {
+            ++i;
+            continue;
+        }
+
+        if(Chunk.members.empty())
+        {
+            this->FreePieces(Chunk);
+            m_Chunks.erase(i++);
+            continue;
+        }
+
+        this->Build(i->first, Chunk);
+        ++i;
+    }
+
+    m_rebuild = false;
+}
+
+uint32_t CStaticGeometry::Submit(const math::rect_t* pView,
+                                 gfx::CRenderQueue& Queue)
+{
+    uint32_t count = 0;
+    for(ChunkMap_t::iterator i = m_Chunks.begin(); i != m_Chunks.end(); ++i)
+    {
+        chunk_t& Chunk = i->second;
+
+        if(pView != NULL &&
+          (Chunk.Max.x < pView->x || Chunk.Min.x > pView->x + pView->w ||
+           Chunk.Max.y < pView->y || Chunk.Min.y > pView->y + pView->h))
+            continue;
+
+        for(size_t j = 0; j < Chunk.Pieces.size(); ++j)
+        {
+            Queue.Push(i->first.layer, i->first.depth,
+                       &Chunk.Pieces[j].Surface, 0, i->first.texture, false);
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void CStaticGeometry::Clear()
+{
+    for(size_t i = 0; i < m_Members.size(); ++i)
+    {
+        if(m_Members[i].pEntity == NULL) continue;
+
+        m_Members[i].pEntity->GetMesh().mp_Static   = NULL;
+        m_Members[i].pEntity->GetMesh().m_static_id = -1;
+    }
+
+    for(ChunkMap_t::iterator i = m_Chunks.begin(); i != m_Chunks.end(); ++i)
+        this->FreePieces(i->second);
+
+    m_Chunks.clear();
+    m_Sources.clear();
+    m_Members.clear();
+    m_freeList.clear();
+    m_dirty.clear();
+    m_rebuild = false;
+}
+
+asset::CTexture* CStaticGeometry::GetTexture(obj::CEntity* pEntity,
+                                             const gfx::surface_t* pSurface)
+{
+    // Same as the scene: quads get one single texture.
+    if(pEntity->GetMesh().GetSurfaces().size() == 1)
+        return pEntity->GetTexture();
+
+    return pSurface->pMaterial ? pSurface->pMaterial->pTexture : NULL;
+}
+
+bool CStaticGeometry::CanBake(obj::CEntity* pEntity) const
+{
+    float frame[4];
+    if(!pEntity->IsRenderable() || pEntity->LoadSpriteFrame(frame))
+        return false;
+
+    const std::vector<gfx::surface_t*>& Surfaces =
+        pEntity->GetMesh().GetSurfaces();
+
+    if(Surfaces.empty()) return false;
+
+    for(size_t i = 0; i < Surfaces.size(); ++i)
+    {
+        const gfx::surface_t* pSurface = Surfaces[i];
+        if(pSurface->pMaterial == NULL ||
+           pSurface->pMaterial->pShader != NULL) return false;
+
+        asset::CTexture* pTexture = GetTexture(pEntity, pSurface);
+        if(pTexture == NULL || !pTexture->IsOpaque()) return false;
+    }
+
+    return true;
+}
+
+void CStaticGeometry::Link(const int32_t id)
+{
+    member_t& Member = m_Members[id];
+    const std::vector<gfx::surface_t*>& Surfaces =
+        Member.pEntity->GetMesh().GetSurfaces();
+
+    // The whole entity goes into the cell under its center.
+    math::vector2_t Min, Max;
+    Member.pEntity->GetMesh().GetWorldBounds(Min, Max);
+
+    chunk_key_t Key;
+    Key.layer   = Member.pEntity->GetLayer();
+    Key.depth   = Member.pEntity->GetDepth();
+    Key.x       = (int32_t)floor((Min.x + Max.x) * 0.5f / CHUNK_SIZE);
+    Key.y       = (int32_t)floor((Min.y + Max.y) * 0.5f / CHUNK_SIZE);
+
+    for(size_t i = 0; i < Surfaces.size(); ++i)
+    {
+        asset::CTexture* pTexture = GetTexture(Member.pEntity, Surfaces[i]);
+        Key.texture = pTexture->GetTextureID();
+
+        ChunkMap_t::iterator c = m_Chunks.find(Key);
+        if(c == m_Chunks.end())
+        {
+            c = m_Chunks.insert(std::make_pair(Key, chunk_t())).first;
+            c->second.Material.pTexture = pTexture;
+        }
+
+        chunk_t& Chunk = c->second;
+        if(std::find(Chunk.members.begin(), Chunk.members.end(), id) ==
+           Chunk.members.end())
+        {
+            Chunk.members.push_back(id);
+            Member.Chunks.push_back(Key);
+        }
+
+        Chunk.dirty = true;
+
+        Member.Surfaces.push_back(Surfaces[i]);
+        ++m_Sources[Surfaces[i]].refs;
+    }
+
+    m_rebuild = true;
+}
+
+void CStaticGeometry::Unlink(const int32_t id)
+{
+    member_t& Member = m_Members[id];
+
+    for(size_t i = 0; i < Member.Chunks.size(); ++i)
+    {
+        ChunkMap_t::iterator c = m_Chunks.find(Member.Chunks[i]);
+        if(c == m_Chunks.end()) continue;
+
+        std::vector<int32_t>& Members = c->second.members;
+        Members.erase(std::remove(Members.begin(), Members.end(), id),
+                      Members.end());
+        c->second.dirty = true;
+    }
+
+    // Sources are kept until ReleaseSources(), so an entity that is
+    // just moving doesn't have to be read back again.
+    for(size_t i = 0; i < Member.Surfaces.size(); ++i)
+    {
+        SourceMap_t::iterator s = m_Sources.find(Member.Surfaces[i]);
+        if(s != m_Sources.end()) --s->second.refs;
+    }
+
+    if(!Member.Chunks.empty()) m_rebuild = true;
+
+    Member.Chunks.clear();
+    Member.Surfaces.clear();
+}
+
+void CStaticGeometry::ReleaseSources()
+{
+    for(SourceMap_t::iterator i = m_Sources.begin(); i != m_Sources.end(); )
+    {
+        if(i->second.refs == 0) m_Sources.erase(i++);
+        else                    ++i;
+    }
+}
+
+void CStaticGeometry::Build(const chunk_key_t& Key, chunk_t& Chunk)
+{
+    this->FreePieces(Chunk);
+    m_vertices.clear();
+    m_indices.clear();
+
+    // 16-bit indices can only reach so far from the base vertex.
+    const size_t limit = (mp_VBO->GetIndexType() == GL_UNSIGNED_INT) ?
+                          size_t(~0U) : 0x10000;
+
+    for(size_t m = 0; m < Chunk.members.size(); ++m)
+    {
+        member_t& Member = m_Members[Chunk.members[m]];
+        const gfx::CMeshInstance& Mesh = Member.pEntity->GetMesh();
+        const math::affine2x3_t& World = Mesh.GetWorldTransform();
+
+        math::vector2_t Min, Max;
+        Mesh.GetWorldBounds(Min, Max);
+
+        if(m == 0)
+        {
+            Chunk.Min = Min;
+            Chunk.Max = Max;
+        }
+        else
+        {
+            Chunk.Min.x = math::min<float>(Chunk.Min.x, Min.x);
+            Chunk.Min.y = math::min<float>(Chunk.Min.y, Min.y);
+            Chunk.Max.x = math::max<float>(Chunk.Max.x, Max.x);
+            Chunk.Max.y = math::max<float>(Chunk.Max.y, Max.y);
+        }
+
+        for(size_t s = 0; s < Member.Surfaces.size(); ++s)
+        {
+            const gfx::surface_t* pSurface = Member.Surfaces[s];
+            asset::CTexture* pTexture = GetTexture(Member.pEntity, pSurface);
+            if(pTexture->GetTextureID() != Key.texture) continue;
+
+            source_t& Source = m_Sources[pSurface];
+            if(!Source.loaded && !this->Load(pSurface, Source)) continue;
+
+            if(m_vertices.size() + Source.Vertices.size() > limit)
+                this->Flush(Chunk);
+
+            // Atlased textures only cover part of their page.
+            const float* region = pTexture->GetRegion();
+            const uint32_t base = m_vertices.size();
+
+            for(size_t v = 0; v < Source.Vertices.size(); ++v)
+            {
+                vertex2_t Vertex  = Source.Vertices[v];
+                Vertex.Position   = World * Vertex.Position;
+                Vertex.TexCoord.x = region[0] + Vertex.TexCoord.x * region[2];
+                Vertex.TexCoord.y = region[1] + Vertex.TexCoord.y * region[3];
+                m_vertices.push_back(Vertex);
+            }
+
+            for(size_t i = 0; i < Source.Indices.size(); ++i)
+                m_indices.push_back(base + Source.Indices[i]);
+        }
+    }
+
+    this->Flush(Chunk);
+    Chunk.dirty = false;
+}
+
+void CStaticGeometry::Flush(chunk_t& Chunk)
+{
+    if(m_indices.empty()) return;
+
+    piece_t Piece;
+    if(!mp_VBO->Allocate(m_vertices.size(), m_indices.size(), Piece.Range))
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to bake " << m_vertices.size();
+        g_Log << " vertices of static geometry.\n";
+        g_Log.PrintLastLog();
+    }
+    else
+    {
+        mp_VBO->Upload(Piece.Range, &m_vertices[0], &m_indices[0]);
+
+        Piece.Surface.pMaterial = &Chunk.Material;
+        Piece.Surface.start     = Piece.Range.istart;
+        Piece.Surface.base      = Piece.Range.vstart;
+        Piece.Surface.icount    = Piece.Range.icount;
+        Chunk.Pieces.push_back(Piece);
+    }
+
+    m_vertices.clear();
+    m_indices.clear();
+}
+
+void CStaticGeometry::FreePieces(chunk_t& Chunk)
+{
+    for(size_t i = 0; i < Chunk.Pieces.size(); ++i)
+        mp_VBO->Free(Chunk.Pieces[i].Range);
+
+    Chunk.Pieces.clear();
+}
+
+bool CStaticGeometry::Load(const gfx::surface_t* pSurface, source_t& Source)
+{
+    if(pSurface->icount == 0) return false;
+
+    // Meshes don't keep their data once it's on the GPU, so read it
+    // back. Happens once per surface, the first time it's baked.
+    const uint32_t isize = mp_VBO->GetIndexSize();
+    m_raw.resize(pSurface->icount * isize);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, mp_VBO->GetIBO());
+    glGetBufferSubData(GL_COPY_READ_BUFFER, pSurface->start * isize,
+                       m_raw.size(), &m_raw[0]);
+
+    Source.Indices.resize(pSurface->icount);
+    for(uint32_t i = 0; i < pSurface->icount; ++i)
+    {
+        Source.Indices[i] = (isize == 4) ?
+            ((const uint32_t*)&m_raw[0])[i] :
+            ((const uint16_t*)&m_raw[0])[i];
+    }
+
+    // Only copy the vertices the surface actually uses.
+    const uint32_t first = *std::min_element(Source.Indices.begin(),
+                                             Source.Indices.end());
+    const uint32_t last  = *std::max_element(Source.Indices.begin(),
+                                             Source.Indices.end());
+
+    for(uint32_t i = 0; i < pSurface->icount; ++i)
+        Source.Indices[i] -= first;
+
+    Source.Vertices.resize(last - first + 1);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, mp_VBO->GetVBO());
+    glGetBufferSubData(GL_COPY_READ_BUFFER,
+                       (pSurface->base + first) * sizeof(vertex2_t),
+                       Source.Vertices.size() * sizeof(vertex2_t),
+                       &Source.Vertices[0]);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    Source.loaded = true;
+    return true;
+}
@@ -0,0 +1,251 @@
+#include "IronClad/Graphics/StreamBuffer.hpp"
+#include "IronClad/Graphics/GLState.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+
+using namespace ic;
+using gfx::CStreamBuffer;
+using util::g_Log;
+
+CStreamBuffer::CStreamBuffer() : m_vao(0), m_vbo(0), m_ibo(0),
+    m_vregion(0), m_iregion(0), m_voffset(0), m_ioffset(0), m_frame(0),
+    m_regions(0), m_region(0), m_mapped(false) {}
+
+CStreamBuffer::~CStreamBuffer()
+{
+    this->Release();
+}
+
+bool CStreamBuffer::Init(const uint32_t vcount, const uint32_t icount,
+                         const uint8_t regions)
+{
+    if(!glMapBufferRange || !glFenceSync || !glDrawElementsBaseVertex)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Streaming buffers are not supported.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    this->Release();
+
+    m_regions   = (regions == 0) ? 1 : regions;
+    m_Fences.resize(m_regions, (GLsync)NULL);
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ibo);
+
+    if(!this->Grow(vcount, icount)) return false;
+
+    this->Attach();
+    m_frame = gfx::CWindow::GetFrameCount();
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] GFX: Created stream buffer (" << (int)m_regions;
+    g_Log << " x " << m_vregion << " vertices).\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    return (gfx::CGLError::Query("CStreamBuffer::Init") == GL_NO_ERROR);
+}
+
+bool CStreamBuffer::Map(const uint32_t vcount, const uint32_t icount,
+                        vertex2_t*& pVertices, uint16_t*& pIndices,
+                        gfx::geometry_range_t& Range)
+{
+    if(m_vao == 0 || m_mapped || vcount == 0 || icount == 0) return false;
+
+    // New frame, new region.
+    if(m_frame != gfx::CWindow::GetFrameCount())
+    {
+        m_frame = gfx::CWindow::GetFrameCount();
+        this->NextRegion();
+    }
+
+    // Too big for any region, so make them bigger.
+    if(vcount > m_vregion || icount > m_iregion)
+    {
+        if(!this->Grow(math::max<uint32_t>(vcount, m_vregion),
+                       math::max<uint32_t>(icount, m_iregion)))
+            return false;
+    }
+
+    // Doesn't fit in what's left of this region, start the next one.
+    else if(m_voffset + vcount > m_vregion || m_ioffset + icount > m_iregion)
+    {
+        this->NextRegion();
+    }
+
+    Range.vstart = m_region * m_vregion + m_voffset;
+    Range.istart = m_region * m_iregion + m_ioffset;
+    Range.vcount = vcount;
+    Range.icount = icount;
+
+    // The fence already told us the GPU is done with this region, so
+    // there's no need for the driver to synchronize anything.
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT |
+                             GL_MAP_INVALIDATE_RANGE_BIT;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    pVertices = (vertex2_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER,
+        Range.vstart * sizeof(vertex2_t), vcount * sizeof(vertex2_t), flags);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_ibo);
+    pIndices = (uint16_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER,
+        Range.istart * sizeof(uint16_t), icount * sizeof(uint16_t), flags);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    m_mapped = true;
+    if(pVertices == NULL || pIndices == NULL)
+    {
+        this->Unmap();
+
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to map stream buffer.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    m_voffset += vcount;
+    m_ioffset += icount;
+    return true;
+}
+
+void CStreamBuffer::Unmap()
+{
+    if(!m_mapped) return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_ibo);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    m_mapped = false;
+}
+
+void CStreamBuffer::Bind()
+{
+    gfx::CGLState::BindVertexArray(m_vao);
+}
+
+void CStreamBuffer::Unbind()
+{
+    gfx::CGLState::BindVertexArray(0);
+}
+
+void CStreamBuffer::Draw(const gfx::geometry_range_t& Range,
+                         const uint32_t first, const uint32_t count,
+                         const uint32_t geo_type)
+{
+    glDrawElementsBaseVertex(geo_type,
+        (count == 0) ? Range.icount : count, GL_UNSIGNED_SHORT,
+        (void*)(sizeof(uint16_t) * (Range.istart + first)),
+        Range.vstart);
+}
+
+void CStreamBuffer::Release()
+{
+    this->Unmap();
+
+    for(size_t i = 0; i < m_Fences.size(); ++i)
+        if(m_Fences[i] != NULL) glDeleteSync(m_Fences[i]);
+
+    m_Fences.clear();
+
+    if(glDeleteVertexArrays != NULL && m_vao != 0)
+    {
+        gfx::CGLState::ForgetVertexArray(m_vao);
+        glDeleteVertexArrays(1, &m_vao);
+        glDeleteBuffers(1, &m_vbo);
+        glDeleteBuffers(1, &m_ibo);
+    }
+
+    m_vao = m_vbo = m_ibo = 0;
+    m_region = m_voffset = m_ioffset = 0;
+}
+
+void CStreamBuffer::NextRegion()
+{
+    // Nothing was written, so the region can be re-used as is.
+    if(m_voffset == 0 && m_ioffset == 0) return;
+
+    // Mark the point at which the GPU is done with this region.
+    if(m_Fences[m_region] != NULL) glDeleteSync(m_Fences[m_region]);
+    m_Fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    m_region  = (m_region + 1) % m_regions;
+    m_voffset = m_ioffset = 0;
+
+    // Wait for the GPU to finish with the next region. With enough
+    // regions this has long since happened by the time we get here.
+    GLsync Fence = m_Fences[m_region];
+    if(Fence == NULL) return;
+
+    GLbitfield flags = 0;
+    while(glClientWaitSync(Fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+    glDeleteSync(Fence);
+    m_Fences[m_region] = NULL;
+}
+
+bool CStreamBuffer::Grow(const uint32_t vcount, const uint32_t icount)
+{
+    // Orphan the old storage, draws that are still using it keep it
+    // alive, so none of the fences matter anymore.
+    for(size_t i = 0; i < m_Fences.size(); ++i)
+    {
+        if(m_Fences[i] != NULL) glDeleteSync(m_Fences[i]);
+        m_Fences[i] = NULL;
+    }
+
+    m_vregion = vcount;
+    m_iregion = icount;
+    m_region  = 0;
+    m_voffset = m_ioffset = 0;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_vbo);
+    glBufferData(GL_COPY_WRITE_BUFFER, m_regions * m_vregion *
+        sizeof(vertex2_t), NULL, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_ibo);
+    glBufferData(GL_COPY_WRITE_BUFFER, m_regions * m_iregion *
+        sizeof(uint16_t), NULL, GL_STREAM_DRAW);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if(gfx::CGLError::Query("CStreamBuffer::Grow") != GL_NO_ERROR)
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to allocate stream buffer.\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    return true;
+}
+
+void CStreamBuffer::Attach()
+{
+    gfx::CGLState::BindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+
+    // Same layout as CVertexBuffer, see vertex2_t.
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE,
+        sizeof(vertex2_t), VBO_OFFSET(0, vertex2_t, Position));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
+        sizeof(vertex2_t), VBO_OFFSET(0, vertex2_t, TexCoord));
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE,
+        sizeof(vertex2_t), VBO_OFFSET(0, vertex2_t, Color));
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    gfx::CGLState::BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
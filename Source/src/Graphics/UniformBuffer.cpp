@@ -0,0 +1,56 @@
+#include "IronClad/Graphics/UniformBuffer.hpp"
+#include "IronClad/Graphics/Counters.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+#include "IronClad/Utils/Utilities.hpp"
+
+using namespace ic;
+using gfx::CUniformBuffer;
+using util::g_Log;
+
+CUniformBuffer::CUniformBuffer() : m_ubo(0), m_size(0), m_binding(0) {}
+
+CUniformBuffer::~CUniformBuffer()
+{
+    if(glDeleteBuffers != NULL && m_ubo != 0)
+        glDeleteBuffers(1, &m_ubo);
+}
+
+bool CUniformBuffer::Init(const uint32_t size, const uint32_t binding)
+{
+    if(!glBindBufferBase) return false;
+
+    m_size      = size;
+    m_binding   = binding;
+
+    glGenBuffers(1, &m_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, m_size, NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ubo);
+
+#ifdef _DEBUG
+    g_Log.Flush();
+    g_Log << "[DEBUG] GFX: Created uniform buffer (" << m_size << " bytes, ";
+    g_Log << "binding " << m_binding << ").\n";
+    g_Log.PrintLastLog();
+#endif // _DEBUG
+
+    return (gfx::CGLError::Query("CUniformBuffer::Init") == GL_NO_ERROR);
+}
+
+void CUniformBuffer::Update(const void* pdata, const uint32_t size)
+{
+    if(m_ubo == 0) return;
+
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, m_size, NULL, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, size < m_size ? size : m_size, pdata);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    gfx::Counters::bytes_uploaded += size < m_size ? size : m_size;
+}
+
+void CUniformBuffer::Bind()
+{
+    if(m_ubo != 0) glBindBufferBase(GL_UNIFORM_BUFFER, m_binding, m_ubo);
+}
@@ -1,11 +1,13 @@
 #include "IronClad/Graphics/VertexBuffer.hpp"
+#include "IronClad/Graphics/GLState.hpp"
+#include "IronClad/Graphics/GLError.hpp"
+#include "IronClad/Asset/Mesh.hpp"
 
 using namespace ic;
 using util::g_Log;
 using gfx::CVertexBuffer;
 
-CVertexBuffer::CVertexBuffer() : m_vertex_count(0), m_index_count(0),
-    m_last_error(GL_NO_ERROR)
+CVertexBuffer::CVertexBuffer() : m_last_error(GL_NO_ERROR)
 {
     // Clear everything.
     m_vertexBuffer.clear();
@@ -15,6 +17,7 @@ CVertexBuffer::CVertexBuffer() : m_vertex_count(0), m_index_count(0),
 
     m_vbo       = m_ibo = m_vao = 0;
     m_bo_type   = GL_STATIC_DRAW;
+    m_index_type= GL_UNSIGNED_SHORT;
 
     // Add some default vertex attributes.
     m_enabledAttributes.push_back(0);
@@ -32,9 +35,12 @@ bool CVertexBuffer::Init()
     // Create the buffers.
     if(!glGenVertexArrays) return false;
 
+    if(!m_VertexArena.Init(sizeof(vertex2_t), m_bo_type) ||
+       !m_IndexArena.Init(this->GetIndexSize(), m_bo_type))
+        return false;
+
     glGenVertexArrays(1, &m_vao);
-    glGenBuffers(1, &m_vbo);
-    glGenBuffers(1, &m_ibo);
+    this->Attach();
 
 #ifdef _DEBUG
     g_Log.Flush();
@@ -42,14 +48,16 @@ bool CVertexBuffer::Init()
     g_Log.PrintLastLog();
 #endif // _DEBUG
 
-    return ((m_last_error = glGetError()) == GL_NO_ERROR);
+    m_last_error = gfx::CGLError::Query("CVertexBuffer::Init");
+    return (m_last_error == GL_NO_ERROR);
 }
 
 void CVertexBuffer::Release()
 {
     this->Unbind();
+    this->EvictResidents();
 
-    if(glDeleteVertexArrays != NULL && !m_vao && !m_vbo && !m_ibo)
+    if(glDeleteVertexArrays != NULL && m_vao != 0)
     {
 #ifdef _DEBUG
         g_Log.Flush();
@@ -57,52 +65,39 @@ void CVertexBuffer::Release()
         g_Log.PrintLastLog();
 #endif // _DEBUG
 
+        gfx::CGLState::ForgetVertexArray(m_vao);
         glDeleteVertexArrays(1, &m_vao);
-        glDeleteBuffers(1, &m_vbo);
-        glDeleteBuffers(1, &m_ibo);
     }
+
+    m_VertexArena.Release();
+    m_IndexArena.Release();
+    m_vao = m_vbo = m_ibo = 0;
 }
 
 bool CVertexBuffer::Bind()
 {
     if(m_vao == 0 || m_vbo == 0 || m_ibo == 0) return false;
 
-    glBindVertexArray(m_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
-    
-    std::for_each(
-        m_enabledAttributes.begin(),
-        m_enabledAttributes.end(),
-        glEnableVertexAttribArray);
-
-    return ((m_last_error = glGetError()) == GL_NO_ERROR);
+    // The buffers and enabled attributes are part of the VAO already.
+    gfx::CGLState::BindVertexArray(m_vao);
+    return true;
 }
 
 bool CVertexBuffer::Unbind()
 {
     if(m_vao == 0 || m_vbo == 0 || m_ibo == 0) return false;
 
-    std::for_each(
-        m_enabledAttributes.begin(),
-        m_enabledAttributes.end(),
-        glDisableVertexAttribArray);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);    
-    glBindVertexArray(0);
-    
-    return ((m_last_error = glGetError()) == GL_NO_ERROR);
+    gfx::CGLState::BindVertexArray(0);
+    return true;
 }
 
 void CVertexBuffer::Draw()
 {
+    // Left bound, the next draw probably uses it too.
     this->Bind();
 
-    glDrawElements(GL_TRIANGLES, m_index_count,
-        GL_UNSIGNED_SHORT, NULL);
-
-    this->Unbind();
+    glDrawElements(GL_TRIANGLES, this->GetICount(),
+        m_index_type, NULL);
 }
 
 /**
@@ -138,79 +133,131 @@ void CVertexBuffer::AddData(
         m_indexBuffer.push_back(pIBuffer[i]);
 }
 
-/**
- * @todo Fix the VAO attribute ID locating.
- **/
 void CVertexBuffer::FinalizeBuffer()
 {
     // No point in finalizing if it's been done!
     if(this->Finalized()) return;
-    
-    // Bind the VAO / VBO / IBO for use.
-    if(!this->Bind()) return;
 
-    // Check if there's existing data on the buffers.
-    int32_t bsize = 0;
-    glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &bsize);
+    // Give the pending data its own range, leaving everything
+    // already on the GPU where it is.
+    geometry_range_t Range;
+    if(!this->Allocate(m_vertexBuffer.size(), m_indexBuffer.size(), Range))
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to finalize vertex buffer, dropping ";
+        g_Log << m_vertexBuffer.size() << " vertices.\n";
+        g_Log.PrintLastLog();
+    }
+    // Draw() uses no base vertex, so the indices have to be absolute.
+    else if(m_index_type == GL_UNSIGNED_INT)
+    {
+        m_wideIndices.resize(m_indexBuffer.size());
+        for(size_t i = 0; i < m_indexBuffer.size(); ++i)
+            m_wideIndices[i] = m_indexBuffer[i] + Range.vstart;
 
-    // There is!
-    if(bsize > 0)
+        this->Upload(Range, &m_vertexBuffer[0], &m_wideIndices[0]);
+    }
+    else if(Range.vstart + Range.vcount > 0x10000)
     {
-        // Copy existing buffer data from GPU to local buffer.
-        vertex2_t* data = (vertex2_t*)glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY);
-        vertex2_t* vtmp = new vertex2_t[bsize / sizeof(vertex2_t)];
-        memcpy(vtmp, data, bsize);
-        glUnmapBuffer(GL_ARRAY_BUFFER);
-
-        // Allocate enough GPU space for all vertex data, new and old.
-        // Pass the old data directly to it.
-        glBufferData(GL_ARRAY_BUFFER,
-            bsize + (sizeof m_vertexBuffer[0] * m_vertexBuffer.size()),
-            vtmp, m_bo_type);
-
-        // Pass the latest vertex data at the end of the existing data.
-        glBufferSubData(GL_ARRAY_BUFFER, 
-            (bsize + (sizeof m_vertexBuffer[0] * m_vertexBuffer.size())),
-            sizeof m_vertexBuffer[0] * m_vertexBuffer.size(),
-            &m_vertexBuffer[0]);
+        this->Free(Range);
+
+        g_Log.Flush();
+        g_Log << "[ERROR] Vertex buffer is out of 16-bit index space.\n";
+        g_Log.PrintLastLog();
     }
-    // No existing buffer or vertices.
     else
     {
-        // Allocate enough space for all vertices on GPU.
-        glBufferData(GL_ARRAY_BUFFER, 
-            sizeof(m_vertexBuffer[0]) * m_vertexBuffer.size(),
-            &m_vertexBuffer[0], m_bo_type);
+        for(size_t i = 0; i < m_indexBuffer.size(); ++i)
+            m_indexBuffer[i] += Range.vstart;
+
+        this->Upload(Range, &m_vertexBuffer[0], &m_indexBuffer[0]);
+    }
+
+    // We're done, clean up buffers.
+    m_vertexBuffer.clear();
+    m_indexBuffer.clear();
+}
+
+bool CVertexBuffer::Allocate(const uint32_t vcount, const uint32_t icount,
+                             geometry_range_t& Range)
+{
+    if(m_vao == 0 || vcount == 0 || icount == 0) return false;
+
+    Range.vcount = vcount;
+    Range.icount = icount;
+
+    if(!m_VertexArena.Allocate(vcount, Range.vstart)) return false;
+    if(!m_IndexArena.Allocate(icount, Range.istart))
+    {
+        m_VertexArena.Free(Range.vstart, vcount);
+        return false;
     }
 
-    // Repeat process for index buffer.
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &bsize);
-    if(bsize > 0)
+    // Either arena may have grown into a new buffer.
+    if(m_vbo != m_VertexArena.GetBuffer() ||
+       m_ibo != m_IndexArena.GetBuffer()) this->Attach();
+
+    return true;
+}
+
+void CVertexBuffer::Upload(const geometry_range_t& Range,
+                           const vertex2_t* pVertices,
+                           const uint16_t*  pIndices)
+{
+    m_VertexArena.Upload(Range.vstart, Range.vcount, pVertices);
+
+    if(m_index_type == GL_UNSIGNED_INT)
     {
-        uint16_t* data = (uint16_t*)glMapBuffer(GL_ELEMENT_ARRAY_BUFFER, GL_READ_ONLY);
-        uint16_t* itmp = new uint16_t[bsize / sizeof(uint16_t)];
-        memcpy(itmp, data, bsize);
-        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-
-        // Allocate enough GPU space for all vertex data, new and old.
-        // Pass the old data directly to it.
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            bsize + (sizeof m_indexBuffer[0] * m_indexBuffer.size()),
-            itmp, m_bo_type);
-
-        // Pass the latest vertex data at the end of the existing data.
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 
-            (bsize + (sizeof m_indexBuffer[0] * m_indexBuffer.size())),
-            sizeof m_indexBuffer[0] * m_indexBuffer.size(),
-            &m_indexBuffer[0]);
+        m_wideIndices.assign(pIndices, pIndices + Range.icount);
+        m_IndexArena.Upload(Range.istart, Range.icount, &m_wideIndices[0]);
     }
     else
     {
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-            sizeof(m_indexBuffer[0]) * m_indexBuffer.size(),
-            &m_indexBuffer[0], m_bo_type);
+        m_IndexArena.Upload(Range.istart, Range.icount, pIndices);
     }
 
+    m_last_error = IC_GL_CHECK();
+}
+
+void CVertexBuffer::Upload(const geometry_range_t& Range,
+                           const vertex2_t* pVertices,
+                           const uint32_t*  pIndices)
+{
+    if(m_index_type == GL_UNSIGNED_INT)
+    {
+        m_VertexArena.Upload(Range.vstart, Range.vcount, pVertices);
+        m_IndexArena.Upload(Range.istart, Range.icount, pIndices);
+        m_last_error = IC_GL_CHECK();
+        return;
+    }
+
+    // Narrowing is fine as long as the range is small enough.
+    std::vector<uint16_t> Narrow(pIndices, pIndices + Range.icount);
+    this->Upload(Range, pVertices, &Narrow[0]);
+}
+
+void CVertexBuffer::Free(const geometry_range_t& Range)
+{
+    m_VertexArena.Free(Range.vstart, Range.vcount);
+    m_IndexArena.Free(Range.istart, Range.icount);
+}
+
+/**
+ * @todo Fix the VAO attribute ID locating.
+ **/
+void CVertexBuffer::Attach()
+{
+    // Don't disturb whatever VAO is bound right now.
+    int32_t last_vao = 0;
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vao);
+
+    m_vbo = m_VertexArena.GetBuffer();
+    m_ibo = m_IndexArena.GetBuffer();
+
+    gfx::CGLState::BindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+
     // Vertices are arranged in memory like so:
     // [ p0, p1, t0, t1, c0, c1, c2, c3 ]
     // (see IronClad/Base/Types.hpp)
@@ -219,38 +266,57 @@ void CVertexBuffer::FinalizeBuffer()
     // According to the diagram shown above, the vertex position
     // would start at index 0.
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 
-        sizeof(m_vertexBuffer[0]), VBO_OFFSET(0, vertex2_t, Position));
+        sizeof(vertex2_t), VBO_OFFSET(0, vertex2_t, Position));
 
     // Specify texture coordinate position arrangement.
     // According to the diagram, texture coordinates
     // start at index 2.
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE,
-        sizeof(m_vertexBuffer[0]), VBO_OFFSET(0, vertex2_t, TexCoord));
+        sizeof(vertex2_t), VBO_OFFSET(0, vertex2_t, TexCoord));
 
     // Specify the color arrangement.
     // Starting at index 4.
     glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, 
-        sizeof(m_vertexBuffer[0]), VBO_OFFSET(0, vertex2_t, Color));
+        sizeof(vertex2_t), VBO_OFFSET(0, vertex2_t, Color));
 
-    // We're done, clean up buffers.
-    m_vertex_count += m_vertexBuffer.size();
-    m_index_count  += m_indexBuffer.size();
-    m_vertexBuffer.clear();
-    m_indexBuffer.clear();
+    // Enabled once, the VAO remembers.
+    for(size_t i = 0; i < m_enabledAttributes.size(); ++i)
+        glEnableVertexAttribArray(m_enabledAttributes[i]);
 
-    this->Unbind();
+    gfx::CGLState::BindVertexArray(last_vao);
 }
 
 void CVertexBuffer::Clear()
 {
-    if(!this->Bind()) return;
+    if(m_vao == 0) return;
 
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, m_bo_type);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 0, NULL, m_bo_type);
-    
-    m_vertex_count = m_index_count = 0;
+    this->EvictResidents();
+    m_VertexArena.Clear();
+    m_IndexArena.Clear();
     m_vertexBuffer.clear();
     m_indexBuffer.clear();
-    
-    this->Unbind();
+}
+
+void CVertexBuffer::AddResident(asset::CMesh* pMesh)
+{
+    mp_Residents.push_back(pMesh);
+}
+
+void CVertexBuffer::RemoveResident(asset::CMesh* pMesh)
+{
+    std::vector<asset::CMesh*>::iterator i = 
+        std::find(mp_Residents.begin(), mp_Residents.end(), pMesh);
+
+    if(i == mp_Residents.end()) return;
+
+    *i = mp_Residents.back();
+    mp_Residents.pop_back();
+}
+
+void CVertexBuffer::EvictResidents()
+{
+    for(size_t i = 0; i < mp_Residents.size(); ++i)
+        mp_Residents[i]->mp_Resident = NULL;
+
+    mp_Residents.clear();
 }
@@ -0,0 +1,242 @@
+#include <cmath>
+
+#include "IronClad/Graphics/Visibility.hpp"
+#include "IronClad/Entity/Entity.hpp"
+
+using namespace ic;
+using gfx::CVisibilityGrid;
+
+CVisibilityGrid::CVisibilityGrid(const uint16_t cell_size) :
+    m_cell_size(cell_size), m_query(0) {}
+
+CVisibilityGrid::~CVisibilityGrid()
+{
+    this->Clear();
+}
+
+bool CVisibilityGrid::Insert(obj::CEntity* pEntity, const uint32_t order)
+{
+    if(pEntity == NULL) return false;
+
+    gfx::CMeshInstance& Mesh = pEntity->GetMesh();
+    if(Mesh.mp_Grid != NULL) return false;
+
+    proxy_t Proxy;
+    Proxy.pEntity   = pEntity;
+    Proxy.order     = order;
+    Proxy.query     = m_query;
+    Proxy.moved     = false;
+    this->CalculateCells(Proxy);
+
+    int32_t id = 0;
+    if(m_freeList.empty())
+    {
+        id = m_Proxies.size();
+        m_Proxies.push_back(Proxy);
+    }
+    else
+    {
+        id = m_freeList.back();
+        m_freeList.pop_back();
+
+        // A removed entity may still be listed as moved.
+        Proxy.moved   = m_Proxies[id].moved;
+        m_Proxies[id] = Proxy;
+    }
+
+    Mesh.mp_Grid = this;
+    Mesh.m_proxy = id;
+
+    this->Bin(id);
+    this->MarkMoved(id);
+    return true;
+}
+
+bool CVisibilityGrid::Remove(obj::CEntity* pEntity)
+{
+    if(pEntity == NULL) return false;
+
+    gfx::CMeshInstance& Mesh = pEntity->GetMesh();
+    if(Mesh.mp_Grid != this) return false;
+
+    this->Detach(Mesh.m_proxy);
+    return true;
+}
+
+void CVisibilityGrid::Detach(const int32_t proxy)
+{
+    if(proxy < 0 || proxy >= (int32_t)m_Proxies.size()) return;
+
+    proxy_t& Proxy = m_Proxies[proxy];
+    if(Proxy.pEntity == NULL) return;
+
+    this->Unbin(proxy);
+    Proxy.pEntity->GetMesh().mp_Grid = NULL;
+    Proxy.pEntity->GetMesh().m_proxy = -1;
+    Proxy.pEntity = NULL;
+
+    m_freeList.push_back(proxy);
+}
+
+void CVisibilityGrid::Update(const int32_t proxy)
+{
+    if(proxy < 0 || proxy >= (int32_t)m_Proxies.size()) return;
+
+    this->MarkMoved(proxy);
+
+    proxy_t& Proxy = m_Proxies[proxy];
+    proxy_t Moved  = Proxy;
+    this->CalculateCells(Moved);
+
+    // Most movement stays within the same cells.
+    if(Moved.x0 == Proxy.x0 && Moved.y0 == Proxy.y0 &&
+       Moved.x1 == Proxy.x1 && Moved.y1 == Proxy.y1) return;
+
+    this->Unbin(proxy);
+    Proxy = Moved;
+    this->Bin(proxy);
+}
+
+void CVisibilityGrid::SetOrder(obj::CEntity* pEntity, const uint32_t order)
+{
+    gfx::CMeshInstance& Mesh = pEntity->GetMesh();
+    if(Mesh.mp_Grid != this) return;
+
+    m_Proxies[Mesh.m_proxy].order = order;
+}
+
+uint32_t CVisibilityGrid::GetOrder(obj::CEntity* pEntity) const
+{
+    gfx::CMeshInstance& Mesh = pEntity->GetMesh();
+    if(Mesh.mp_Grid != this) return 0;
+
+    return m_Proxies[Mesh.m_proxy].order;
+}
+
+void CVisibilityGrid::Query(const math::rect_t& Rect,
+                            std::vector<obj::CEntity*>& Results)
+{
+    Results.clear();
+    m_queryResults.clear();
+
+    // Stamp each query so that entities spanning several cells
+    // are only reported once.
+    ++m_query;
+
+    int32_t x0 = (int32_t)floor(Rect.x / m_cell_size);
+    int32_t y0 = (int32_t)floor(Rect.y / m_cell_size);
+    int32_t x1 = (int32_t)floor((Rect.x + Rect.w) / m_cell_size);
+    int32_t y1 = (int32_t)floor((Rect.y + Rect.h) / m_cell_size);
+
+    for(int32_t x = x0; x <= x1; ++x)
+    {
+        for(int32_t y = y0; y <= y1; ++y)
+        {
+            CellMap_t::const_iterator i = m_Cells.find(CellKey(x, y));
+            if(i == m_Cells.end()) continue;
+
+            for(size_t j = 0; j < i->second.size(); ++j)
+            {
+                proxy_t& Proxy = m_Proxies[i->second[j]];
+                if(Proxy.query == m_query) continue;
+
+                Proxy.query = m_query;
+                m_queryResults.push_back(i->second[j]);
+            }
+        }
+    }
+
+    // Put everything back in draw order.
+    std::sort(m_queryResults.begin(), m_queryResults.end(),
+              OrderCompare(m_Proxies));
+
+    Results.reserve(m_queryResults.size());
+    for(size_t i = 0; i < m_queryResults.size(); ++i)
+        Results.push_back(m_Proxies[m_queryResults[i]].pEntity);
+}
+
+void CVisibilityGrid::ConsumeMoved(std::vector<obj::CEntity*>& Results)
+{
+    Results.clear();
+    for(size_t i = 0; i < m_moved.size(); ++i)
+    {
+        proxy_t& Proxy = m_Proxies[m_moved[i]];
+        Proxy.moved = false;
+
+        if(Proxy.pEntity != NULL) Results.push_back(Proxy.pEntity);
+    }
+
+    m_moved.clear();
+}
+
+void CVisibilityGrid::MarkMoved(const int32_t proxy)
+{
+    if(m_Proxies[proxy].moved) return;
+
+    m_Proxies[proxy].moved = true;
+    m_moved.push_back(proxy);
+}
+
+void CVisibilityGrid::Clear()
+{
+    for(size_t i = 0; i < m_Proxies.size(); ++i)
+    {
+        if(m_Proxies[i].pEntity == NULL) continue;
+
+        m_Proxies[i].pEntity->GetMesh().mp_Grid = NULL;
+        m_Proxies[i].pEntity->GetMesh().m_proxy = -1;
+    }
+
+    m_Cells.clear();
+    m_Proxies.clear();
+    m_freeList.clear();
+    m_moved.clear();
+}
+
+void CVisibilityGrid::Bin(const int32_t proxy)
+{
+    const proxy_t& Proxy = m_Proxies[proxy];
+
+    for(int32_t x = Proxy.x0; x <= Proxy.x1; ++x)
+        for(int32_t y = Proxy.y0; y <= Proxy.y1; ++y)
+            m_Cells[CellKey(x, y)].push_back(proxy);
+}
+
+void CVisibilityGrid::Unbin(const int32_t proxy)
+{
+    const proxy_t& Proxy = m_Proxies[proxy];
+
+    for(int32_t x = Proxy.x0; x <= Proxy.x1; ++x)
+    {
+        for(int32_t y = Proxy.y0; y <= Proxy.y1; ++y)
+        {
+            CellMap_t::iterator i = m_Cells.find(CellKey(x, y));
+            if(i == m_Cells.end()) continue;
+
+            // Order within a cell doesn't matter, so swap and pop.
+            std::vector<int32_t>& Cell = i->second;
+            for(size_t j = 0; j < Cell.size(); ++j)
+            {
+                if(Cell[j] == proxy)
+                {
+                    Cell[j] = Cell.back();
+                    Cell.pop_back();
+                    break;
+                }
+            }
+
+            if(Cell.empty()) m_Cells.erase(i);
+        }
+    }
+}
+
+void CVisibilityGrid::CalculateCells(proxy_t& Proxy) const
+{
+    math::vector2_t Min, Max;
+    Proxy.pEntity->GetMesh().GetWorldBounds(Min, Max);
+
+    Proxy.x0 = (int32_t)floor(Min.x / m_cell_size);
+    Proxy.y0 = (int32_t)floor(Min.y / m_cell_size);
+    Proxy.x1 = (int32_t)floor(Max.x / m_cell_size);
+    Proxy.y1 = (int32_t)floor(Max.y / m_cell_size);
+}
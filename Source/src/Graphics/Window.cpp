@@ -1,4 +1,6 @@
 #include "IronClad/Graphics/Window.hpp"
+#include "IronClad/Graphics/GLState.hpp"
+#include "IronClad/Graphics/GLError.hpp"
 
 using namespace ic;
 
@@ -6,6 +8,8 @@ using gfx::CWindow;
 using util::g_Log;
 
 math::matrix4x4_t CWindow::m_ProjectionMatrix;
+uint32_t          CWindow::m_frame_count = 0;
+uint32_t          CWindow::m_screen      = 0;
 
 CWindow::CWindow() : m_width(0),
     m_height(0), m_fullscreen(0) {}
@@ -36,6 +40,10 @@ bool CWindow::Create(
     glfwOpenWindowHint(GLFW_OPENGL_VERSION_MAJOR, 3);
     glfwOpenWindowHint(GLFW_OPENGL_VERSION_MINOR, 3);
     glfwOpenWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Drivers only have to report errors to debug contexts.
+    if(gfx::CGLError::GetPolicy() != gfx::IC_GL_ERRORS_OFF)
+        glfwOpenWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GL_TRUE);
     
     if(glfwOpenWindow(m_width, m_height, 8, 8, 8, 8, 24, 8,
         m_fullscreen ? GLFW_FULLSCREEN : GLFW_WINDOW) == GL_FALSE)
@@ -106,7 +114,13 @@ bool CWindow::Create(
     if(glewInit() != GLEW_OK) return false;
 
     // This error is caused by glew on core profiles for some reason.
-    return (glGetError() == GL_INVALID_ENUM);
+    const bool glew_ok = (glGetError() == GL_INVALID_ENUM);
+
+    // Nothing is known about a new context.
+    gfx::CGLError::Init();
+    gfx::CGLState::Invalidate();
+
+    return glew_ok;
 }
 
 /**
@@ -125,6 +139,7 @@ void CWindow::Clear(const color4f_t* BGColor)
 void CWindow::Update()
 {
     glfwSwapBuffers();
+    ++m_frame_count;
 }
 
 /**
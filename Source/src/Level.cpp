@@ -1,4 +1,5 @@
 #include "IronClad/Level.hpp"
+#include "IronClad/Utils/Profiler.hpp"
 
 using namespace ic;
 using util::g_Log;
@@ -27,6 +28,8 @@ CLevel::~CLevel()
 
 bool CLevel::LoadFromFile(const std::string& filename, gfx::CScene& Scene)
 {
+    IC_PROFILE_FUNCTION();
+
     std::stringstream ss;
     std::ifstream file;
     std::string line;
@@ -135,6 +138,10 @@ bool CLevel::LoadFromFile(const std::string& filename, gfx::CScene& Scene)
                     pEntity = new obj::CEntity;
                 }
 
+                // Static level geometry gets baked by the scene.
+                if(Parser.GetValueb("isStatic"))
+                    pEntity->SetStatic(true);
+
                 if(!pEntity->LoadFromMesh(pMesh, Scene.GetGeometryBuffer()))
                 {
                     g_Log.Flush();
@@ -175,6 +182,10 @@ bool CLevel::LoadFromFile(const std::string& filename, gfx::CScene& Scene)
                 }
             }
 
+            // Draw order, both default to the back.
+            pEntity->SetLayer(Parser.GetValuei("layer"));
+            pEntity->SetDepth(Parser.GetValuef("depth"));
+
             file.seekg(ent_e);
             Parser.Reset();
         }
@@ -2,6 +2,19 @@
 
 using namespace ic;
 using math::matrix4x4_t;
+using math::affine2x3_t;
+
+affine2x3_t::affine2x3_t()
+{
+    m[0] = m[3] = 1.f;
+    m[1] = m[2] = m[4] = m[5] = 0.f;
+}
+
+math::vector2_t affine2x3_t::operator*(const math::vector2_t& Point) const
+{
+    return math::vector2_t(m[0] * Point.x + m[2] * Point.y + m[4],
+                           m[1] * Point.x + m[3] * Point.y + m[5]);
+}
 
 matrix4x4_t::matrix4x4_t()
 {
@@ -40,6 +53,12 @@ float* matrix4x4_t::operator[](uint8_t index)
     return m_values[index];
 }
 
+const float* matrix4x4_t::operator[](uint8_t index) const
+{
+    math::clamp<uint8_t>(index, 0, 3);
+    return m_values[index];
+}
+
 matrix4x4_t matrix4x4_t::operator*(matrix4x4_t& Other) const
 {
     matrix4x4_t Res;
@@ -80,6 +99,16 @@ void matrix4x4_t::Print() const
     }
 }
 
+void matrix4x4_t::LoadAffine(const math::affine2x3_t& Affine)
+{
+    m_values[0][0] = Affine.m[0];
+    m_values[1][0] = Affine.m[1];
+    m_values[0][1] = Affine.m[2];
+    m_values[1][1] = Affine.m[3];
+    m_values[0][3] = Affine.m[4];
+    m_values[1][3] = Affine.m[5];
+}
+
 matrix4x4_t matrix4x4_t::CreateIdentityMatrix()
 {
     matrix4x4_t Result;
@@ -1,4 +1,5 @@
 #include "IronClad/Utils/Loader.hpp"
+#include "IronClad/Graphics/GLState.hpp"
 
 using namespace ic;
 
@@ -39,7 +40,7 @@ uint32_t util::load_texture(const char* pfilename)
 
     // Create a texture and bind it.
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gfx::CGLState::BindTexture(texture);
 
     // Load texture and set up parameters.
     if(!glfwLoadTexture2D(pfilename, GLFW_NO_RESCALE_BIT)) return false;
@@ -47,7 +48,7 @@ uint32_t util::load_texture(const char* pfilename)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gfx::CGLState::BindTexture(0);
 
     return texture;
 }
@@ -61,12 +62,12 @@ uint32_t util::surface_to_texture(SDL_Surface* pSrc)
     uint16_t format = pSrc->format->BytesPerPixel == 4 ? GL_RGBA : GL_RGB;
 
     glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gfx::CGLState::BindTexture(texture);
     glTexImage2D(GL_TEXTURE_2D, 0, format, pSrc->w, pSrc->h, 0,
         format, GL_UNSIGNED_BYTE, pSrc->pixels);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    gfx::CGLState::BindTexture(0);
 
     return texture;
 }
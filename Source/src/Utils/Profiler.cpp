@@ -0,0 +1,220 @@
+#include <vector>
+#include <fstream>
+#include <mutex>
+
+#ifdef _WIN32
+  #define WIN32_LEAN_AND_MEAN
+  #include <Windows.h>
+#else
+  #include <chrono>
+#endif // _WIN32
+
+#include "IronClad/Utils/Logging.hpp"
+#include "IronClad/Utils/Profiler.hpp"
+
+#ifdef _MSC_VER
+  #define IC_THREAD_LOCAL __declspec(thread)
+#else
+  #define IC_THREAD_LOCAL __thread
+#endif // _MSC_VER
+
+using namespace ic;
+using util::CProfiler;
+using util::g_Log;
+
+namespace
+{
+    struct event_t
+    {
+        const char* pname;
+        uint64_t    start, end;     // Microseconds
+    };
+
+    /**
+     * Only the owning thread ever writes to its buffer.
+     **/
+    struct thread_buffer_t
+    {
+        std::vector<event_t> Events;
+        uint32_t    open[CProfiler::MAX_DEPTH];
+        uint32_t    tid;
+        uint8_t     depth;
+        bool        dropped;
+    };
+
+    // Buffers live until the program exits, since threads keep a
+    // pointer to theirs.
+    struct registry_t
+    {
+        ~registry_t()
+        {
+            for(size_t i = 0; i < Buffers.size(); ++i) delete Buffers[i];
+        }
+
+        std::mutex                      Lock;
+        std::vector<thread_buffer_t*>   Buffers;
+    };
+
+    IC_THREAD_LOCAL thread_buffer_t* tp_Buffer = NULL;
+
+    registry_t& GetRegistry()
+    {
+        static registry_t g_Registry;
+        return g_Registry;
+    }
+
+    thread_buffer_t* GetBuffer()
+    {
+        if(tp_Buffer != NULL) return tp_Buffer;
+
+        thread_buffer_t* pBuffer = new thread_buffer_t;
+        pBuffer->Events.reserve(1024);
+        pBuffer->depth = 0;
+        pBuffer->dropped = false;
+
+        registry_t& Registry = GetRegistry();
+        std::lock_guard<std::mutex> Guard(Registry.Lock);
+
+        pBuffer->tid = Registry.Buffers.size() + 1;
+        Registry.Buffers.push_back(pBuffer);
+        return (tp_Buffer = pBuffer);
+    }
+
+    // Names are usually identifiers, but don't let one break the file.
+    void WriteName(std::ofstream& File, const char* pname)
+    {
+        for( ; *pname; ++pname)
+        {
+            if(*pname == '"' || *pname == '\\') File << '\\';
+            File << *pname;
+        }
+    }
+}
+
+uint64_t CProfiler::GetTime()
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq = { 0 };
+    if(freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return (now.QuadPart / freq.QuadPart) * 1000000 +
+           (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif // _WIN32
+}
+
+void CProfiler::Begin(const char* pname)
+{
+    thread_buffer_t* pBuffer = GetBuffer();
+    if(pBuffer->depth >= MAX_DEPTH)
+    {
+        ++pBuffer->depth;
+        return;
+    }
+
+    uint32_t index = uint32_t(-1);
+    if(pBuffer->Events.size() < MAX_EVENTS)
+    {
+        event_t Event = { pname, GetTime(), 0 };
+        index = pBuffer->Events.size();
+        pBuffer->Events.push_back(Event);
+    }
+    else
+    {
+        pBuffer->dropped = true;
+    }
+
+    pBuffer->open[pBuffer->depth++] = index;
+}
+
+void CProfiler::End()
+{
+    thread_buffer_t* pBuffer = tp_Buffer;
+    if(pBuffer == NULL || pBuffer->depth == 0) return;
+
+    uint8_t depth = --pBuffer->depth;
+    if(depth >= MAX_DEPTH) return;
+
+    uint32_t index = pBuffer->open[depth];
+    if(index != uint32_t(-1)) pBuffer->Events[index].end = GetTime();
+}
+
+bool CProfiler::Save(const char* pfilename)
+{
+    std::ofstream File(pfilename, std::ios::out | std::ios::trunc);
+    if(!File.is_open())
+    {
+        g_Log.Flush();
+        g_Log << "[ERROR] Failed to open profiler trace: " << pfilename;
+        g_Log << "\n";
+        g_Log.PrintLastLog();
+        return false;
+    }
+
+    registry_t& Registry = GetRegistry();
+    std::lock_guard<std::mutex> Guard(Registry.Lock);
+
+    File << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    bool first = true;
+    for(size_t i = 0; i < Registry.Buffers.size(); ++i)
+    {
+        const thread_buffer_t* pBuffer = Registry.Buffers[i];
+
+        if(pBuffer->dropped)
+        {
+            g_Log.Flush();
+            g_Log << "[INFO] Profiler dropped events on thread ";
+            g_Log << pBuffer->tid << ", the buffer was full.\n";
+            g_Log.PrintLastLog();
+        }
+
+        for(size_t j = 0; j < pBuffer->Events.size(); ++j)
+        {
+            // Still running.
+            const event_t& Event = pBuffer->Events[j];
+            if(Event.end < Event.start) continue;
+
+            File << (first ? "" : ",\n") << "{\"name\":\"";
+            WriteName(File, Event.pname);
+            File << "\",\"cat\":\"IronClad\",\"ph\":\"X\",\"pid\":1"
+                 << ",\"tid\":" << pBuffer->tid
+                 << ",\"ts\":"  << Event.start
+                 << ",\"dur\":" << Event.end - Event.start << "}";
+
+            first = false;
+        }
+    }
+
+    File << "\n]}\n";
+    return File.good();
+}
+
+void CProfiler::Clear()
+{
+    registry_t& Registry = GetRegistry();
+    std::lock_guard<std::mutex> Guard(Registry.Lock);
+
+    for(size_t i = 0; i < Registry.Buffers.size(); ++i)
+    {
+        thread_buffer_t* pBuffer = Registry.Buffers[i];
+
+        // Keep whatever is still running, so End() has somewhere to go.
+        size_t keep = 0;
+        for(uint8_t d = 0; d < pBuffer->depth && d < MAX_DEPTH; ++d)
+        {
+            uint32_t& index = pBuffer->open[d];
+            if(index == uint32_t(-1)) continue;
+
+            pBuffer->Events[keep] = pBuffer->Events[index];
+            index = keep++;
+        }
+
+        pBuffer->Events.resize(keep);
+        pBuffer->dropped = false;
+    }
+}
@@ -0,0 +1,13 @@
+#include "IronClad/Utils/Timer.hpp"
+#include "IronClad/Utils/Profiler.hpp"
+
+using namespace ic;
+using util::CTimer;
+
+// Taken when the library is loaded.
+static const uint64_t s_start = util::CProfiler::GetTime();
+
+double CTimer::GetTimeElapsed()
+{
+    return (util::CProfiler::GetTime() - s_start) / 1000000.0;
+}